@@ -23,20 +23,80 @@ pub fn buildExe(
     target: Build.ResolvedTarget,
     mode: std.builtin.OptimizeMode,
     comptime prefix_path: []const u8,
+) *Build.Step.Compile {
+    const dir = prefix_path ++ "src/shdc/";
+    const flags = common_cpp_flags ++ spvcross_public_cpp_flags ++ tint_public_cpp_flags;
+    const lib = libShdc(b, target, mode, prefix_path);
+
+    const mod = b.createModule(.{
+        .target = target,
+        .optimize = mode,
+        .link_libc = true,
+        .link_libcpp = true,
+    });
+    mod.linkLibrary(lib);
+    inline for (shdc_incl_dirs) |incl_dir| {
+        mod.addIncludePath(b.path(prefix_path ++ incl_dir));
+    }
+    mod.addCSourceFile(.{ .file = b.path(dir ++ "main.cc"), .flags = &flags });
+
+    const exe = b.addExecutable(.{ .name = "sokol-shdc", .root_module = mod });
+    b.installArtifact(exe);
+    return exe;
+}
+
+const shdc_incl_dirs = [_][]const u8{
+    "src/shdc",
+    "ext/fmt/include",
+    "ext/SPIRV-Cross",
+    "ext/pystring",
+    "ext/getopt/include",
+    "ext/glslang",
+    "ext/glslang/glslang/Public",
+    "ext/glslang/glslang/Include",
+    "ext/glslang/SPIRV",
+    "ext/SPIRV-Tools/include",
+    "ext/tint-extract/include",
+    "ext/tint-extract",
+};
+
+// the compiler pipeline and code generators as library (see src/shdc/libshdc.h)
+pub fn libShdc(
+    b: *Build,
+    target: Build.ResolvedTarget,
+    mode: std.builtin.OptimizeMode,
+    comptime prefix_path: []const u8,
 ) *Build.Step.Compile {
     const dir = prefix_path ++ "src/shdc/";
     const sources = [_][]const u8{
+        "analysis.cc",
         "args.cc",
+        "budget.cc",
         "bytecode.cc",
+        "cache.cc",
+        "http.cc",
         "input.cc",
-        "main.cc",
+        "json.cc",
+        "libshdc.cc",
+        "lsp.cc",
+        "perflint.cc",
+        "pipeline.cc",
         "reflection.cc",
+        "schedule.cc",
+        "serialize.cc",
+        "socket.cc",
         "spirv.cc",
         "spirvcross.cc",
+        "spvmodule.cc",
         "util.cc",
+        "varyings.cc",
+        "vfs.cc",
+        "worker.cc",
         "generators/bare.cc",
         "generators/generate.cc",
         "generators/generator.cc",
+        "generators/pack.cc",
+        "generators/sink.cc",
         "generators/sokolc.cc",
         "generators/sokold.cc",
         "generators/sokolnim.cc",
@@ -48,20 +108,6 @@ pub fn buildExe(
         "generators/sokolzig.cc",
         "generators/yaml.cc",
     };
-    const incl_dirs = [_][]const u8{
-        "src/shdc",
-        "ext/fmt/include",
-        "ext/SPIRV-Cross",
-        "ext/pystring",
-        "ext/getopt/include",
-        "ext/glslang",
-        "ext/glslang/glslang/Public",
-        "ext/glslang/glslang/Include",
-        "ext/glslang/SPIRV",
-        "ext/SPIRV-Tools/include",
-        "ext/tint-extract/include",
-        "ext/tint-extract",
-    };
     const flags = common_cpp_flags ++ spvcross_public_cpp_flags ++ tint_public_cpp_flags;
 
     const mod = b.createModule(.{
@@ -77,16 +123,20 @@ pub fn buildExe(
     mod.linkLibrary(libSpirvtools(b, target, mode, prefix_path));
     mod.linkLibrary(libGlslang(b, target, mode, prefix_path));
     mod.linkLibrary(libTint(b, target, mode, prefix_path));
-    inline for (incl_dirs) |incl_dir| {
+    if (target.result.os.tag == .windows) {
+        // sockets for the remote cache and compile workers
+        mod.linkSystemLibrary("ws2_32", .{});
+    }
+    inline for (shdc_incl_dirs) |incl_dir| {
         mod.addIncludePath(b.path(prefix_path ++ incl_dir));
     }
     inline for (sources) |src| {
         mod.addCSourceFile(.{ .file = b.path(dir ++ src), .flags = &flags });
     }
 
-    const exe = b.addExecutable(.{ .name = "sokol-shdc", .root_module = mod });
-    b.installArtifact(exe);
-    return exe;
+    const lib = b.addLibrary(.{ .name = "shdc", .root_module = mod });
+    b.installArtifact(lib);
+    return lib;
 }
 
 fn libGetopt(
@@ -50,15 +50,12 @@ export function build(b: Builder): void {
         }
     }
 
-    // sokol-shdc executable
-    b.addTarget('sokol-shdc', 'plain-exe', (t) => {
+    // libshdc: the compiler pipeline and code generators as library (see src/shdc/libshdc.h)
+    b.addTarget('libshdc', 'lib', (t) => {
         t.setDir('src/shdc');
-        t.addSources(sokol_shdc_sources);
+        t.addSources(libshdc_sources);
         t.addIncludeDirectories(['.']);
         t.addDependencies(['fmt', 'getopt', 'pystring', 'glslang', 'SPIRV-Cross', 'tint']);
-        if (b.isLinux()) {
-            t.addLinkOptions(['-static']);
-        }
         if (b.isGcc() || b.isClang()) {
             t.addCompileOptions(['-Wno-unused-result', '-Wno-unused-parameter']);
         }
@@ -70,6 +67,20 @@ export function build(b: Builder): void {
         }
     });
 
+    // sokol-shdc executable
+    b.addTarget('sokol-shdc', 'plain-exe', (t) => {
+        t.setDir('src/shdc');
+        t.addSources(['main.cc']);
+        t.addIncludeDirectories(['.']);
+        t.addDependencies(['libshdc']);
+        if (b.isLinux()) {
+            t.addLinkOptions(['-static']);
+        }
+        if (b.isGcc() || b.isClang()) {
+            t.addCompileOptions(['-Wno-unused-result', '-Wno-unused-parameter']);
+        }
+    });
+
     // external libs
     b.addTarget('getopt', 'lib', (t) => {
         t.setDir('ext/getopt');
@@ -323,28 +334,63 @@ const test_shaders = [
     'sapp/write-storageimage-sapp.glsl',
 ];
 
-const sokol_shdc_sources = [
+const libshdc_sources = [
+    'analysis.cc',
+    'analysis.h',
     'args.cc',
     'args.h',
+    'budget.cc',
+    'budget.h',
     'bytecode.cc',
     'bytecode.h',
+    'cache.cc',
+    'cache.h',
+    'http.cc',
+    'http.h',
     'input.cc',
     'input.h',
-    'main.cc',
+    'json.cc',
+    'json.h',
+    'libshdc.cc',
+    'libshdc.h',
+    'lsp.cc',
+    'lsp.h',
+    'perflint.cc',
+    'perflint.h',
+    'pipeline.cc',
+    'pipeline.h',
     'reflection.cc',
     'reflection.h',
+    'schedule.cc',
+    'schedule.h',
+    'serialize.cc',
+    'serialize.h',
+    'socket.cc',
+    'socket.h',
     'spirv.cc',
     'spirv.h',
     'spirvcross.cc',
     'spirvcross.h',
+    'spvmodule.cc',
+    'spvmodule.h',
     'util.cc',
     'util.h',
+    'varyings.cc',
+    'varyings.h',
+    'vfs.cc',
+    'vfs.h',
+    'worker.cc',
+    'worker.h',
     'generators/bare.cc',
     'generators/bare.h',
     'generators/generate.cc',
     'generators/generate.h',
     'generators/generator.cc',
     'generators/generator.h',
+    'generators/pack.cc',
+    'generators/pack.h',
+    'generators/sink.cc',
+    'generators/sink.h',
     'generators/sokolc.cc',
     'generators/sokolc.h',
     'generators/sokolc2.cc',
@@ -380,6 +426,7 @@ const sokol_shdc_sources = [
     'types/reflection/texture.h',
     'types/reflection/type.h',
     'types/reflection/uniform_block.h',
+    'types/array_encoding.h',
     'types/bind_slot_map.h',
     'types/bindslot.h',
     'types/bytecode_blob.h',
@@ -389,9 +436,11 @@ const sokol_shdc_sources = [
     'types/gen_input.h',
     'types/image_sample_type_tag.h',
     'types/line.h',
+    'types/lint_ignore_tag.h',
     'types/option.h',
     'types/program.h',
     'types/sampler_type_tag.h',
+    'types/shader_cost.h',
     'types/shader_stage.h',
     'types/slang.h',
     'types/snippet.h',
@@ -0,0 +1,90 @@
+'''
+    Benchmark the --array-encoding options of sokol-shdc: measures the
+    code generation time (without the shader compilers, as printed by
+    sokol-shdc with --dump) and throughput, the size of the generated
+    header, and the time it takes a C compiler to compile a source file
+    which includes the generated header.
+
+    The generator throughput only becomes meaningful with big shader
+    arrays, so use an input with large shaders and/or --bytecode.
+
+    Usage:
+
+    python3 bench-array-encodings.py [sokol-shdc] [input.glsl] [slang] [cc] [sokol dir]
+
+    For instance:
+
+    python3 bench-array-encodings.py ./sokol-shdc ../test/texcube-sapp.glsl hlsl5:metal_macos:glsl430 clang ../../sokol
+
+    ...where [sokol dir] is the directory containing sokol_gfx.h.
+
+    The 'embed' encoding requires a C compiler with #embed support
+    (e.g. clang 19 or later with -std=c23).
+
+    NOTE: run with python3
+'''
+import os
+import re
+import subprocess
+import sys
+import tempfile
+import time
+
+NUM_RUNS = 10
+ENCODINGS = [ 'hex', 'string', 'embed' ]
+
+# run a command NUM_RUNS times and return the best wall clock time in seconds
+def best_time(cmd):
+    best = None
+    for _ in range(NUM_RUNS):
+        start = time.perf_counter()
+        subprocess.run(cmd, check=True)
+        duration = time.perf_counter() - start
+        if best is None or duration < best:
+            best = duration
+    return best
+
+# run sokol-shdc NUM_RUNS times with --dump and return the best code generation time in seconds
+def best_gen_time(cmd):
+    best = None
+    for _ in range(NUM_RUNS):
+        res = subprocess.run([*cmd, '--dump'], check=True, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, text=True)
+        match = re.search(r'code generation: ([0-9.]+) ms', res.stderr)
+        if match is None:
+            print('sokol-shdc did not print the code generation time')
+            sys.exit(10)
+        duration = float(match.group(1)) / 1000.0
+        if best is None or duration < best:
+            best = duration
+    return best
+
+def main():
+    if len(sys.argv) != 6:
+        print(__doc__)
+        sys.exit(10)
+    shdc, input_path, slang, cc, sokol_dir = sys.argv[1:]
+    with tempfile.TemporaryDirectory() as tmpdir:
+        print(f'{"encoding":<10} {"gen (ms)":>10} {"gen (MB/s)":>11} {"header (bytes)":>15} {"cc (ms)":>10}')
+        for encoding in ENCODINGS:
+            header_path = os.path.join(tmpdir, f'shader_{encoding}.h')
+            source_path = os.path.join(tmpdir, f'main_{encoding}.c')
+            with open(source_path, 'w') as f:
+                f.write('#include <stdint.h>\n')
+                f.write('#include <stdbool.h>\n')
+                f.write('#include "sokol_gfx.h"\n')
+                f.write(f'#include "{os.path.basename(header_path)}"\n')
+            shdc_cmd = [ shdc, '-i', input_path, '-o', header_path, '-l', slang, '-f', 'sokol_impl', f'--array-encoding={encoding}' ]
+            gen_time = best_gen_time(shdc_cmd)
+            header_size = os.path.getsize(header_path)
+            # throughput in generated bytes per second
+            gen_mbs = header_size / max(gen_time, 1e-9) / (1024.0 * 1024.0)
+            cc_cmd = [ cc, '-std=c23', '-fsyntax-only', '-DSOKOL_SHDC_IMPL', '-I', tmpdir, '-I', sokol_dir, source_path ]
+            try:
+                cc_time = best_time(cc_cmd)
+                cc_str = f'{cc_time * 1000.0:>10.1f}'
+            except subprocess.CalledProcessError:
+                cc_str = f'{"failed":>10}'
+            print(f'{encoding:<10} {gen_time * 1000.0:>10.3f} {gen_mbs:>11.1f} {header_size:>15} {cc_str}')
+
+if __name__ == '__main__':
+    main()
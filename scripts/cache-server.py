@@ -0,0 +1,102 @@
+'''
+    Minimal stand-in for a bazel-remote style HTTP cache server, for testing
+    the --remote-cache option of sokol-shdc offline.
+
+    Supports GET and PUT of /[prefix/]ac/[key] and /[prefix/]cas/[key], entries
+    are kept in memory. GET /stats returns hit/miss/put counters as JSON.
+
+    Usage:
+
+    python3 cache-server.py [--port 9090] [--delay ms] [--status code]
+
+    --delay delays each response (to test the --remote-cache-timeout option),
+    --status answers all cache requests with an HTTP error status.
+
+    NOTE: run with python3
+'''
+import argparse
+import json
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+entries = {}
+stats = { 'hits': 0, 'misses': 0, 'puts': 0 }
+lock = threading.Lock()
+options = None
+
+def entry_key(path):
+    # accept an optional path prefix in front of /ac/ or /cas/
+    parts = path.strip('/').split('/')
+    if len(parts) >= 2 and parts[-2] in ('ac', 'cas'):
+        return '/'.join(parts[-2:])
+    return None
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+
+    def reply(self, status, body=b''):
+        self.send_response(status)
+        self.send_header('Content-Type', 'application/octet-stream')
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def delay(self):
+        if options.delay > 0:
+            time.sleep(options.delay / 1000.0)
+
+    def do_GET(self):
+        if self.path == '/stats':
+            with lock:
+                self.reply(200, json.dumps(stats).encode())
+            return
+        self.delay()
+        key = entry_key(self.path)
+        if options.status:
+            self.reply(options.status)
+        elif key is None:
+            self.reply(400)
+        else:
+            with lock:
+                data = entries.get(key)
+                stats['hits' if data is not None else 'misses'] += 1
+            if data is None:
+                self.reply(404)
+            else:
+                self.reply(200, data)
+
+    def do_PUT(self):
+        length = int(self.headers.get('Content-Length', 0))
+        data = self.rfile.read(length)
+        self.delay()
+        key = entry_key(self.path)
+        if options.status:
+            self.reply(options.status)
+        elif key is None:
+            self.reply(400)
+        else:
+            with lock:
+                entries[key] = data
+                stats['puts'] += 1
+            self.reply(200)
+
+    def log_message(self, format, *args):
+        pass
+
+def main():
+    global options
+    parser = argparse.ArgumentParser(description='stand-in remote cache server for sokol-shdc')
+    parser.add_argument('--port', type=int, default=9090)
+    parser.add_argument('--delay', type=int, default=0, help='response delay in milliseconds')
+    parser.add_argument('--status', type=int, default=0, help='answer all cache requests with this HTTP status')
+    options = parser.parse_args()
+    server = ThreadingHTTPServer(('127.0.0.1', options.port), Handler)
+    print(f'cache-server.py: listening on http://127.0.0.1:{options.port}', flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+if __name__ == '__main__':
+    main()
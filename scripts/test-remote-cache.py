@@ -0,0 +1,132 @@
+'''
+    Offline test of the --cache-dir and --remote-cache options of sokol-shdc,
+    runs against the stand-in server in cache-server.py.
+
+    Usage:
+
+    python3 test-remote-cache.py [sokol-shdc] [input.glsl...]
+
+    For instance:
+
+    python3 test-remote-cache.py ./sokol-shdc ../test/sapp/triangle-sapp.glsl ../test/sapp/texcube-sapp.glsl
+
+    Checks that:
+        - a second run with an empty local cache directory gets its results
+          from the remote cache and generates identical output
+        - with -b, the bytecode of each shader is cached next to its SPIRV
+          (spirv_vk everywhere, plus Metal on macOS and HLSL on Windows)
+        - an unreachable, slow or failing remote cache doesn't fail compilation
+
+    NOTE: run with python3
+'''
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+import urllib.request
+
+PORT = 9091
+SLANG = 'glsl430:hlsl5:metal_macos:wgsl:spirv_vk'
+# shader languages with a bytecode compiler on this platform
+BYTECODE_SLANGS = ['spirv_vk'] + (['metal_macos'] if sys.platform == 'darwin' else []) + (['hlsl5'] if sys.platform == 'win32' else [])
+
+def start_server(*extra_args):
+    script = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'cache-server.py')
+    proc = subprocess.Popen([sys.executable, script, '--port', str(PORT), *extra_args], stdout=subprocess.PIPE)
+    # wait for the listening message
+    proc.stdout.readline()
+    return proc
+
+def stats():
+    with urllib.request.urlopen(f'http://127.0.0.1:{PORT}/stats') as resp:
+        return json.loads(resp.read())
+
+def compile_all(shdc, inputs, out_dir, extra_args, slang=SLANG):
+    outputs = {}
+    start = time.perf_counter()
+    for path in inputs:
+        out_path = os.path.join(out_dir, os.path.basename(path) + '.h')
+        subprocess.run([shdc, '-i', path, '-o', out_path, '-l', slang, '--no-log-cmdline', *extra_args], check=True)
+        with open(out_path, 'rb') as f:
+            outputs[path] = f.read()
+    return outputs, time.perf_counter() - start
+
+def check(cond, msg):
+    if not cond:
+        print(f'FAILED: {msg}')
+        sys.exit(10)
+    print(f'ok: {msg}')
+
+def main():
+    if len(sys.argv) < 3:
+        print(__doc__)
+        sys.exit(10)
+    shdc = sys.argv[1]
+    inputs = sys.argv[2:]
+    url = f'http://127.0.0.1:{PORT}'
+    with tempfile.TemporaryDirectory() as tmp:
+        out_dir = os.path.join(tmp, 'out')
+        os.makedirs(out_dir)
+        reference, _ = compile_all(shdc, inputs, out_dir, [])
+
+        server = start_server()
+        try:
+            first, t0 = compile_all(shdc, inputs, out_dir, ['--cache-dir', os.path.join(tmp, 'cache-a'), '--remote-cache', url])
+            s0 = stats()
+            check(first == reference, 'output with cold caches matches output without cache')
+            check(s0['puts'] > 0, f'results were uploaded to the remote cache ({s0["puts"]} puts)')
+
+            second, t1 = compile_all(shdc, inputs, out_dir, ['--cache-dir', os.path.join(tmp, 'cache-b'), '--remote-cache', url])
+            s1 = stats()
+            check(second == reference, 'output from remote cache hits matches output without cache')
+            check(s1['hits'] > s0['hits'], f'second run was served by the remote cache ({s1["hits"] - s0["hits"]} hits)')
+
+            third, t2 = compile_all(shdc, inputs, out_dir, ['--cache-dir', os.path.join(tmp, 'cache-b'), '--remote-cache', url])
+            s2 = stats()
+            check(third == reference and s2['hits'] == s1['hits'], 'third run was served by the local cache')
+            print(f'timings: cold {t0:.3f}s, remote {t1:.3f}s, local {t2:.3f}s')
+        finally:
+            server.terminate()
+            server.wait()
+
+        # bytecode, one SPIRV and one bytecode entry per snippet and shader language
+        bytecode_slang = ':'.join(BYTECODE_SLANGS)
+        bytecode_reference, _ = compile_all(shdc, inputs, out_dir, ['-b'], bytecode_slang)
+        server = start_server()
+        try:
+            compile_all(shdc, inputs, out_dir, ['--remote-cache', url], 'glsl430')
+            s0 = stats()
+            num_spirv = s0['puts']
+            first, _ = compile_all(shdc, inputs, out_dir, ['-b', '--cache-dir', os.path.join(tmp, 'cache-c'), '--remote-cache', url], bytecode_slang)
+            s1 = stats()
+            num_puts = s1['puts'] - s0['puts']
+            check(first == bytecode_reference, 'bytecode output with cold caches matches output without cache')
+            check(num_puts == 2 * num_spirv * len(BYTECODE_SLANGS), f'SPIRV and bytecode were uploaded to the remote cache ({num_puts} puts, {num_spirv} snippets)')
+            shutil.rmtree(os.path.join(tmp, 'cache-c'))
+            second, _ = compile_all(shdc, inputs, out_dir, ['-b', '--cache-dir', os.path.join(tmp, 'cache-c'), '--remote-cache', url], bytecode_slang)
+            s2 = stats()
+            check(second == bytecode_reference, 'bytecode output from remote cache hits matches output without cache')
+            check((s2['hits'] - s1['hits'] == num_puts) and (s2['puts'] == s1['puts']), f'SPIRV and bytecode were served by the remote cache ({s2["hits"] - s1["hits"]} hits)')
+        finally:
+            server.terminate()
+            server.wait()
+
+        # nobody listening on the port
+        out, _ = compile_all(shdc, inputs, out_dir, ['--remote-cache', url])
+        check(out == reference, 'unreachable remote cache falls back to local compilation')
+
+        # a server which answers too slowly, or only with errors
+        for extra_args, msg in [ (['--delay', '500'], 'slow'), (['--status', '503'], 'failing') ]:
+            server = start_server(*extra_args)
+            try:
+                out, _ = compile_all(shdc, inputs, out_dir, ['--remote-cache', url, '--remote-cache-timeout', '100'])
+                check(out == reference, f'{msg} remote cache falls back to local compilation')
+            finally:
+                server.terminate()
+                server.wait()
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,144 @@
+'''
+    Test of distributed compilation with several local sokol-shdc --worker
+    processes (see the --worker and --workers options).
+
+    Usage:
+
+    python3 test-workers.py [sokol-shdc] [input.glsl...]
+
+    For instance:
+
+    python3 test-workers.py ./sokol-shdc ../test/sapp/triangle-sapp.glsl ../test/sapp/texcube-sapp.glsl
+
+    Checks that the output with workers is identical to a local compilation:
+        - with all workers running
+        - with two coordinators sharing the same workers at the same time
+        - with an unreachable worker, and a worker which drops the
+          connection in the middle of a job (like a crashing worker)
+        - with more unreachable workers than job attempts, which must not
+          push jobs back to local compilation
+        - with no reachable worker at all
+        - with --trace and a cache directory (which stores the job timings)
+
+    NOTE: run with python3
+'''
+import os
+import re
+import shutil
+import socket
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+FIRST_PORT = 9101
+NUM_WORKERS = 3
+SLANG = 'glsl430:hlsl5:metal_macos:wgsl:spirv_vk'
+
+def start_worker(shdc, port):
+    proc = subprocess.Popen([shdc, '--worker', str(port)], stderr=subprocess.PIPE, text=True)
+    # wait for the listening message
+    proc.stderr.readline()
+    return proc
+
+def start_dropping_worker(port):
+    # accepts connections and closes them after receiving the start of a job
+    server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind(('127.0.0.1', port))
+    server.listen()
+    def serve():
+        while True:
+            try:
+                conn, _ = server.accept()
+            except OSError:
+                return
+            conn.recv(4)
+            conn.close()
+    threading.Thread(target=serve, daemon=True).start()
+    return server
+
+def compile_all(shdc, inputs, out_dir, extra_args):
+    outputs = {}
+    messages = ''
+    start = time.perf_counter()
+    for path in inputs:
+        out_path = os.path.join(out_dir, os.path.basename(path) + '.h')
+        res = subprocess.run([shdc, '-i', path, '-o', out_path, '-l', SLANG, '--no-log-cmdline', *extra_args], check=True, stderr=subprocess.PIPE, text=True)
+        messages += res.stderr
+        with open(out_path, 'rb') as f:
+            outputs[path] = f.read()
+    return outputs, messages, time.perf_counter() - start
+
+def check(cond, msg):
+    if not cond:
+        print(f'FAILED: {msg}')
+        sys.exit(10)
+    print(f'ok: {msg}')
+
+def main():
+    if len(sys.argv) < 3:
+        print(__doc__)
+        sys.exit(10)
+    shdc = sys.argv[1]
+    inputs = sys.argv[2:]
+    ports = [FIRST_PORT + i for i in range(NUM_WORKERS)]
+    addrs = [f'127.0.0.1:{port}' for port in ports]
+    unreachable = f'127.0.0.1:{FIRST_PORT + NUM_WORKERS}'
+    dropping_port = FIRST_PORT + NUM_WORKERS + 1
+    with tempfile.TemporaryDirectory() as tmp:
+        reference, _, t_local = compile_all(shdc, inputs, tmp, [])
+        workers = [start_worker(shdc, port) for port in ports]
+        dropping = start_dropping_worker(dropping_port)
+        try:
+            out, _, t_workers = compile_all(shdc, inputs, tmp, ['--workers', ','.join(addrs)])
+            check(out == reference, f'output with {NUM_WORKERS} workers matches local compilation')
+
+            # two coordinators at the same time, like a parallel build
+            parallel = [None, None]
+            def run_parallel(i):
+                out_dir = os.path.join(tmp, f'parallel{i}')
+                os.makedirs(out_dir)
+                parallel[i] = compile_all(shdc, inputs, out_dir, ['--workers', ','.join(addrs)])
+            threads = [threading.Thread(target=run_parallel, args=(i,)) for i in range(2)]
+            for thread in threads:
+                thread.start()
+            for thread in threads:
+                thread.join()
+            check(all(p is not None and p[0] == reference for p in parallel), 'output of two parallel coordinators matches local compilation')
+            check(all('lost worker' not in p[1] for p in parallel if p is not None), 'busy workers were not lost by parallel coordinators')
+
+            unreachables = [f'127.0.0.1:{FIRST_PORT + NUM_WORKERS + 2 + i}' for i in range(3)]
+            out, messages, _ = compile_all(shdc, inputs, tmp, ['--workers', ','.join(unreachables + addrs), '--trace'])
+            check(out == reference, 'output with several unreachable workers matches local compilation')
+            check(' on -' not in messages, 'unreachable workers did not use up job attempts')
+
+            lossy = [unreachable, f'127.0.0.1:{dropping_port}'] + addrs
+            out, messages, _ = compile_all(shdc, inputs, tmp, ['--workers', ','.join(lossy)])
+            check(out == reference, 'output with lost workers matches local compilation')
+            check('lost worker' in messages, 'lost workers were reported')
+
+            cache_dir = os.path.join(tmp, 'cache')
+            for run in ['first', 'second']:
+                out, messages, _ = compile_all(shdc, inputs, tmp, ['--workers', ','.join(addrs), '--cache-dir', cache_dir, '--trace'])
+                check(out == reference, f'output of {run} traced run matches local compilation')
+                check('makespan' in messages, f'{run} traced run printed the makespan')
+                check(os.path.exists(os.path.join(cache_dir, 'timings.json')), 'job timings were stored in the cache directory')
+                # drop the cached results but keep the timings, so that the jobs run again
+                for entry in os.listdir(cache_dir):
+                    if entry != 'timings.json':
+                        shutil.rmtree(os.path.join(cache_dir, entry))
+            check(re.search(r'jobs on \d+ workers \([1-9]\d* with timing history\)', messages) is not None, 'second traced run used the timing history')
+        finally:
+            dropping.close()
+            for worker in workers:
+                worker.kill()
+                worker.wait()
+
+        out, _, _ = compile_all(shdc, inputs, tmp, ['--workers', ','.join(addrs)])
+        check(out == reference, 'output without any reachable worker matches local compilation')
+        print(f'timings: local {t_local:.3f}s, {NUM_WORKERS} workers {t_workers:.3f}s')
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,468 @@
+/*
+    static shader cost analysis on the optimized SPIRV
+*/
+#include <map>
+#include <set>
+#include <algorithm>
+#include "analysis.h"
+#include "spvmodule.h"
+#include "util.h"
+#include "pystring.h"
+#include "fmt/format.h"
+#include "GLSL.std.450.h"
+
+namespace shdc {
+
+static bool is_alu(spv::Op op) {
+    return ((op >= spv::OpConvertFToU) && (op <= spv::OpBitcast)) ||
+           ((op >= spv::OpSNegate) && (op <= spv::OpBitCount)) ||
+           ((op >= spv::OpDPdx) && (op <= spv::OpFwidthCoarse));
+}
+
+static bool is_texture_sample(spv::Op op) {
+    return ((op >= spv::OpImageSampleImplicitLod) && (op <= spv::OpImageDrefGather)) ||
+           ((op >= spv::OpImageSparseSampleImplicitLod) && (op <= spv::OpImageSparseDrefGather));
+}
+
+static bool is_transcendental(uint32_t glsl_std_450_inst) {
+    return ((glsl_std_450_inst >= GLSLstd450Sin) && (glsl_std_450_inst <= GLSLstd450InverseSqrt));
+}
+
+static bool is_discard(spv::Op op) {
+    return (op == spv::OpKill) || (op == spv::OpTerminateInvocation) || (op == spv::OpDemoteToHelperInvocationEXT);
+}
+
+// number of scalar values in a numeric type (0 for non-numeric types)
+static int num_scalars(const SpvModule& mod, const std::map<uint32_t,int>& type_map, uint32_t type_id) {
+    const auto it = type_map.find(type_id);
+    if (it == type_map.end()) {
+        return 0;
+    }
+    const SpvInst& type = mod.insts[it->second];
+    switch (type.op) {
+        case spv::OpTypeBool:
+            return 1;
+        case spv::OpTypeInt:
+        case spv::OpTypeFloat:
+            return (type.operand(1) > 32) ? 2 : 1;
+        case spv::OpTypeVector:
+        case spv::OpTypeMatrix:
+            return num_scalars(mod, type_map, type.operand(1)) * (int)type.operand(2);
+        default:
+            return 0;
+    }
+}
+
+// approximate size in bytes of a type (without any layout padding)
+static int type_size(const SpvModule& mod, const std::map<uint32_t,int>& type_map, const std::map<uint32_t,uint32_t>& const_map, uint32_t type_id) {
+    const auto it = type_map.find(type_id);
+    if (it == type_map.end()) {
+        return 0;
+    }
+    const SpvInst& type = mod.insts[it->second];
+    switch (type.op) {
+        case spv::OpTypeBool:
+            return 4;
+        case spv::OpTypeInt:
+        case spv::OpTypeFloat:
+            return (int)type.operand(1) / 8;
+        case spv::OpTypeVector:
+        case spv::OpTypeMatrix:
+            return type_size(mod, type_map, const_map, type.operand(1)) * (int)type.operand(2);
+        case spv::OpTypeArray: {
+            const auto len_it = const_map.find(type.operand(2));
+            const int len = (len_it == const_map.end()) ? 1 : (int)len_it->second;
+            return type_size(mod, type_map, const_map, type.operand(1)) * len;
+        }
+        case spv::OpTypeStruct: {
+            int size = 0;
+            for (size_t i = 1; i < type.num_operands(); i++) {
+                size += type_size(mod, type_map, const_map, type.operand(i));
+            }
+            return size;
+        }
+        default:
+            return 0;
+    }
+}
+
+ShaderCost Analysis::analyze_spirv(const std::vector<uint32_t>& bytecode, std::map<int,ShaderCost>* out_line_costs) {
+    ShaderCost cost;
+    cost.spirv_bytes = (int)(bytecode.size() * sizeof(uint32_t));
+    const SpvModule mod = SpvModule::parse(bytecode);
+    if (!mod.valid) {
+        return cost;
+    }
+    const int first_func = mod.first_function();
+
+    // gather global declarations
+    std::map<uint32_t,int> type_map;            // type id => instruction index
+    std::map<uint32_t,uint32_t> const_map;      // scalar constant id => value
+    std::set<uint32_t> storage_ptrs;            // storage buffer variables and pointers derived from them
+    uint32_t glsl_std_450 = 0;
+    for (int i = 0; i < first_func; i++) {
+        const SpvInst& inst = mod.insts[i];
+        if ((inst.op >= spv::OpTypeVoid) && (inst.op <= spv::OpTypeFunction)) {
+            type_map[inst.operand(0)] = i;
+        } else if (inst.op == spv::OpConstant) {
+            const_map[inst.operand(1)] = inst.operand(2);
+        } else if ((inst.op == spv::OpExtInstImport) && (inst.string_operand(1) == "GLSL.std.450")) {
+            glsl_std_450 = inst.operand(0);
+        } else if (inst.op == spv::OpVariable) {
+            const uint32_t storage_class = inst.operand(2);
+            const auto ptr_it = type_map.find(inst.operand(0));
+            const uint32_t pointee = (ptr_it != type_map.end()) ? mod.insts[ptr_it->second].operand(2) : 0;
+            if ((storage_class == spv::StorageClassStorageBuffer) ||
+                ((storage_class == spv::StorageClassUniform) && mod.has_decoration(pointee, spv::DecorationBufferBlock)))
+            {
+                storage_ptrs.insert(inst.operand(1));
+            } else if (storage_class == spv::StorageClassWorkgroup) {
+                cost.shared_memory_bytes += type_size(mod, type_map, const_map, pointee);
+            }
+        }
+    }
+
+    // walk function bodies
+    std::set<uint32_t> tex_dependent;           // values (and local variables) computed from texture accesses
+    std::map<uint32_t,int> def_pos;             // value id => defining instruction index
+    std::map<uint32_t,int> def_scalars;         // value id => number of scalar components
+    std::map<uint32_t,int> last_use;            // value id => last using instruction index
+    ShaderCost* line_cost = nullptr;
+    const auto count = [&cost, &line_cost](int ShaderCost::* counter) {
+        cost.*counter += 1;
+        if (line_cost) {
+            line_cost->*counter += 1;
+        }
+    };
+    for (int i = first_func; i < (int)mod.insts.size(); i++) {
+        const SpvInst& inst = mod.insts[i];
+        const spv::Op op = inst.op;
+
+        // track source line debug info
+        if (op == spv::OpLine) {
+            line_cost = out_line_costs ? &(*out_line_costs)[(int)inst.operand(1)] : nullptr;
+            continue;
+        } else if ((op == spv::OpNoLine) || (op == spv::OpFunctionEnd)) {
+            line_cost = nullptr;
+            continue;
+        } else if (op == spv::OpLabel) {
+            continue;
+        }
+
+        // instruction mix
+        count(&ShaderCost::instructions);
+        if (is_alu(op)) {
+            count(&ShaderCost::alu_ops);
+        } else if ((op == spv::OpExtInst) && (inst.operand(2) == glsl_std_450)) {
+            if (is_transcendental(inst.operand(3))) {
+                count(&ShaderCost::transcendental_ops);
+            } else {
+                count(&ShaderCost::alu_ops);
+            }
+        } else if (is_texture_sample(op) || (op == spv::OpImageFetch)) {
+            count(&ShaderCost::texture_samples);
+            if (tex_dependent.count(inst.operand(3)) > 0) {
+                count(&ShaderCost::dependent_texture_reads);
+            }
+        } else if (op == spv::OpLoopMerge) {
+            count(&ShaderCost::loops);
+        } else if ((op == spv::OpBranchConditional) || (op == spv::OpSwitch)) {
+            count(&ShaderCost::branches);
+        } else if (is_discard(op)) {
+            count(&ShaderCost::discards);
+        } else if (op == spv::OpImageRead) {
+            count(&ShaderCost::storage_loads);
+        } else if (op == spv::OpImageWrite) {
+            count(&ShaderCost::storage_stores);
+        } else if (op == spv::OpLoad) {
+            if (storage_ptrs.count(inst.operand(2)) > 0) {
+                count(&ShaderCost::storage_loads);
+            }
+        } else if (op == spv::OpStore) {
+            if (storage_ptrs.count(inst.operand(0)) > 0) {
+                count(&ShaderCost::storage_stores);
+            }
+            if (tex_dependent.count(inst.operand(1)) > 0) {
+                tex_dependent.insert(inst.operand(0));
+            }
+        } else if ((op >= spv::OpAtomicLoad) && (op <= spv::OpAtomicXor)) {
+            if (storage_ptrs.count(inst.operand((op == spv::OpAtomicStore) ? 0 : 2)) > 0) {
+                count(&ShaderCost::storage_stores);
+            }
+        }
+
+        // texture-dependency and storage-pointer propagation, and live ranges
+        for (size_t oi = 0; oi < inst.num_operands(); oi++) {
+            const auto it = def_pos.find(inst.operand(oi));
+            if (it != def_pos.end()) {
+                last_use[it->first] = i;
+            }
+        }
+        if (inst.has_type_and_result()) {
+            const uint32_t result_id = inst.operand(1);
+            if ((op == spv::OpAccessChain) || (op == spv::OpInBoundsAccessChain)) {
+                if (storage_ptrs.count(inst.operand(2)) > 0) {
+                    storage_ptrs.insert(result_id);
+                }
+            }
+            if (is_texture_sample(op) || (op == spv::OpImageFetch) || (op == spv::OpImageRead)) {
+                tex_dependent.insert(result_id);
+            } else {
+                for (size_t oi = 2; oi < inst.num_operands(); oi++) {
+                    if (tex_dependent.count(inst.operand(oi)) > 0) {
+                        tex_dependent.insert(result_id);
+                        break;
+                    }
+                }
+            }
+            const int scalars = num_scalars(mod, type_map, inst.operand(0));
+            if (scalars > 0) {
+                def_pos[result_id] = i;
+                def_scalars[result_id] = scalars;
+                last_use[result_id] = i;
+            }
+        }
+    }
+
+    // peak number of simultaneously live scalar values, assuming straight-line code
+    std::vector<int> delta(mod.insts.size() + 1, 0);
+    for (const auto& item: def_pos) {
+        const int start = item.second;
+        const int end = std::max(start, last_use[item.first]);
+        delta[start] += def_scalars[item.first];
+        delta[end + 1] -= def_scalars[item.first];
+    }
+    int live = 0;
+    for (int d: delta) {
+        live += d;
+        cost.live_values = std::max(cost.live_values, live);
+    }
+    return cost;
+}
+
+Analysis Analysis::build(const Args& args,
+                         const Input& inp,
+                         const std::array<Spirv,Slang::Num>& spirv,
+                         const std::array<Spirvcross,Slang::Num>& spirvcross,
+                         const std::array<Bytecode,Slang::Num>& bytecode)
+{
+    Analysis res;
+    // the instruction mix is taken from the SPIRV of the first shader language, only
+    // the generated source and bytecode sizes are reported for each shader language
+    const Slang::Enum first_slang = Slang::first_valid(args.slang);
+    for (const SpirvBlob& blob: spirv[first_slang].blobs) {
+        ShaderCost cost = analyze_spirv(blob.bytecode);
+        cost.snippet_index = blob.snippet_index;
+        for (int i = 0; i < Slang::Num; i++) {
+            const Slang::Enum slang = Slang::from_index(i);
+            if (args.slang & Slang::bit(slang)) {
+                const SpirvcrossSource* src = spirvcross[i].find_source_by_snippet_index(blob.snippet_index);
+                if (src) {
+                    cost.slang_sizes[i].source_bytes = (int)src->source_code.size();
+                }
+                const BytecodeBlob* bc = bytecode[i].find_blob_by_snippet_index(blob.snippet_index);
+                if (bc) {
+                    cost.slang_sizes[i].bytecode_bytes = (int)bc->data.size();
+                }
+            }
+        }
+        res.costs.push_back(cost);
+    }
+    return res;
+}
+
+// NOTE: debug_spirv must have been compiled with line debug info
+void Analysis::build_heatmap(const Input& inp, const Spirv& debug_spirv) {
+    line_costs.clear();
+    for (const SpirvBlob& blob: debug_spirv.blobs) {
+        const Snippet& snippet = inp.snippets[blob.snippet_index];
+        std::map<int,ShaderCost> src_line_costs;
+        analyze_spirv(blob.bytecode, &src_line_costs);
+        std::vector<LineCost>& snippet_line_costs = line_costs[blob.snippet_index];
+        for (const auto& item: src_line_costs) {
+            // OpLine numbers are 1-based and include the injected #version and #define lines
+            const int snippet_line_index = item.first - 1 - blob.linenr_offset;
+            if ((snippet_line_index >= 0) && (snippet_line_index < (int)snippet.lines.size())) {
+                LineCost line_cost;
+                line_cost.line_index = snippet.lines[snippet_line_index];
+                line_cost.cost = item.second;
+                line_cost.cost.snippet_index = blob.snippet_index;
+                snippet_line_costs.push_back(line_cost);
+            }
+        }
+    }
+}
+
+const ShaderCost* Analysis::find_cost_by_snippet_index(int snippet_index) const {
+    for (const ShaderCost& cost: costs) {
+        if (cost.snippet_index == snippet_index) {
+            return &cost;
+        }
+    }
+    return nullptr;
+}
+
+ErrMsg Analysis::write_json(const Args& args, const Input& inp) const {
+    std::string content = "{\n";
+    content += fmt::format("  \"input\": {},\n", util::json_string(inp.base_path));
+    content += fmt::format("  \"module\": {},\n", util::json_string(inp.module));
+    content += "  \"programs\": [\n";
+    size_t prog_index = 0;
+    for (const auto& item: inp.programs) {
+        const Program& prog = item.second;
+        content += fmt::format("    {{ \"name\": {}, \"vs\": {}, \"fs\": {}, \"cs\": {} }}{}\n",
+            util::json_string(prog.name),
+            util::json_string(prog.vs_name),
+            util::json_string(prog.fs_name),
+            util::json_string(prog.cs_name),
+            (++prog_index < inp.programs.size()) ? "," : "");
+    }
+    content += "  ],\n";
+    content += "  \"shaders\": [\n";
+    for (size_t ci = 0; ci < costs.size(); ci++) {
+        const ShaderCost& cost = costs[ci];
+        const Snippet& snippet = inp.snippets[cost.snippet_index];
+        const Line& line = inp.lines[util::first_snippet_line_index_skipping_include_blocks(inp, snippet)];
+        content += "    {\n";
+        content += fmt::format("      \"name\": {},\n", util::json_string(snippet.name));
+        content += fmt::format("      \"stage\": \"{}\",\n", Snippet::type_to_str(snippet.type));
+        content += fmt::format("      \"file\": {},\n", util::json_string(inp.filenames[line.filename]));
+        content += fmt::format("      \"line\": {},\n", line.index + 1);
+        content += fmt::format("      \"spirv_bytes\": {},\n", cost.spirv_bytes);
+        content += fmt::format("      \"instructions\": {},\n", cost.instructions);
+        content += fmt::format("      \"alu_ops\": {},\n", cost.alu_ops);
+        content += fmt::format("      \"transcendental_ops\": {},\n", cost.transcendental_ops);
+        content += fmt::format("      \"texture_samples\": {},\n", cost.texture_samples);
+        content += fmt::format("      \"dependent_texture_reads\": {},\n", cost.dependent_texture_reads);
+        content += fmt::format("      \"loops\": {},\n", cost.loops);
+        content += fmt::format("      \"branches\": {},\n", cost.branches);
+        content += fmt::format("      \"discards\": {},\n", cost.discards);
+        content += fmt::format("      \"storage_loads\": {},\n", cost.storage_loads);
+        content += fmt::format("      \"storage_stores\": {},\n", cost.storage_stores);
+        content += fmt::format("      \"shared_memory_bytes\": {},\n", cost.shared_memory_bytes);
+        content += fmt::format("      \"live_values\": {},\n", cost.live_values);
+        content += "      \"slangs\": {";
+        bool first = true;
+        for (int i = 0; i < Slang::Num; i++) {
+            const Slang::Enum slang = Slang::from_index(i);
+            if (args.slang & Slang::bit(slang)) {
+                content += fmt::format("{}\n        \"{}\": {{ \"source_bytes\": {}, \"bytecode_bytes\": {} }}",
+                    first ? "" : ",",
+                    Slang::to_str(slang),
+                    cost.slang_sizes[i].source_bytes,
+                    cost.slang_sizes[i].bytecode_bytes);
+                first = false;
+            }
+        }
+        content += "\n      }\n";
+        content += fmt::format("    }}{}\n", ((ci + 1) < costs.size()) ? "," : "");
+    }
+    content += "  ]\n";
+    content += "}\n";
+    if (!util::write_file_if_changed(*args.vfs, args.analysis_file, content.data(), content.length(), true)) {
+        return ErrMsg::error(inp.base_path, 0, fmt::format("failed to write analysis output file '{}'", args.analysis_file));
+    }
+    return ErrMsg();
+}
+
+static ErrMsg write_text_file(const Args& args, const Input& inp, const std::string& path, const std::string& content) {
+    if (!util::write_file_if_changed(*args.vfs, path, content.data(), content.length(), true)) {
+        return ErrMsg::error(inp.base_path, 0, fmt::format("failed to write heatmap output file '{}'", path));
+    }
+    return ErrMsg();
+}
+
+// writes a JSON file and an annotated source listing to [heatmap].json and [heatmap].txt
+ErrMsg Analysis::write_heatmap(const Args& args, const Input& inp) const {
+    std::string json = "{\n";
+    json += fmt::format("  \"input\": {},\n", util::json_string(inp.base_path));
+    json += "  \"shaders\": [\n";
+    std::string txt;
+    size_t snippet_count = 0;
+    for (const auto& item: line_costs) {
+        const Snippet& snippet = inp.snippets[item.first];
+        json += "    {\n";
+        json += fmt::format("      \"name\": {},\n", util::json_string(snippet.name));
+        json += fmt::format("      \"stage\": \"{}\",\n", Snippet::type_to_str(snippet.type));
+        json += "      \"lines\": [\n";
+        for (size_t i = 0; i < item.second.size(); i++) {
+            const LineCost& lc = item.second[i];
+            const Line& line = inp.lines[lc.line_index];
+            json += fmt::format("        {{ \"file\": {}, \"line\": {}, \"instructions\": {}, \"alu_ops\": {}, \"transcendental_ops\": {}, "
+                "\"texture_samples\": {}, \"dependent_texture_reads\": {}, \"loops\": {}, \"branches\": {}, \"discards\": {}, "
+                "\"storage_loads\": {}, \"storage_stores\": {} }}{}\n",
+                util::json_string(inp.filenames[line.filename]),
+                line.index + 1,
+                lc.cost.instructions,
+                lc.cost.alu_ops,
+                lc.cost.transcendental_ops,
+                lc.cost.texture_samples,
+                lc.cost.dependent_texture_reads,
+                lc.cost.loops,
+                lc.cost.branches,
+                lc.cost.discards,
+                lc.cost.storage_loads,
+                lc.cost.storage_stores,
+                ((i + 1) < item.second.size()) ? "," : "");
+        }
+        json += "      ]\n";
+        json += fmt::format("    }}{}\n", (++snippet_count < line_costs.size()) ? "," : "");
+
+        // annotated listing of all snippet lines (including @include_block lines)
+        txt += fmt::format("{} shader '{}':\n\n", Snippet::type_to_str(snippet.type), snippet.name);
+        txt += fmt::format("{:>6} {:>5} {:>5} {:>5}  {:<24} | source\n", "instr", "alu", "trans", "tex", "location");
+        for (int line_index: snippet.lines) {
+            const Line& line = inp.lines[line_index];
+            const std::string location = fmt::format("{}:{}", pystring::os::path::basename(inp.filenames[line.filename]), line.index + 1);
+            const LineCost* lc = nullptr;
+            for (const LineCost& candidate: item.second) {
+                if (candidate.line_index == line_index) {
+                    lc = &candidate;
+                    break;
+                }
+            }
+            if (lc) {
+                txt += fmt::format("{:>6} {:>5} {:>5} {:>5}  {:<24} | {}\n",
+                    lc->cost.instructions,
+                    lc->cost.alu_ops,
+                    lc->cost.transcendental_ops,
+                    lc->cost.texture_samples,
+                    location,
+                    line.line);
+            } else {
+                txt += fmt::format("{:>6} {:>5} {:>5} {:>5}  {:<24} | {}\n", "", "", "", "", location, line.line);
+            }
+        }
+        txt += "\n";
+    }
+    json += "  ]\n";
+    json += "}\n";
+    ErrMsg err = write_text_file(args, inp, args.heatmap_file + ".json", json);
+    if (err.valid()) {
+        return err;
+    }
+    return write_text_file(args, inp, args.heatmap_file + ".txt", txt);
+}
+
+void Analysis::dump_debug(const Input& inp) const {
+    fmt::print(stderr, "Analysis:\n");
+    for (const ShaderCost& cost: costs) {
+        fmt::print(stderr, "  {}:\n", inp.snippets[cost.snippet_index].name);
+        fmt::print(stderr, "    spirv_bytes: {}\n", cost.spirv_bytes);
+        fmt::print(stderr, "    instructions: {}\n", cost.instructions);
+        fmt::print(stderr, "    alu_ops: {}\n", cost.alu_ops);
+        fmt::print(stderr, "    transcendental_ops: {}\n", cost.transcendental_ops);
+        fmt::print(stderr, "    texture_samples: {}\n", cost.texture_samples);
+        fmt::print(stderr, "    dependent_texture_reads: {}\n", cost.dependent_texture_reads);
+        fmt::print(stderr, "    loops: {}\n", cost.loops);
+        fmt::print(stderr, "    branches: {}\n", cost.branches);
+        fmt::print(stderr, "    discards: {}\n", cost.discards);
+        fmt::print(stderr, "    storage_loads: {}\n", cost.storage_loads);
+        fmt::print(stderr, "    storage_stores: {}\n", cost.storage_stores);
+        fmt::print(stderr, "    shared_memory_bytes: {}\n", cost.shared_memory_bytes);
+        fmt::print(stderr, "    live_values: {}\n", cost.live_values);
+    }
+    fmt::print(stderr, "\n");
+}
+
+} // namespace shdc
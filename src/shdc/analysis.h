@@ -0,0 +1,34 @@
+#pragma once
+#include <array>
+#include <map>
+#include <vector>
+#include "args.h"
+#include "input.h"
+#include "spirv.h"
+#include "spirvcross.h"
+#include "bytecode.h"
+#include "types/errmsg.h"
+#include "types/shader_cost.h"
+
+namespace shdc {
+
+// static per-shader cost analysis (--analyze) and per-source-line cost heatmap (--heatmap)
+struct Analysis {
+    std::vector<ShaderCost> costs;
+    std::map<int, std::vector<LineCost>> line_costs;    // snippet index => per-source-line costs (--heatmap)
+
+    static Analysis build(const Args& args,
+                          const Input& inp,
+                          const std::array<Spirv,Slang::Num>& spirv,
+                          const std::array<Spirvcross,Slang::Num>& spirvcross,
+                          const std::array<Bytecode,Slang::Num>& bytecode);
+    // out_line_costs is optional and maps source line numbers of OpLine debug info to costs
+    static ShaderCost analyze_spirv(const std::vector<uint32_t>& bytecode, std::map<int,ShaderCost>* out_line_costs = nullptr);
+    void build_heatmap(const Input& inp, const Spirv& debug_spirv);
+    const ShaderCost* find_cost_by_snippet_index(int snippet_index) const;
+    ErrMsg write_json(const Args& args, const Input& inp) const;
+    ErrMsg write_heatmap(const Args& args, const Input& inp) const;
+    void dump_debug(const Input& inp) const;
+};
+
+} // namespace shdc
@@ -2,8 +2,12 @@
     parse command line arguments
 */
 #include "args.h"
+#include "worker.h"
 #include "types/slang.h"
 #include <vector>
+#include <set>
+#include <algorithm>
+#include <assert.h>
 #include <stdio.h>
 #include "fmt/format.h"
 #include "getopt/getopt.h"
@@ -27,30 +31,60 @@ enum {
     OPTION_IFDEF,
     OPTION_NOIFDEF,
     OPTION_REFLECTION,
+    OPTION_REGISTRY,
     OPTION_SAVE_INTERMEDIATE_SPIRV,
     OPTION_NO_LOG_CMDLINE,
     OPTION_DEPENDENCY_FILE,
+    OPTION_LINK_VARYINGS,
+    OPTION_ANALYZE,
+    OPTION_HEATMAP,
+    OPTION_PERF_LINT,
+    OPTION_BUDGET,
+    OPTION_ARRAY_ENCODING,
+    OPTION_SPLIT_BACKENDS,
+    OPTION_LSP,
+    OPTION_CACHE_DIR,
+    OPTION_REMOTE_CACHE,
+    OPTION_REMOTE_CACHE_TIMEOUT,
+    OPTION_WORKER,
+    OPTION_WORKERS,
+    OPTION_TRACE,
 };
 
 static const getopt_option_t option_list[] = {
     { "help",               'h', GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_HELP,         "print this help text", 0},
     { "input",              'i', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_INPUT,        "input source file", "GLSL file" },
-    { "output",             'o', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_OUTPUT,       "output source file", "C header" },
+    { "output",             'o', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_OUTPUT,       "output source file (one for all formats or one per format)", "C header" },
     { "slang",              'l', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_SLANG,        "output shader language(s), see above for list", "glsl430:glsl300es..." },
     { "defines",            0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_DEFINES,      "optional preprocessor defines", "define1:define2..." },
     { "module",             'm', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_MODULE,       "optional @module name override" },
     { "reflection",         'r', GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_REFLECTION,   "generate runtime reflection functions" },
+    { "registry",           0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_REGISTRY,     "C output: generate a registry of all programs" },
     { "bytecode",           'b', GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_BYTECODE,     "output bytecode (HLSL and Metal)"},
-    { "format",             'f', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_FORMAT,       "output format (default: sokol)", "[sokol|sokol_impl|sokol_zig|sokol_nim|sokol_odin|sokol_rust|sokol_d|sokol_jai|sokol_c2|sokol_c3|bare|bare_yaml]" },
+    { "format",             'f', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_FORMAT,       "output format(s) (default: sokol)", "[sokol|sokol_impl|sokol_zig|sokol_nim|sokol_odin|sokol_rust|sokol_d|sokol_jai|sokol_c2|sokol_c3|bare|bare_yaml|sokol_pack]:..." },
+    { "array-encoding",     0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_ARRAY_ENCODING, "encoding of embedded shader arrays (default: hex, string is C only)", "[hex|string|embed]" },
     { "errfmt",             'e', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_ERRFMT,       "error message format (default: gcc)", "[gcc|msvc]"},
     { "dump",               'd', GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_DUMP,         "dump debugging information to stderr"},
     { "genver",             'g', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_GENVER,       "version-stamp for code-generation", "[int]"},
     { "tmpdir",             't', GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_TMPDIR,       "directory for temporary files (use output dir if not specified)", "[dir]"},
     { "ifdef",              0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_IFDEF,        "wrap backend-specific generated code in #ifdef/#endif"},
+    { "split-backends",     0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_SPLIT_BACKENDS, "C output: write each shader language into a separate header next to the output file"},
     { "noifdef",            'n', GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_NOIFDEF,      "obsolete, superseded by --ifdef"},
     { "save-intermediate-spirv", 0, GETOPT_OPTION_TYPE_NO_ARG,  0, OPTION_SAVE_INTERMEDIATE_SPIRV, "save intermediate SPIRV bytecode (for debug inspection)"},
     { "no-log-cmdline",     0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_NO_LOG_CMDLINE, "don't log the cmdline to the code-generated output file"},
     { "dependency-file",    0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_DEPENDENCY_FILE, "generate a Clang/GCC style dep-file for use with build systems", "[deps file]" },
+    { "analyze",            0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_ANALYZE,      "write a static per-shader cost analysis", "[json file]" },
+    { "heatmap",            0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_HEATMAP,      "write a per-source-line cost heatmap to [path].json and [path].txt", "[path]" },
+    { "budget",             0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_BUDGET,       "fail if a program exceeds the limits in a budget file", "[budget file]" },
+    { "perf-lint",          0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_PERF_LINT,    "print warnings for common shader performance pitfalls"},
+    { "link-varyings",      0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_LINK_VARYINGS, "remove unused and pack remaining vertex-to-fragment shader varyings"},
+    { "lsp",                0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_LSP,          "run as a language server over stdio (diagnostics and hover info for editors)"},
+    { "cache-dir",          0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_CACHE_DIR,    "cache compilation results in a directory", "[dir]" },
+    { "remote-cache",       0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_REMOTE_CACHE, "cache compilation results on a bazel-remote style HTTP cache server", "http://host:port[/prefix]" },
+    { "remote-cache-timeout", 0, GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_REMOTE_CACHE_TIMEOUT, "remote cache timeout in milliseconds (default: 1000)", "[int]" },
+    { "worker",             0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_WORKER,       "run as compile worker for --workers, listening on a TCP port", "[port]" },
+    { "workers",            0,   GETOPT_OPTION_TYPE_REQUIRED,   0, OPTION_WORKERS,      "distribute compilation over sokol-shdc --worker processes", "host:port,host:port..." },
+    { "trace",              0,   GETOPT_OPTION_TYPE_NO_ARG,     0, OPTION_TRACE,        "print job times and the makespan of --workers scheduling"},
     GETOPT_OPTIONS_END
 };
 
@@ -88,7 +122,8 @@ static void print_help_string(getopt_context_t& ctx) {
         "  - sokol_c2       C2 module file\n"
         "  - sokol_c3       C3 module file\n"
         "  - bare           raw output of SPIRV-Cross compiler, in text or binary format\n"
-        "  - bare_yaml      like bare, but with reflection file in YAML format\n\n"
+        "  - bare_yaml      like bare, but with reflection file in YAML format\n"
+        "  - sokol_pack     binary archive with shader blobs and reflection info\n\n"
         "Options:\n\n");
     char buf[4096];
     fmt::print(stderr, "{}", getopt_create_help_string(&ctx, buf, sizeof(buf)));
@@ -135,20 +170,133 @@ static bool parse_slang(Args& args, const char* str) {
     return true;
 }
 
+/* parse string of format 'sokol:bare_yaml:...' into args.output_formats */
+static bool parse_formats(Args& args, const char* str) {
+    std::vector<std::string> items;
+    pystring::split(str, items, ":");
+    for (const std::string& item: items) {
+        const Format::Enum format = Format::from_str(item);
+        if (format == Format::INVALID) {
+            fmt::print(stderr, "sokol-shdc: unknown output format {}, must be [sokol|sokol_impl|sokol_zig|sokol_nim|sokol_odin|sokol_rust|sokol_d|sokol_jai|sokol_c2|sokol_c3|bare|bare_yaml|sokol_pack]\n", item);
+            args.valid = false;
+            args.exit_code = 10;
+            return false;
+        }
+        args.output_formats.push_back(format);
+    }
+    return true;
+}
+
 static void validate(Args& args) {
+    if (!args.remote_cache.empty() && !HttpUrl::parse(args.remote_cache).valid) {
+        fmt::print(stderr, "sokol-shdc: invalid remote cache URL '{}' (expected http://host:port[/prefix])\n", args.remote_cache);
+        args.valid = false;
+        args.exit_code = 10;
+        return;
+    }
+    for (const std::string& addr: args.workers) {
+        if (!WorkerAddress::parse(addr).valid) {
+            fmt::print(stderr, "sokol-shdc: invalid worker address '{}' (expected host:port)\n", addr);
+            args.valid = false;
+            args.exit_code = 10;
+            return;
+        }
+    }
+    if (args.trace && args.workers.empty()) {
+        fmt::print(stderr, "sokol-shdc: --trace is only supported with --workers\n");
+        args.valid = false;
+        args.exit_code = 10;
+        return;
+    }
+    // compile workers get their jobs over the network and don't read or write any files
+    if (args.worker) {
+        if ((args.worker_port <= 0) || (args.worker_port >= 65536)) {
+            fmt::print(stderr, "sokol-shdc: invalid worker port (--worker [port])\n");
+            args.valid = false;
+            args.exit_code = 10;
+            return;
+        }
+        if (!args.tmpdir.empty() && !pystring::endswith(args.tmpdir, "/")) {
+            args.tmpdir += "/";
+        }
+        args.valid = true;
+        args.exit_code = 0;
+        return;
+    }
+    // the language server gets its input files from the editor and doesn't write any outputs
+    if (args.lsp) {
+        if (args.slang == 0) {
+            args.slang = Slang::bit(Slang::GLSL430);
+        }
+        args.valid = true;
+        args.exit_code = 0;
+        return;
+    }
     bool err = false;
     if (args.input.empty()) {
         fmt::print(stderr, "sokol-shdc: no input file (--input [path])\n");
         err = true;
     }
-    if (args.output.empty()) {
+    if (args.output_formats.empty()) {
+        args.output_formats.push_back(Format::SOKOL);
+    }
+    if (args.outputs.empty()) {
         fmt::print(stderr, "sokol-shdc: no output file (--output [path])\n");
         err = true;
+    } else if ((args.outputs.size() != 1) && (args.outputs.size() != args.output_formats.size())) {
+        fmt::print(stderr, "sokol-shdc: expected one --output path, or one per output format ({})\n", args.output_formats.size());
+        err = true;
+    } else {
+        args.output = args.outputs[0];
+        args.output_format = args.output_formats[0];
+        // the bare formats write files next to the output path, all others write the output path itself
+        std::set<std::string> output_paths;
+        std::set<std::string> bare_output_paths;
+        for (size_t i = 0; i < args.output_formats.size(); i++) {
+            const Format::Enum format = args.output_formats[i];
+            const std::string& path = args.outputs.size() == 1 ? args.outputs[0] : args.outputs[i];
+            std::set<std::string>& paths = ((format == Format::BARE) || (format == Format::BARE_YAML)) ? bare_output_paths : output_paths;
+            if (!paths.insert(path).second) {
+                fmt::print(stderr, "sokol-shdc: output format {} would overwrite the output of another format, provide one --output path per format\n", Format::to_str(format));
+                err = true;
+            }
+        }
     }
     if (args.slang == 0) {
         fmt::print(stderr, "sokol-shdc: no shader languages (--slang ...)\n");
         err = true;
     }
+    if (args.split_backends &&
+        (std::find(args.output_formats.begin(), args.output_formats.end(), Format::SOKOL) == args.output_formats.end()) &&
+        (std::find(args.output_formats.begin(), args.output_formats.end(), Format::SOKOL_IMPL) == args.output_formats.end()))
+    {
+        fmt::print(stderr, "sokol-shdc: --split-backends is only supported for the sokol and sokol_impl output formats\n");
+        err = true;
+    }
+    if (args.registry) {
+        for (Format::Enum format: args.output_formats) {
+            if ((format != Format::SOKOL) && (format != Format::SOKOL_IMPL)) {
+                fmt::print(stderr, "sokol-shdc: --registry is only supported for the sokol and sokol_impl output formats (not {})\n", Format::to_str(format));
+                err = true;
+            }
+        }
+    }
+    for (const Format::Enum format: args.output_formats) {
+        if ((args.array_encoding == ArrayEncoding::STRING) && (format != Format::SOKOL) && (format != Format::SOKOL_IMPL)) {
+            fmt::print(stderr, "sokol-shdc: --array-encoding=string is only supported for the sokol and sokol_impl output formats\n");
+            err = true;
+        }
+        if ((args.array_encoding == ArrayEncoding::EMBED) &&
+            ((format == Format::SOKOL_JAI) ||
+             (format == Format::SOKOL_C2) ||
+             (format == Format::BARE) ||
+             (format == Format::BARE_YAML) ||
+             (format == Format::SOKOL_PACK)))
+        {
+            fmt::print(stderr, "sokol-shdc: --array-encoding=embed is not supported for the {} output format\n", Format::to_str(format));
+            err = true;
+        }
+    }
     if (args.tmpdir.empty()) {
         std::string tail;
         pystring::os::path::split(args.tmpdir, tail, args.output);
@@ -202,7 +350,7 @@ Args Args::parse(int argc, const char** argv) {
                     args.input = ctx.current_opt_arg;
                     break;
                 case OPTION_OUTPUT:
-                    args.output = ctx.current_opt_arg;
+                    args.outputs.push_back(ctx.current_opt_arg);
                     break;
                 case OPTION_TMPDIR:
                     args.tmpdir = ctx.current_opt_arg;
@@ -219,10 +367,19 @@ Args Args::parse(int argc, const char** argv) {
                 case OPTION_REFLECTION:
                     args.reflection = true;
                     break;
+                case OPTION_REGISTRY:
+                    args.registry = true;
+                    break;
                 case OPTION_FORMAT:
-                    args.output_format = Format::from_str(ctx.current_opt_arg);
-                    if (args.output_format == Format::INVALID) {
-                        fmt::print(stderr, "sokol-shdc: unknown output format {}, must be [sokol|sokol_impl|sokol_zig|sokol_nim|sokol_odin|sokol_rust|sokol_jai|sokol_c2|sokol_c3|bare|base_yaml]\n", ctx.current_opt_arg);
+                    if (!parse_formats(args, ctx.current_opt_arg)) {
+                        /* error details have been filled by parse_formats() */
+                        return args;
+                    }
+                    break;
+                case OPTION_ARRAY_ENCODING:
+                    args.array_encoding = ArrayEncoding::from_str(ctx.current_opt_arg);
+                    if (args.array_encoding == ArrayEncoding::INVALID) {
+                        fmt::print(stderr, "sokol-shdc: unknown array encoding {}, must be [hex|string|embed]\n", ctx.current_opt_arg);
                         args.valid = false;
                         args.exit_code = 10;
                         return args;
@@ -261,6 +418,31 @@ Args Args::parse(int argc, const char** argv) {
                 case OPTION_IFDEF:
                     args.ifdef = true;
                     break;
+                case OPTION_SPLIT_BACKENDS:
+                    args.split_backends = true;
+                    break;
+                case OPTION_LSP:
+                    args.lsp = true;
+                    break;
+                case OPTION_CACHE_DIR:
+                    args.cache_dir = ctx.current_opt_arg;
+                    break;
+                case OPTION_REMOTE_CACHE:
+                    args.remote_cache = ctx.current_opt_arg;
+                    break;
+                case OPTION_REMOTE_CACHE_TIMEOUT:
+                    args.remote_cache_timeout = atoi(ctx.current_opt_arg);
+                    break;
+                case OPTION_WORKER:
+                    args.worker = true;
+                    args.worker_port = atoi(ctx.current_opt_arg);
+                    break;
+                case OPTION_WORKERS:
+                    pystring::split(ctx.current_opt_arg, args.workers, ",");
+                    break;
+                case OPTION_TRACE:
+                    args.trace = true;
+                    break;
                 case OPTION_NOIFDEF:
                     // obsolete, but keep for backwards compatibility
                     args.ifdef = false;
@@ -268,6 +450,21 @@ Args Args::parse(int argc, const char** argv) {
                 case OPTION_DEPENDENCY_FILE:
                     args.dependency_file = ctx.current_opt_arg;
                     break;
+                case OPTION_ANALYZE:
+                    args.analysis_file = ctx.current_opt_arg;
+                    break;
+                case OPTION_HEATMAP:
+                    args.heatmap_file = ctx.current_opt_arg;
+                    break;
+                case OPTION_LINK_VARYINGS:
+                    args.link_varyings = true;
+                    break;
+                case OPTION_BUDGET:
+                    args.budget_file = ctx.current_opt_arg;
+                    break;
+                case OPTION_PERF_LINT:
+                    args.perf_lint = true;
+                    break;
                 case OPTION_HELP:
                     print_help_string(ctx);
                     args.valid = false;
@@ -279,9 +476,20 @@ Args Args::parse(int argc, const char** argv) {
         }
     }
     validate(args);
+    if (args.valid) {
+        args.cache = ArtifactCache::create(args);
+    }
     return args;
 }
 
+Args Args::with_output_format(size_t index) const {
+    assert(index < output_formats.size());
+    Args res = *this;
+    res.output_format = output_formats[index];
+    res.output = (outputs.size() == 1) ? outputs[0] : outputs[index];
+    return res;
+}
+
 void Args::dump_debug() const {
     fmt::print(stderr, "Args:\n");
     fmt::print(stderr, "  valid: {}\n", valid);
@@ -293,13 +501,32 @@ void Args::dump_debug() const {
     fmt::print(stderr, "  byte_code: {}\n", byte_code);
     fmt::print(stderr, "  module: '{}'\n", module);
     fmt::print(stderr, "  defines: '{}'\n", pystring::join(":", defines));
+    fmt::print(stderr, "  analysis_file: '{}'\n", analysis_file);
+    fmt::print(stderr, "  heatmap_file: '{}'\n", heatmap_file);
+    fmt::print(stderr, "  budget_file: '{}'\n", budget_file);
+    fmt::print(stderr, "  cache_dir: '{}'\n", cache_dir);
+    fmt::print(stderr, "  remote_cache: '{}'\n", remote_cache);
+    fmt::print(stderr, "  remote_cache_timeout: {}\n", remote_cache_timeout);
+    fmt::print(stderr, "  workers: '{}'\n", pystring::join(",", workers));
+    fmt::print(stderr, "  trace: {}\n", trace);
     fmt::print(stderr, "  output_format: '{}'\n", Format::to_str(output_format));
+    for (size_t i = 0; i < output_formats.size(); i++) {
+        fmt::print(stderr, "  output_formats[{}]: '{}' => '{}'\n", i, Format::to_str(output_formats[i]), (outputs.size() == 1) ? outputs[0] : outputs[i]);
+    }
+    fmt::print(stderr, "  array_encoding: '{}'\n", ArrayEncoding::to_str(array_encoding));
     fmt::print(stderr, "  debug_dump: {}\n", debug_dump);
     fmt::print(stderr, "  ifdef: {}\n", ifdef);
+    fmt::print(stderr, "  split_backends: {}\n", split_backends);
+    fmt::print(stderr, "  registry: {}\n", registry);
     fmt::print(stderr, "  gen_version: {}\n", gen_version);
     fmt::print(stderr, "  error_format: {}\n", ErrMsg::format_to_str(error_format));
     fmt::print(stderr, "  save_intermediate_spirv: {}\n", save_intermediate_spirv);
     fmt::print(stderr, "  no_log_cmdline: {}\n", no_log_cmdline);
+    fmt::print(stderr, "  link_varyings: {}\n", link_varyings);
+    fmt::print(stderr, "  perf_lint: {}\n", perf_lint);
+    fmt::print(stderr, "  lsp: {}\n", lsp);
+    fmt::print(stderr, "  worker: {}\n", worker);
+    fmt::print(stderr, "  worker_port: {}\n", worker_port);
     fmt::print(stderr, "\n");
 }
 
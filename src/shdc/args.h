@@ -4,6 +4,9 @@
 #include <vector>
 #include "types/errmsg.h"
 #include "types/format.h"
+#include "types/array_encoding.h"
+#include "vfs.h"
+#include "cache.h"
 
 namespace shdc {
 
@@ -13,23 +16,45 @@ struct Args {
     std::string cmdline;
     int exit_code = 10;
     std::string input;                  // input file path
-    std::string output;                 // output file path
+    std::string output;                 // output file path (of the first output format)
+    std::vector<std::string> outputs;   // output file paths, either one for all output formats or one per output format
     std::string tmpdir;                 // directory for temporary files
     std::string dependency_file;        // optional dependency file to generate
     std::string module;                 // optional @module name override
+    std::string analysis_file;          // optional static cost analysis output file (JSON)
+    std::string heatmap_file;           // optional per-source-line cost heatmap output path (without extension)
+    std::string budget_file;            // optional per-program shader budget file
+    std::string cache_dir;              // optional directory of the persistent artifact cache
+    std::string remote_cache;           // optional URL of a remote HTTP artifact cache
+    int remote_cache_timeout = 1000;    // remote cache connect/send/receive timeout in milliseconds
+    std::vector<std::string> workers;   // optional host:port addresses of --worker processes to distribute compilation
+    bool trace = false;                 // print job times and the makespan of distributed compilation
     std::vector<std::string> defines;   // additional preprocessor defines
     uint32_t slang = 0;                 // combined Slang bits
     bool byte_code = false;             // output byte code (for HLSL and MetalSL)
     bool reflection = false;            // if true, generate runtime reflection functions
-    Format::Enum output_format = Format::SOKOL; // output format
+    bool registry = false;              // if true, generate a program registry (C output formats only)
+    Format::Enum output_format = Format::SOKOL; // output format (the first of output_formats)
+    std::vector<Format::Enum> output_formats;   // all requested output formats
+    ArrayEncoding::Enum array_encoding = ArrayEncoding::HEX;    // encoding of embedded shader arrays
     bool debug_dump = false;            // print debug-dump info
     bool ifdef = false;                 // wrap backend specific shaders into #ifdefs (SOKOL_D3D11 etc...)
+    bool split_backends = false;        // C output: write the shader code of each shader language into a separate file
     bool save_intermediate_spirv = false;   // save intermediate SPIRV bytecode (glslangvalidator output)
     bool no_log_cmdline = false;        // if true, no cmdline will be logged to the generated output code
+    bool link_varyings = false;         // eliminate unused and pack remaining vertex shader outputs / fragment shader inputs
+    bool perf_lint = false;             // print shader performance warnings
+    bool lsp = false;                   // run as language server over stdio instead of compiling an input file
+    bool worker = false;                // run as compile worker for --workers coordinators instead of compiling an input file
+    int worker_port = 0;                // TCP port of the compile worker
     int gen_version = 1;                // generator-version stamp
     ErrMsg::Format error_format = ErrMsg::GCC;  // format for error messages
+    std::shared_ptr<Vfs> vfs = Vfs::disk();     // filesystem for all file reads and writes
+    std::shared_ptr<ArtifactCache> cache;       // optional persistent cache for compilation results
 
     static Args parse(int argc, const char** argv);
+    // a copy with output and output_format set to one of the requested output formats
+    Args with_output_format(size_t index) const;
     void dump_debug() const;
 };
 
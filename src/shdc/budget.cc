@@ -0,0 +1,188 @@
+/*
+    per-program shader budgets (--budget)
+*/
+#include "budget.h"
+#include "util.h"
+#include "pystring.h"
+
+namespace shdc {
+
+using namespace refl;
+
+const char* Budget::limit_to_str(Limit limit) {
+    switch (limit) {
+        case TextureSamples:    return "texture_samples";
+        case AluOps:            return "alu_ops";
+        case BytecodeBytes:     return "bytecode_bytes";
+        case UniformBlockBytes: return "uniform_block_bytes";
+        default:                return "<invalid>";
+    }
+}
+
+// the budget file is line based, each line starts with a program name glob pattern followed
+// by one or more limit=value pairs, the bytecode size limit may be restricted to a shader
+// language with bytecode_bytes.[slang]=value, empty lines and lines starting with '#' are ignored
+Budget Budget::load(const std::string& path, Vfs& vfs) {
+    Budget res;
+    res.path = path;
+    std::string content;
+    if (!vfs.read(path, content)) {
+        res.error = ErrMsg::error(fmt::format("failed to open budget file '{}'", path));
+        return res;
+    }
+    std::vector<std::string> lines;
+    pystring::splitlines(content, lines);
+    for (int line_index = 0; line_index < (int)lines.size(); line_index++) {
+        const std::string line = pystring::strip(lines[line_index]);
+        if (line.empty() || pystring::startswith(line, "#")) {
+            continue;
+        }
+        std::vector<std::string> tokens;
+        pystring::split(line, tokens);
+        if (tokens.size() < 2) {
+            res.error = ErrMsg::error(path, line_index, "expected a program name pattern followed by one or more limit=value pairs");
+            return res;
+        }
+        for (size_t i = 1; i < tokens.size(); i++) {
+            std::vector<std::string> key_value;
+            pystring::split(tokens[i], key_value, "=");
+            if ((key_value.size() != 2) || key_value[0].empty() || key_value[1].empty()) {
+                res.error = ErrMsg::error(path, line_index, fmt::format("invalid budget item '{}', expected limit=value", tokens[i]));
+                return res;
+            }
+            Entry entry;
+            entry.pattern = tokens[0];
+            entry.line_index = line_index;
+            std::string key = key_value[0];
+            std::string slang_str;
+            std::vector<std::string> key_parts;
+            pystring::split(key, key_parts, ".");
+            if (key_parts.size() == 2) {
+                key = key_parts[0];
+                slang_str = key_parts[1];
+            }
+            for (int l = 0; l < NumLimits; l++) {
+                if (key == limit_to_str((Limit)l)) {
+                    entry.limit = (Limit)l;
+                }
+            }
+            if ((entry.limit == NumLimits) || (key_parts.size() > 2)) {
+                res.error = ErrMsg::error(path, line_index, fmt::format("unknown budget limit '{}' (valid: texture_samples, alu_ops, bytecode_bytes[.slang], uniform_block_bytes)", key_value[0]));
+                return res;
+            }
+            if (!slang_str.empty()) {
+                if (entry.limit != BytecodeBytes) {
+                    res.error = ErrMsg::error(path, line_index, fmt::format("only bytecode_bytes can be restricted to a shader language ('{}')", key_value[0]));
+                    return res;
+                }
+                for (int s = 0; s < Slang::Num; s++) {
+                    if (slang_str == Slang::to_str((Slang::Enum)s)) {
+                        entry.slang = (Slang::Enum)s;
+                    }
+                }
+                if (entry.slang == Slang::Num) {
+                    res.error = ErrMsg::error(path, line_index, fmt::format("unknown shader language '{}' (valid: {})", slang_str, Slang::bits_to_str(0xFFFF, " ")));
+                    return res;
+                }
+            }
+            if (!pystring::isdigit(key_value[1])) {
+                res.error = ErrMsg::error(path, line_index, fmt::format("budget value '{}' must be a non-negative integer", key_value[1]));
+                return res;
+            }
+            entry.value = atoi(key_value[1].c_str());
+            res.entries.push_back(entry);
+        }
+    }
+    return res;
+}
+
+std::vector<ErrMsg> Budget::check(const Input& inp, const Reflection& refl, const Analysis& analysis, uint32_t slang_mask) const {
+    std::vector<ErrMsg> errors;
+    for (const ProgramReflection& prog: refl.progs) {
+        // errors are reported at the @program tag
+        const auto prog_it = inp.programs.find(prog.name);
+        const int prog_line_index = (prog_it != inp.programs.end()) ? prog_it->second.line_index : 0;
+        std::vector<const ShaderCost*> costs;
+        for (const StageReflection& stage: prog.stages) {
+            if (stage.snippet_index >= 0) {
+                const ShaderCost* cost = analysis.find_cost_by_snippet_index(stage.snippet_index);
+                if (cost) {
+                    costs.push_back(cost);
+                }
+            }
+        }
+        for (const Entry& entry: entries) {
+            if (!util::glob_match(entry.pattern.c_str(), prog.name.c_str())) {
+                continue;
+            }
+            const auto exceeded = [&](int value, const std::string& what) {
+                errors.push_back(inp.error(prog_line_index,
+                    fmt::format("program '{}' exceeds budget: {} is {}, limit is {} (in {}:{})",
+                        prog.name, what, value, entry.value, path, entry.line_index + 1)));
+            };
+            switch (entry.limit) {
+                case TextureSamples:
+                case AluOps:
+                    {
+                        int value = 0;
+                        for (const ShaderCost* cost: costs) {
+                            if (entry.limit == TextureSamples) {
+                                value += cost->texture_samples;
+                            } else {
+                                value += cost->alu_ops + cost->transcendental_ops;
+                            }
+                        }
+                        if (value > entry.value) {
+                            exceeded(value, limit_to_str(entry.limit));
+                        }
+                    }
+                    break;
+                case BytecodeBytes:
+                    for (int i = 0; i < Slang::Num; i++) {
+                        const Slang::Enum slang = Slang::from_index(i);
+                        if (!(slang_mask & Slang::bit(slang)) || ((entry.slang != Slang::Num) && (entry.slang != slang))) {
+                            continue;
+                        }
+                        // shader languages without bytecode embed the generated source code
+                        int value = 0;
+                        for (const ShaderCost* cost: costs) {
+                            const ShaderCost::SlangSize& size = cost->slang_sizes[i];
+                            value += (size.bytecode_bytes > 0) ? size.bytecode_bytes : size.source_bytes;
+                        }
+                        if (value > entry.value) {
+                            exceeded(value, fmt::format("{} for {}", limit_to_str(entry.limit), Slang::to_str(slang)));
+                        }
+                    }
+                    break;
+                case UniformBlockBytes:
+                    for (const UniformBlock& ub: prog.bindings.uniform_blocks) {
+                        if (ub.struct_info.size > entry.value) {
+                            exceeded(ub.struct_info.size, fmt::format("{} of uniform block '{}'", limit_to_str(entry.limit), ub.name));
+                        }
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    return errors;
+}
+
+void Budget::dump_debug() const {
+    fmt::print(stderr, "Budget:\n");
+    fmt::print(stderr, "  path: '{}'\n", path);
+    fmt::print(stderr, "  entries:\n");
+    for (const Entry& entry: entries) {
+        fmt::print(stderr, "    {} {}{}{}={} (line: {})\n",
+            entry.pattern,
+            limit_to_str(entry.limit),
+            (entry.slang != Slang::Num) ? "." : "",
+            (entry.slang != Slang::Num) ? Slang::to_str(entry.slang) : "",
+            entry.value,
+            entry.line_index);
+    }
+    fmt::print(stderr, "\n");
+}
+
+} // namespace shdc
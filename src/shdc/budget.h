@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "input.h"
+#include "reflection.h"
+#include "analysis.h"
+#include "types/errmsg.h"
+#include "types/slang.h"
+
+namespace shdc {
+
+// per-program shader budgets loaded from a budget file (--budget)
+struct Budget {
+    enum Limit {
+        TextureSamples,
+        AluOps,
+        BytecodeBytes,
+        UniformBlockBytes,
+        NumLimits,
+    };
+    struct Entry {
+        std::string pattern;        // glob pattern matched against program names
+        Limit limit = NumLimits;
+        Slang::Enum slang = Slang::Num;     // only for BytecodeBytes, Slang::Num means all shader languages
+        int value = 0;
+        int line_index = -1;        // line index in budget file (zero-based)
+    };
+    std::string path;
+    std::vector<Entry> entries;
+    ErrMsg error;
+
+    // load and parse a budget file, parse errors will be in .error
+    static Budget load(const std::string& path, Vfs& vfs);
+    // check all programs against the budget, returns one error per exceeded limit
+    std::vector<ErrMsg> check(const Input& inp, const refl::Reflection& refl, const Analysis& analysis, uint32_t slang_mask) const;
+    static const char* limit_to_str(Limit limit);
+    void dump_debug() const;
+};
+
+} // namespace shdc
@@ -22,6 +22,10 @@
 #include "glslang/Include/Types.h"
 #include "SPIRV/GlslangToSpv.h"
 #include "util.h"
+#include "serialize.h"
+#include <map>
+#include <mutex>
+#include <algorithm>
 
 namespace shdc {
 
@@ -37,39 +41,6 @@ const BytecodeBlob* Bytecode::find_blob_by_snippet_index(int snippet_index) cons
 // MacOS/Metal specific stuff...
 #if defined(__APPLE__)
 
-// write source code to file
-static bool write_source(const std::string& source_code, const std::string path) {
-    FILE* f = fopen(path.c_str(), "wb");
-    if (f) {
-        fwrite(source_code.c_str(), source_code.length(), 1, f);
-        fclose(f);
-        return true;
-    } else {
-        return false;
-    }
-}
-
-// load binary file into blob
-static bool read_binary(const std::string& path, std::vector<uint8_t>& out_blob) {
-    bool res = false;
-    FILE* f = fopen(path.c_str(), "rb");
-    if (f) {
-        fseek(f, 0, SEEK_END);
-        const size_t file_size = ftell(f);
-        fseek(f, 0, SEEK_SET);
-        std::vector<uint8_t> blob(file_size);
-        res = (file_size == fread(blob.data(), 1, file_size, f));
-        fclose(f);
-        if (res) {
-            out_blob = std::move(blob);
-        }
-        return true;
-    } else {
-        out_blob.clear();
-        return false;
-    }
-}
-
 // convert errors from metal compiler format to ErrMsg objects
 static void mtl_parse_errors(const std::string& output, const Input& inp, int snippet_index, std::vector<ErrMsg>& out_errors) {
     /*
@@ -179,6 +150,12 @@ static Bytecode mtl_compile(const Args& args, const Input& inp, const Spirvcross
     std::string base_path = fmt::format("{}{}_{}_", args.tmpdir, base_filename, Slang::to_str(slang));
     std::string src_path, dia_path, air_path, lib_path, bin_path;
 
+    // the Metal toolchain runs on files, which must exist on disk
+    if (!args.vfs->is_native()) {
+        bytecode.errors.push_back(ErrMsg::error(inp.base_path, 0, "Metal bytecode compilation requires a disk filesystem"));
+        return bytecode;
+    }
+
     // for each vertex/fragment shader source generated by SPIRV-Cross:
     for (const SpirvcrossSource& src: spirvcross.sources) {
         std::string output;
@@ -188,7 +165,7 @@ static Bytecode mtl_compile(const Args& args, const Input& inp, const Spirvcross
         air_path = fmt::format("{}{}.air", base_path, snippet.name);
         bin_path = fmt::format("{}{}.metallib", base_path, snippet.name);
         // write metal source code to temp file
-        if (!write_source(src.source_code, src_path)) {
+        if (!args.vfs->write(src_path, src.source_code.data(), src.source_code.length())) {
             bytecode.errors.push_back(ErrMsg::error(inp.base_path, 0, fmt::format("failed to write intermediate file '{}'!", src_path)));
             break;
         }
@@ -201,8 +178,8 @@ static Bytecode mtl_compile(const Args& args, const Input& inp, const Spirvcross
             mtl_parse_errors(output, inp, src.snippet_index, bytecode.errors);
             break;
         }
-        std::vector<uint8_t> data;
-        if (!read_binary(bin_path, data)) {
+        std::string bin;
+        if (!args.vfs->read(bin_path, bin)) {
             mtl_parse_errors(output, inp, src.snippet_index, bytecode.errors);
             break;
         }
@@ -214,7 +191,7 @@ static Bytecode mtl_compile(const Args& args, const Input& inp, const Spirvcross
         BytecodeBlob blob;
         blob.valid = true;
         blob.snippet_index = src.snippet_index;
-        blob.data = std::move(data);
+        blob.data.assign(bin.begin(), bin.end());
         bytecode.blobs.push_back(std::move(blob));
     }
     return bytecode;
@@ -428,7 +405,8 @@ static Bytecode spirv_compile(const Input& inp, const Spirvcross& spirvcross, Sl
     return bytecode;
 }
 
-Bytecode Bytecode::compile(const Args& args, const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang) {
+// compile bytecode for all sources without the artifact cache
+static Bytecode compile_sources(const Args& args, const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang) {
     Bytecode bytecode;
     #if defined(__APPLE__)
     // NOTE: for the iOS simulator case, don't compile bytecode but use source code
@@ -447,6 +425,201 @@ Bytecode Bytecode::compile(const Args& args, const Input& inp, const Spirvcross&
     return bytecode;
 }
 
+// true if compile_sources() produces bytecode for a shader language on this platform
+static bool has_bytecode_compiler(Slang::Enum slang) {
+    #if defined(__APPLE__)
+    if ((slang == Slang::METAL_MACOS) || (slang == Slang::METAL_IOS)) {
+        return true;
+    }
+    #endif
+    #if defined(_WIN32)
+    if (Slang::is_hlsl(slang)) {
+        return true;
+    }
+    #endif
+    return Slang::is_spirv(slang);
+}
+
+// identifies the bytecode compiler of a shader language on this machine, so that a cache
+// shared between machines with different toolchains doesn't return mismatching bytecode,
+// the SPIRV compiler is built into sokol-shdc and covered by the cache version
+static std::string bytecode_compiler_id(Slang::Enum slang) {
+    static std::mutex mutex;
+    static std::map<Slang::Enum, std::string> ids;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = ids.find(slang);
+    if (it != ids.end()) {
+        return it->second;
+    }
+    std::string id;
+    #if defined(__APPLE__)
+    if (Slang::is_msl(slang)) {
+        std::string version, sdk_version;
+        xcrun("metal --version", version, slang);
+        xcrun("--show-sdk-version", sdk_version, slang);
+        id = fmt::format("macos:{}:{}", pystring::strip(sdk_version), pystring::strip(version));
+    }
+    #endif
+    #if defined(_WIN32)
+    // the file version resource would need version.lib, size and modification time identify the dll as well
+    if (Slang::is_hlsl(slang) && load_d3dcompiler_dll()) {
+        char path[MAX_PATH] = { 0 };
+        WIN32_FILE_ATTRIBUTE_DATA attrs = { };
+        GetModuleFileNameA(d3dcompiler_dll, path, sizeof(path));
+        if (GetFileAttributesExA(path, GetFileExInfoStandard, &attrs)) {
+            id = fmt::format("windows:d3dcompiler_47:{}:{}:{}", attrs.nFileSizeLow, attrs.ftLastWriteTime.dwHighDateTime, attrs.ftLastWriteTime.dwLowDateTime);
+        }
+    }
+    #endif
+    if (id.empty()) {
+        id = Slang::is_spirv(slang) ? "glslang" : "unknown";
+    }
+    ids[slang] = id;
+    return id;
+}
+
+// the bytecode of a snippet only depends on the compiler, the translated source code, stage and entry point
+static std::string bytecode_cache_key(const Input& inp, const SpirvcrossSource& src, Slang::Enum slang) {
+    const Snippet& snippet = inp.snippets[src.snippet_index];
+    return ArtifactCache::key("bytecode", fmt::format("{}:{}:{}:{}\n{}", Slang::to_str(slang), bytecode_compiler_id(slang), Snippet::type_to_str(snippet.type), src.stage_refl.entry_point, src.source_code));
+}
+
+Bytecode Bytecode::compile(const Args& args, const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang, const BytecodeCache* cache) {
+    if ((!args.cache && !cache) || !has_bytecode_compiler(slang)) {
+        return compile_sources(args, inp, spirvcross, slang);
+    }
+
+    // only compile the sources which haven't been compiled by workers and are not in the artifact cache
+    std::map<int, BytecodeBlob> cached_blobs;   // snippet index => blob
+    Spirvcross missing;
+    for (const SpirvcrossSource& src: spirvcross.sources) {
+        const std::string key = bytecode_cache_key(inp, src, slang);
+        if (cache) {
+            auto it = cache->items.find(key);
+            if (it != cache->items.end()) {
+                BytecodeBlob blob = it->second;
+                blob.snippet_index = src.snippet_index;
+                cached_blobs.emplace(src.snippet_index, std::move(blob));
+                continue;
+            }
+        }
+        std::string data;
+        if (args.cache && args.cache->get(key, data)) {
+            Deserializer reader(data);
+            BytecodeBlob blob = reader.bytecode_blob(src.snippet_index);
+            if (reader.done()) {
+                cached_blobs.emplace(src.snippet_index, std::move(blob));
+                continue;
+            }
+        }
+        missing.sources.push_back(src);
+    }
+    Bytecode compiled;
+    if (!missing.sources.empty()) {
+        compiled = compile_sources(args, inp, missing, slang);
+        // warnings refer to source lines, so only results without any messages are cached
+        if (compiled.errors.empty() && args.cache) {
+            for (const BytecodeBlob& blob: compiled.blobs) {
+                const SpirvcrossSource* src = missing.find_source_by_snippet_index(blob.snippet_index);
+                if (src) {
+                    Serializer writer;
+                    writer.bytecode_blob(blob);
+                    args.cache->put(bytecode_cache_key(inp, *src, slang), writer.data);
+                }
+            }
+        }
+    }
+
+    // keep the blobs in source order
+    Bytecode bytecode;
+    bytecode.errors = std::move(compiled.errors);
+    for (const SpirvcrossSource& src: spirvcross.sources) {
+        auto it = cached_blobs.find(src.snippet_index);
+        if (it != cached_blobs.end()) {
+            bytecode.blobs.push_back(std::move(it->second));
+        } else if (const BytecodeBlob* blob = compiled.find_blob_by_snippet_index(src.snippet_index)) {
+            bytecode.blobs.push_back(*blob);
+        }
+    }
+    return bytecode;
+}
+
+// only shader languages with a bytecode compiler on the coordinator's platform are
+// sent to workers, so that the output doesn't depend on the platform of the workers
+void Bytecode::compile_on_workers(const Args& args, const Input& inp, const std::array<Spirvcross,Slang::Num>& spirvcross, WorkerPool& pool, BytecodeCache& cache) {
+    std::vector<WorkerJob> jobs;
+    std::vector<std::string> keys;
+    for (int i = 0; i < Slang::Num; i++) {
+        const Slang::Enum slang = Slang::from_index(i);
+        if ((0 == (args.slang & Slang::bit(slang))) || !(args.byte_code || Slang::is_spirv(slang)) || !has_bytecode_compiler(slang)) {
+            continue;
+        }
+        for (const SpirvcrossSource& src: spirvcross[i].sources) {
+            const std::string key = bytecode_cache_key(inp, src, slang);
+            if ((cache.items.count(key) > 0) || (std::find(keys.begin(), keys.end(), key) != keys.end())) {
+                continue;
+            }
+            std::string data;
+            if (args.cache && args.cache->get(key, data)) {
+                Deserializer reader(data);
+                BytecodeBlob blob = reader.bytecode_blob(src.snippet_index);
+                if (reader.done()) {
+                    cache.items.emplace(key, std::move(blob));
+                    continue;
+                }
+            }
+            WorkerJob job;
+            job.type = WorkerJob::BYTECODE;
+            job.slang = slang;
+            job.snippet_type = inp.snippets[src.snippet_index].type;
+            job.source = src.source_code;
+            job.entry_point = src.stage_refl.entry_point;
+            job.name = fmt::format("bytecode:{}:{}:{}:{}", Slang::to_str(slang), inp.base_path, inp.snippets[src.snippet_index].name, Snippet::type_to_str(inp.snippets[src.snippet_index].type));
+            jobs.push_back(std::move(job));
+            keys.push_back(key);
+        }
+    }
+    const std::vector<WorkerResult> results = pool.run(jobs);
+    for (size_t i = 0; i < results.size(); i++) {
+        if (!results[i].valid) {
+            continue;
+        }
+        Deserializer reader(results[i].data);
+        BytecodeBlob blob = reader.bytecode_blob(0);
+        if (reader.done()) {
+            cache.items.emplace(keys[i], std::move(blob));
+            if (args.cache) {
+                args.cache->put(keys[i], results[i].data);
+            }
+        }
+    }
+}
+
+// see Spirv::compile_job(), the base path is used for the names of temporary files,
+// so several workers can share the same --tmpdir, and the connection threads of
+// a worker don't overwrite each other's files
+bool Bytecode::compile_job(const Args& args, const WorkerJob& job, int conn_index, BytecodeBlob& out_blob) {
+    if (!has_bytecode_compiler(job.slang)) {
+        return false;
+    }
+    Input inp;
+    inp.base_path = fmt::format("worker{}_{}", args.worker_port, conn_index);
+    inp.snippets.push_back(Snippet((Snippet::Type)job.snippet_type, "job"));
+    SpirvcrossSource src;
+    src.valid = true;
+    src.snippet_index = 0;
+    src.source_code = job.source;
+    src.stage_refl.entry_point = job.entry_point;
+    Spirvcross spirvcross;
+    spirvcross.sources.push_back(std::move(src));
+    Bytecode bytecode = compile_sources(args, inp, spirvcross, job.slang);
+    if (!bytecode.errors.empty() || (bytecode.blobs.size() != 1)) {
+        return false;
+    }
+    out_blob = std::move(bytecode.blobs[0]);
+    return true;
+}
+
 void Bytecode::dump_debug() const {
     fmt::print(stderr, "Bytecode::dump_debug(): FIXME!\n");
 }
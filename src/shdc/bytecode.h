@@ -1,4 +1,6 @@
 #pragma once
+#include <array>
+#include <map>
 #include <vector>
 #include "args.h"
 #include "input.h"
@@ -6,14 +8,25 @@
 #include "types/bytecode_blob.h"
 #include "types/errmsg.h"
 #include "types/slang.h"
+#include "worker.h"
 
 namespace shdc {
 
+// bytecode compiled by --workers processes, keyed like the artifact cache
+struct BytecodeCache {
+    std::map<std::string, BytecodeBlob> items;
+};
+
 struct Bytecode {
     std::vector<ErrMsg> errors;
     std::vector<BytecodeBlob> blobs;
 
-    static Bytecode compile(const Args& args, const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang);
+    static Bytecode compile(const Args& args, const Input& inp, const Spirvcross& spirvcross, Slang::Enum slang, const BytecodeCache* cache = nullptr);
+    // compile the sources of all shader languages which need bytecode on --workers processes into the bytecode cache
+    static void compile_on_workers(const Args& args, const Input& inp, const std::array<Spirvcross,Slang::Num>& spirvcross, WorkerPool& pool, BytecodeCache& cache);
+    // run a job from a coordinator on a --worker process, false if it had any errors or warnings,
+    // conn_index is the worker's connection slot and keeps the temporary files of connections apart
+    static bool compile_job(const Args& args, const WorkerJob& job, int conn_index, BytecodeBlob& out_blob);
     const BytecodeBlob* find_blob_by_snippet_index(int snippet_index) const;
     void dump_debug() const;
 };
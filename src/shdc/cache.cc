@@ -0,0 +1,138 @@
+/*
+    persistent artifact cache (--cache-dir and --remote-cache)
+*/
+#include "cache.h"
+#include "args.h"
+#include "util.h"
+#include "fmt/format.h"
+#include <filesystem>
+
+namespace shdc {
+
+// bump when compiler dependencies or the serialized artifact layout change
+static const char* CacheVersion = "sokol-shdc-cache-1";
+
+std::string ArtifactCache::key(const std::string& kind, const std::string& inputs) {
+    const std::string str = fmt::format("{}\n{}\n{}", CacheVersion, kind, inputs);
+    return util::sha256_hex(str.data(), str.length());
+}
+
+std::shared_ptr<ArtifactCache> ArtifactCache::create(const Args& args) {
+    std::shared_ptr<ArtifactCache> local;
+    std::shared_ptr<ArtifactCache> remote;
+    if (!args.cache_dir.empty()) {
+        local = std::make_shared<DiskCache>(args.cache_dir);
+    }
+    if (!args.remote_cache.empty()) {
+        remote = std::make_shared<RemoteCache>(HttpUrl::parse(args.remote_cache), args.remote_cache_timeout);
+    }
+    if (local && remote) {
+        return std::make_shared<TieredCache>(local, remote);
+    } else if (local) {
+        return local;
+    } else {
+        return remote;
+    }
+}
+
+DiskCache::DiskCache(const std::string& d): dir(d) { };
+
+std::string DiskCache::entry_path(const std::string& key) const {
+    return fmt::format("{}/{}/{}", dir, key.substr(0, 2), key);
+}
+
+bool DiskCache::get(const std::string& key, std::string& out_data) {
+    if (Vfs::disk()->read(entry_path(key), out_data)) {
+        num_hits++;
+        return true;
+    }
+    num_misses++;
+    return false;
+}
+
+// the disk vfs writes to a temp file which is then renamed, so that parallel
+// sokol-shdc processes never see partially written entries
+void DiskCache::put(const std::string& key, const std::string& data) {
+    std::error_code ec;
+    std::filesystem::create_directories(fmt::format("{}/{}", dir, key.substr(0, 2)), ec);
+    if (!ec) {
+        Vfs::disk()->write(entry_path(key), data.data(), data.length());
+    }
+}
+
+void DiskCache::dump_debug() const {
+    fmt::print(stderr, "DiskCache '{}': {} hits, {} misses\n\n", dir, num_hits, num_misses);
+}
+
+RemoteCache::RemoteCache(const HttpUrl& u, int t): url(u), timeout_ms(t) { };
+
+void RemoteCache::disable(const std::string& reason) {
+    disabled = true;
+    fmt::print(stderr, "sokol-shdc: remote cache disabled, continuing without it ({})\n", reason);
+}
+
+bool RemoteCache::get(const std::string& key, std::string& out_data) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (disabled) {
+        return false;
+    }
+    HttpResponse res = Http::request(url, "GET", fmt::format("/ac/{}", key), "", timeout_ms);
+    if (res.ok()) {
+        num_hits++;
+        out_data = std::move(res.body);
+        return true;
+    } else if (res.status == 0) {
+        disable(res.error);
+    } else if (res.status >= 500) {
+        disable(fmt::format("GET returned HTTP status {}", res.status));
+    } else {
+        num_misses++;
+    }
+    return false;
+}
+
+void RemoteCache::put(const std::string& key, const std::string& data) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (disabled) {
+        return;
+    }
+    const HttpResponse res = Http::request(url, "PUT", fmt::format("/ac/{}", key), data, timeout_ms);
+    if (res.ok()) {
+        num_puts++;
+    } else if (res.status == 0) {
+        disable(res.error);
+    } else {
+        disable(fmt::format("PUT returned HTTP status {}", res.status));
+    }
+}
+
+void RemoteCache::dump_debug() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    fmt::print(stderr, "RemoteCache '{}:{}{}': {} hits, {} misses, {} puts{}\n\n",
+        url.host, url.port, url.path, num_hits, num_misses, num_puts, disabled ? " (disabled)" : "");
+}
+
+TieredCache::TieredCache(std::shared_ptr<ArtifactCache> l, std::shared_ptr<ArtifactCache> r): local(l), remote(r) { };
+
+bool TieredCache::get(const std::string& key, std::string& out_data) {
+    if (local->get(key, out_data)) {
+        return true;
+    }
+    if (remote->get(key, out_data)) {
+        local->put(key, out_data);
+        return true;
+    }
+    return false;
+}
+
+void TieredCache::put(const std::string& key, const std::string& data) {
+    local->put(key, data);
+    remote->put(key, data);
+}
+
+void TieredCache::dump_debug() const {
+    local->dump_debug();
+    remote->dump_debug();
+}
+
+} // namespace shdc
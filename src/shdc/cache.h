@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <mutex>
+#include "http.h"
+
+namespace shdc {
+
+struct Args;
+
+// persistent content-addressed store for compilation results (SPIRV blobs and
+// bytecode) which is shared between sokol-shdc runs, keys are SHA-256 hex strings
+// of everything which affects a result, so entries never need to be invalidated
+class ArtifactCache {
+public:
+    virtual ~ArtifactCache() {};
+    // returns false on a cache miss
+    virtual bool get(const std::string& key, std::string& out_data) = 0;
+    virtual void put(const std::string& key, const std::string& data) = 0;
+    virtual void dump_debug() const { };
+    // build the key for a kind of artifact (e.g. "spirv") from all its inputs
+    static std::string key(const std::string& kind, const std::string& inputs);
+    // create the cache for --cache-dir and --remote-cache, nullptr if neither is set
+    static std::shared_ptr<ArtifactCache> create(const Args& args);
+};
+
+// one file per entry in [dir]/[first 2 key chars]/[key]
+class DiskCache: public ArtifactCache {
+public:
+    DiskCache(const std::string& dir);
+    virtual bool get(const std::string& key, std::string& out_data);
+    virtual void put(const std::string& key, const std::string& data);
+    virtual void dump_debug() const;
+private:
+    std::string entry_path(const std::string& key) const;
+    std::string dir;
+    int num_hits = 0;
+    int num_misses = 0;
+};
+
+// bazel-remote style HTTP cache (GET and PUT of [url]/ac/[key]), any connection
+// error, timeout or server error disables the remote cache for the rest of the run
+class RemoteCache: public ArtifactCache {
+public:
+    RemoteCache(const HttpUrl& url, int timeout_ms);
+    virtual bool get(const std::string& key, std::string& out_data);
+    virtual void put(const std::string& key, const std::string& data);
+    virtual void dump_debug() const;
+private:
+    void disable(const std::string& reason);
+    HttpUrl url;
+    int timeout_ms;
+    mutable std::mutex mutex;
+    bool disabled = false;
+    int num_hits = 0;
+    int num_misses = 0;
+    int num_puts = 0;
+};
+
+// a local cache in front of a remote cache, remote hits are copied into the local cache
+class TieredCache: public ArtifactCache {
+public:
+    TieredCache(std::shared_ptr<ArtifactCache> local, std::shared_ptr<ArtifactCache> remote);
+    virtual bool get(const std::string& key, std::string& out_data);
+    virtual void put(const std::string& key, const std::string& data);
+    virtual void dump_debug() const;
+private:
+    std::shared_ptr<ArtifactCache> local;
+    std::shared_ptr<ArtifactCache> remote;
+};
+
+} // namespace shdc
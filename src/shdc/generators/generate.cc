@@ -14,7 +14,9 @@
 #include "sokolc2.h"
 #include "sokolc3.h"
 #include "yaml.h"
+#include "pack.h"
 #include <memory>
+#include <thread>
 
 namespace shdc::gen {
 
@@ -40,13 +42,57 @@ std::unique_ptr<Generator> make_generator(Format::Enum format) {
             return std::make_unique<BareGenerator>();
         case Format::BARE_YAML:
             return std::make_unique<YamlGenerator>();
+        case Format::SOKOL_PACK:
+            return std::make_unique<PackGenerator>();
         default:
             return std::make_unique<SokolCGenerator>();
     }
 }
 
-ErrMsg generate(Format::Enum format, const GenInput& gen_input) {
-    return make_generator(format)->generate(gen_input);
+// generators only read the shared compiler outputs in GenInput and write their own
+// output files, so with several output formats each generator runs on its own thread
+ErrMsg generate(const GenInput& gen_input, std::vector<std::string>& out_output_files) {
+    std::map<std::string, std::string> captured_files;
+    return generate(gen_input, OutputSink::File, out_output_files, captured_files);
+}
+
+ErrMsg generate(const GenInput& gen_input, OutputSink::Mode output_mode, std::vector<std::string>& out_output_files, std::map<std::string, std::string>& out_captured_files) {
+    const size_t num = gen_input.args.output_formats.size();
+    std::vector<Args> args(num);
+    std::vector<std::unique_ptr<Generator>> generators(num);
+    std::vector<ErrMsg> errors(num);
+    for (size_t i = 0; i < num; i++) {
+        args[i] = gen_input.args.with_output_format(i);
+        generators[i] = make_generator(args[i].output_format);
+        generators[i]->set_output_mode(output_mode);
+    }
+    auto run = [&](size_t i) {
+        const GenInput gen(args[i], gen_input.inp, gen_input.spirvcross, gen_input.bytecode, gen_input.refl, gen_input.analysis);
+        errors[i] = generators[i]->generate(gen);
+    };
+    if (num == 1) {
+        run(0);
+    } else {
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < num; i++) {
+            threads.emplace_back(run, i);
+        }
+        for (std::thread& thread: threads) {
+            thread.join();
+        }
+    }
+    out_output_files.clear();
+    out_captured_files.clear();
+    for (size_t i = 0; i < num; i++) {
+        if (errors[i].valid()) {
+            return errors[i];
+        }
+        const std::vector<std::string>& files = generators[i]->get_output_files();
+        out_output_files.insert(out_output_files.end(), files.begin(), files.end());
+        const std::map<std::string, std::string>& captured_files = generators[i]->get_captured_files();
+        out_captured_files.insert(captured_files.begin(), captured_files.end());
+    }
+    return ErrMsg();
 }
 
 } // namespace
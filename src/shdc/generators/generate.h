@@ -1,10 +1,18 @@
 #pragma once
 #include "types/gen_input.h"
 #include "types/errmsg.h"
-#include "types/format.h"
+#include "sink.h"
+#include <string>
+#include <vector>
+#include <map>
 
 namespace shdc::gen {
 
-ErrMsg generate(Format::Enum format, const GenInput& gen_input);
+// runs the code generators for all output formats in gen_input.args.output_formats,
+// out_output_files receives the paths of all generated files (for the dep-file)
+ErrMsg generate(const GenInput& gen_input, std::vector<std::string>& out_output_files);
+// same, but with OutputSink::Memory the generated files are not written but returned
+// in out_captured_files (path => content)
+ErrMsg generate(const GenInput& gen_input, OutputSink::Mode output_mode, std::vector<std::string>& out_output_files, std::map<std::string, std::string>& out_captured_files);
 
 }
@@ -2,7 +2,11 @@
     Generator base class implementation.
 */
 #include "generator.h"
+#include "util.h"
 #include "pystring.h"
+#include <string.h>
+#include <algorithm>
+#include <functional>
 
 using namespace shdc::refl;
 
@@ -19,11 +23,15 @@ ErrMsg Generator::generate(const GenInput& gen) {
     gen_prerequisites(gen);
     gen_vertex_attr_consts(gen);
     gen_bind_slot_consts(gen);
+    gen_shader_hash_consts(gen);
     gen_uniform_block_decls(gen);
     gen_storage_buffer_decls(gen);
     gen_stb_impl_start(gen);
     gen_shader_arrays(gen);
     gen_shader_desc_funcs(gen);
+    if (gen.args.registry) {
+        gen_program_registry(gen);
+    }
     if (gen.args.reflection) {
         gen_reflection_funcs(gen);
     }
@@ -46,13 +54,93 @@ Generator::ShaderStageArrayInfo Generator::shader_stage_array_info(const GenInpu
     }
     info.bytecode_array_name = shader_bytecode_array_name(prog.stage(stage).snippet_name, slang);
     info.source_array_name = shader_source_array_name(prog.stage(stage).snippet_name, slang);
+    // redirect to a shared array if gen_shader_arrays() has found an identical array
+    if (array_aliases.count(info.bytecode_array_name) > 0) {
+        info.bytecode_array_name = array_aliases.at(info.bytecode_array_name);
+    }
+    if (array_aliases.count(info.source_array_name) > 0) {
+        info.source_array_name = array_aliases.at(info.source_array_name);
+    }
     return info;
 }
 
-// default behaviour of begin is to clear the generated content string, and check for error in GenInput
+// a string with everything in the program's bindings which affects the sg_shader_desc
+static std::string bindings_layout(const Bindings& bindings) {
+    std::string str;
+    for (const UniformBlock& ub: bindings.uniform_blocks) {
+        str += fmt::format("ub:{}:{}:{}:{}:{}:{}:{}:{}:{}\n", ub.sokol_slot, (int)ub.stage, ub.name, ub.struct_info.size, ub.flattened,
+            ub.hlsl_register_b_n, ub.msl_buffer_n, ub.wgsl_group0_binding_n, ub.spirv_set0_binding_n);
+        for (const Type& item: ub.struct_info.struct_items) {
+            str += fmt::format("ubitem:{}:{}:{}:{}\n", item.name, (int)item.type, item.array_count, item.offset);
+        }
+    }
+    for (const StorageBuffer& sbuf: bindings.storage_buffers) {
+        str += fmt::format("sbuf:{}:{}:{}:{}:{}:{}:{}:{}:{}:{}\n", sbuf.sokol_slot, (int)sbuf.stage, sbuf.name, sbuf.readonly,
+            sbuf.hlsl_register_t_n, sbuf.hlsl_register_u_n, sbuf.msl_buffer_n, sbuf.wgsl_group1_binding_n, sbuf.spirv_set1_binding_n, sbuf.glsl_binding_n);
+    }
+    for (const StorageImage& simg: bindings.storage_images) {
+        str += fmt::format("simg:{}:{}:{}:{}:{}:{}:{}:{}:{}:{}:{}\n", simg.sokol_slot, (int)simg.stage, simg.name, (int)simg.type, simg.writeonly,
+            StoragePixelFormat::to_str(simg.access_format), simg.hlsl_register_u_n, simg.msl_texture_n, simg.wgsl_group1_binding_n, simg.spirv_set1_binding_n, simg.glsl_binding_n);
+    }
+    for (const Texture& tex: bindings.textures) {
+        str += fmt::format("tex:{}:{}:{}:{}:{}:{}:{}:{}:{}:{}\n", tex.sokol_slot, (int)tex.stage, tex.name, (int)tex.type, (int)tex.sample_type, tex.multisampled,
+            tex.hlsl_register_t_n, tex.msl_texture_n, tex.wgsl_group1_binding_n, tex.spirv_set1_binding_n);
+    }
+    for (const Sampler& smp: bindings.samplers) {
+        str += fmt::format("smp:{}:{}:{}:{}:{}:{}:{}:{}\n", smp.sokol_slot, (int)smp.stage, smp.name, (int)smp.type,
+            smp.hlsl_register_s_n, smp.msl_sampler_n, smp.wgsl_group1_binding_n, smp.spirv_set1_binding_n);
+    }
+    for (const TextureSampler& tex_smp: bindings.texture_samplers) {
+        str += fmt::format("texsmp:{}:{}:{}:{}:{}\n", tex_smp.sokol_slot, (int)tex_smp.stage, tex_smp.name, tex_smp.texture_name, tex_smp.sampler_name);
+    }
+    return str;
+}
+
+uint64_t Generator::shader_content_hash(const GenInput& gen, const ProgramReflection& prog, ShaderStage::Enum stage, Slang::Enum slang) {
+    const StageReflection& refl = prog.stage(stage);
+    if (refl.stage == ShaderStage::Invalid) {
+        return 0;
+    }
+    uint64_t hash;
+    const BytecodeBlob* blob = gen.bytecode[slang].find_blob_by_snippet_index(refl.snippet_index);
+    if (blob) {
+        hash = util::hash64(blob->data.data(), blob->data.size());
+    } else {
+        const SpirvcrossSource* src = gen.spirvcross[slang].find_source_by_snippet_index(refl.snippet_index);
+        assert(src);
+        hash = util::hash64(src->source_code.data(), src->source_code.length());
+    }
+    const std::string entry_point = refl.entry_point_by_slang(slang);
+    hash = util::hash64(entry_point.data(), entry_point.length(), hash);
+    const std::string layout = bindings_layout(prog.bindings);
+    hash = util::hash64(layout.data(), layout.length(), hash);
+    return hash;
+}
+
+uint64_t Generator::program_content_hash(const GenInput& gen, const ProgramReflection& prog, Slang::Enum slang) {
+    uint64_t hash = util::hash64(nullptr, 0);
+    for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
+        const uint64_t stage_hash = shader_content_hash(gen, prog, ShaderStage::from_index(stage_index), slang);
+        // hash the stage hashes in little-endian byte order, so the result doesn't depend on the host
+        uint8_t bytes[8];
+        for (int i = 0; i < 8; i++) {
+            bytes[i] = (uint8_t)(stage_hash >> (i * 8));
+        }
+        hash = util::hash64(bytes, sizeof(bytes), hash);
+    }
+    return hash;
+}
+
+// default behaviour of begin is to check for errors in GenInput and open the output sink
 ErrMsg Generator::begin(const GenInput& gen) {
-    content.clear();
-    return check_errors(gen);
+    embed_files.clear();
+    shared_arrays.clear();
+    array_aliases.clear();
+    ErrMsg err = check_errors(gen);
+    if (err.valid()) {
+        return err;
+    }
+    return open_output(gen, content, gen.args.output, true);
 }
 
 // for anything written at the top of the file
@@ -84,6 +172,9 @@ void Generator::gen_header(const GenInput& gen) {
         cbl_open("Shader program: '{}':\n", prog.name);
         cbl("Get shader desc: {}", get_shader_desc_help(prog.name));
         gen_program_info(gen, prog);
+        if (!gen.args.analysis_file.empty()) {
+            gen_cost_info(gen, prog);
+        }
         cbl_close();
     }
     cbl_open("Bindings:\n");
@@ -118,6 +209,38 @@ void Generator::gen_program_info(const GenInput& gen, const ProgramReflection& p
     }
 }
 
+void Generator::gen_cost_info(const GenInput& gen, const ProgramReflection& prog) {
+    for (int i = 0; i < ShaderStage::Num; i++) {
+        const StageReflection& refl = prog.stages[i];
+        if (refl.stage == ShaderStage::Invalid) {
+            continue;
+        }
+        const ShaderCost* cost = gen.analysis.find_cost_by_snippet_index(refl.snippet_index);
+        if (nullptr == cost) {
+            continue;
+        }
+        cbl_open("Cost estimate ({} shader '{}'):\n", ShaderStage::to_str(refl.stage), refl.snippet_name);
+        cbl("Instructions: {}, ALU ops: {}, transcendentals: {}\n", cost->instructions, cost->alu_ops, cost->transcendental_ops);
+        cbl("Texture samples: {} ({} dependent)\n", cost->texture_samples, cost->dependent_texture_reads);
+        cbl("Loops: {}, branches: {}, discards: {}\n", cost->loops, cost->branches, cost->discards);
+        if ((cost->storage_loads > 0) || (cost->storage_stores > 0) || (cost->shared_memory_bytes > 0)) {
+            cbl("Storage loads: {}, stores: {}, shared memory: {} bytes\n", cost->storage_loads, cost->storage_stores, cost->shared_memory_bytes);
+        }
+        cbl("Live values: ~{}\n", cost->live_values);
+        for (int si = 0; si < Slang::Num; si++) {
+            const Slang::Enum slang = Slang::from_index(si);
+            if (gen.args.slang & Slang::bit(slang)) {
+                if (cost->slang_sizes[si].bytecode_bytes > 0) {
+                    cbl("{}: {} bytes source, {} bytes bytecode\n", Slang::to_str(slang), cost->slang_sizes[si].source_bytes, cost->slang_sizes[si].bytecode_bytes);
+                } else {
+                    cbl("{}: {} bytes source\n", Slang::to_str(slang), cost->slang_sizes[si].source_bytes);
+                }
+            }
+        }
+        cbl_close();
+    }
+}
+
 void Generator::gen_bindings_info(const GenInput& gen) {
     for (const UniformBlock& ub: gen.refl.bindings.uniform_blocks) {
         cbl_open("Uniform block '{}':\n", ub.name);
@@ -186,6 +309,22 @@ void Generator::gen_bind_slot_consts(const GenInput& gen) {
     }
 }
 
+void Generator::gen_shader_hash_consts(const GenInput& gen) {
+    for (const ProgramReflection& prog: gen.refl.progs) {
+        for (int slang_idx = 0; slang_idx < Slang::Num; slang_idx++) {
+            Slang::Enum slang = Slang::from_index(slang_idx);
+            if (gen.args.slang & Slang::bit(slang)) {
+                for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
+                    const ShaderStage::Enum stage = ShaderStage::from_index(stage_index);
+                    if (prog.stage(stage).stage != ShaderStage::Invalid) {
+                        l("{}\n", shader_hash_definition(prog.name, stage, slang, shader_content_hash(gen, prog, stage, slang)));
+                    }
+                }
+            }
+        }
+    }
+}
+
 void Generator::gen_uniform_block_decls(const GenInput& gen) {
     for (const UniformBlock& ub: gen.refl.bindings.uniform_blocks) {
         gen_uniform_block_decl(gen, ub);
@@ -202,57 +341,268 @@ void Generator::gen_shader_arrays(const GenInput& gen) {
     for (int slang_idx = 0; slang_idx < Slang::Num; slang_idx++) {
         Slang::Enum slang = Slang::from_index(slang_idx);
         if (gen.args.slang & Slang::bit(slang)) {
-            const Spirvcross& spirvcross = gen.spirvcross[slang];
-            const Bytecode& bytecode = gen.bytecode[slang];
-            for (int snippet_index = 0; snippet_index < (int)gen.inp.snippets.size(); snippet_index++) {
-                const Snippet& snippet = gen.inp.snippets[snippet_index];
-                if ((snippet.type != Snippet::VS) && (snippet.type != Snippet::FS) && (snippet.type != Snippet::CS)) {
-                    continue;
-                }
-                const SpirvcrossSource* src = spirvcross.find_source_by_snippet_index(snippet_index);
-                assert(src);
-                const BytecodeBlob* blob = bytecode.find_blob_by_snippet_index(snippet_index);
-                std::vector<std::string> lines;
-                pystring::splitlines(src->source_code, lines);
-                // first write the source code in a comment block
-                cbl_start();
-                for (const std::string& line: lines) {
-                    cbl("{}\n", fix_shader_source_for_code_comment(line));
-                }
-                cbl_end();
-                if (blob) {
-                    const std::string array_name = shader_bytecode_array_name(snippet.name, slang);
-                    gen_shader_array_start(gen, array_name, blob->data.size(), slang);
-                    const size_t len = blob->data.size();
-                    for (size_t i = 0; i < len; i++) {
-                        if ((i & 15) == 0) {
-                            l("    ");
-                        }
-                        l("{:#04x},", blob->data[i]);
-                        if ((i & 15) == 15) {
-                            l("\n");
-                        }
-                    }
-                    gen_shader_array_end(gen);
+            gen_slang_shader_arrays(gen, slang);
+        }
+    }
+}
+
+void Generator::gen_slang_shader_arrays(const GenInput& gen, Slang::Enum slang) {
+    const Spirvcross& spirvcross = gen.spirvcross[slang];
+    const Bytecode& bytecode = gen.bytecode[slang];
+    for (int snippet_index = 0; snippet_index < (int)gen.inp.snippets.size(); snippet_index++) {
+        const Snippet& snippet = gen.inp.snippets[snippet_index];
+        if ((snippet.type != Snippet::VS) && (snippet.type != Snippet::FS) && (snippet.type != Snippet::CS)) {
+            continue;
+        }
+        const SpirvcrossSource* src = spirvcross.find_source_by_snippet_index(snippet_index);
+        assert(src);
+        const BytecodeBlob* blob = bytecode.find_blob_by_snippet_index(snippet_index);
+        // if no bytecode exists, write the source code, but also a byte array with a trailing 0
+        const bool is_source = (blob == nullptr);
+        const std::string array_name = is_source ? shader_source_array_name(snippet.name, slang) : shader_bytecode_array_name(snippet.name, slang);
+        const uint8_t* data = is_source ? (const uint8_t*)src->source_code.c_str() : blob->data.data();
+        const size_t num_bytes = is_source ? (src->source_code.length() + 1) : blob->data.size();
+        // skip arrays which are identical to an already written array (e.g. metal_ios vs metal_sim),
+        // the shader desc functions will reference the already written array instead
+        const std::string* shared_name = find_shared_array(gen, data, num_bytes, is_source, slang);
+        if (shared_name) {
+            array_aliases[array_name] = *shared_name;
+            continue;
+        }
+        SharedArray shared;
+        shared.name = array_name;
+        shared.group = shader_array_group(gen, slang);
+        shared.data = data;
+        shared.num_bytes = num_bytes;
+        shared.is_source = is_source;
+        shared_arrays.insert({ util::hash64(data, num_bytes), shared });
+        // first write the source code in a comment block (redundant for string-encoded source code)
+        if (!is_source || (gen.args.array_encoding != ArrayEncoding::STRING)) {
+            std::vector<std::string> lines;
+            pystring::splitlines(src->source_code, lines);
+            cbl_start();
+            for (const std::string& line: lines) {
+                cbl("{}\n", fix_shader_source_for_code_comment(line));
+            }
+            cbl_end();
+        }
+        const std::string file_path = shader_file_path(gen, snippet.name, ShaderStage::to_str(ShaderStage::from_snippet_type(snippet.type)), slang, !is_source);
+        gen_shader_array(gen, array_name, file_path, data, num_bytes, is_source, slang);
+    }
+}
+
+static const char* slang_file_extension(Slang::Enum c, bool binary) {
+    if (Slang::is_glsl(c)) {
+        return ".glsl";
+    }
+    if (Slang::is_hlsl(c)) {
+        return binary ? ".fxc" : ".hlsl";
+    }
+    if (Slang::is_msl(c)) {
+        return binary ? ".metallib" : ".metal";
+    }
+    if (Slang::is_wgsl(c)) {
+        return ".wgsl";
+    }
+    return "";
+}
+
+std::string Generator::shader_file_path(const GenInput& gen, const std::string& name, const std::string& stage_name, Slang::Enum slang, bool is_binary) {
+    return fmt::format("{}_{}{}_{}_{}{}",
+        gen.args.output,
+        gen.inp.module.empty() ? "" : fmt::format("{}_", gen.inp.module),
+        name,
+        Slang::to_str(slang),
+        pystring::lower(stage_name),
+        slang_file_extension(slang, is_binary));
+}
+
+// find an already written shader array with identical content, returns the array name or nullptr
+const std::string* Generator::find_shared_array(const GenInput& gen, const uint8_t* data, size_t num_bytes, bool is_source, Slang::Enum slang) {
+    const std::string group = shader_array_group(gen, slang);
+    const auto range = shared_arrays.equal_range(util::hash64(data, num_bytes));
+    for (auto it = range.first; it != range.second; ++it) {
+        const SharedArray& shared = it->second;
+        if ((shared.group == group) &&
+            (shared.is_source == is_source) &&
+            (shared.num_bytes == num_bytes) &&
+            (0 == memcmp(shared.data, data, num_bytes)))
+        {
+            return &shared.name;
+        }
+    }
+    return nullptr;
+}
+
+// write a single shader source or bytecode array, for source arrays, num_bytes includes the trailing 0
+void Generator::gen_shader_array(const GenInput& gen, const std::string& array_name, const std::string& file_path, const uint8_t* data, size_t num_bytes, bool is_source, Slang::Enum slang) {
+    switch (gen.args.array_encoding) {
+        case ArrayEncoding::STRING:
+            // string literals have an implicit trailing 0, which must fit into the array in C++
+            if (is_source) {
+                gen_shader_array_start(gen, array_name, num_bytes, slang);
+                string_literal_bytes(data, num_bytes - 1, true);
+            } else {
+                gen_shader_array_start(gen, array_name, num_bytes + 1, slang);
+                string_literal_bytes(data, num_bytes, false);
+            }
+            gen_shader_array_end(gen);
+            break;
+        case ArrayEncoding::EMBED:
+            // sidecar files keep the trailing 0 of source arrays, since not all
+            // embed facilities guarantee a zero-terminated result
+            embed_files[file_path] = std::string((const char*)data, num_bytes);
+            gen_shader_array_embed(gen, array_name, pystring::os::path::basename(file_path), num_bytes, slang);
+            break;
+        default:
+            gen_shader_array_start(gen, array_name, num_bytes, slang);
+            hex_bytes(data, num_bytes);
+            gen_shader_array_end(gen);
+            break;
+    }
+}
+
+// #embed paths are resolved relative to the including file
+void Generator::gen_shader_array_embed(const GenInput& gen, const std::string& array_name, const std::string& file_name, size_t num_bytes, Slang::Enum slang) {
+    gen_shader_array_start(gen, array_name, num_bytes, slang);
+    l("#embed \"{}\"", file_name);
+    gen_shader_array_end(gen);
+}
+
+// write bytes as '0xXX,' with 16 bytes per line directly into the output sink, in chunks
+// of whole lines so that large arrays don't need to be buffered at once,
+// the last line isn't terminated with a newline
+void Generator::hex_bytes(const uint8_t* data, size_t num_bytes, const std::string& first_item_suffix) {
+    static const char* hex_digits = "0123456789abcdef";
+    static const size_t chunk_size = 16 * 256;
+    const size_t line_prefix_len = indentation.length() + 4;
+    for (size_t chunk_start = 0; chunk_start < num_bytes; chunk_start += chunk_size) {
+        const size_t num_chunk_bytes = std::min(chunk_size, num_bytes - chunk_start);
+        const size_t num_lines = (num_chunk_bytes + 15) / 16;
+        const size_t suffix_len = (chunk_start == 0) ? first_item_suffix.length() : 0;
+        const size_t num_chars = num_lines * line_prefix_len + num_chunk_bytes * 5 + num_chunk_bytes / 16 + suffix_len;
+        char* dst = content.reserve(num_chars);
+        const char* dst_end = dst + num_chars;
+        for (size_t i = 0; i < num_chunk_bytes; i++) {
+            if ((i & 15) == 0) {
+                memcpy(dst, indentation.data(), indentation.length());
+                memset(dst + indentation.length(), ' ', 4);
+                dst += line_prefix_len;
+            }
+            const uint8_t b = data[chunk_start + i];
+            dst[0] = '0';
+            dst[1] = 'x';
+            dst[2] = hex_digits[b >> 4];
+            dst[3] = hex_digits[b & 15];
+            dst += 4;
+            if ((i == 0) && (suffix_len > 0)) {
+                memcpy(dst, first_item_suffix.data(), suffix_len);
+                dst += suffix_len;
+            }
+            *dst++ = ',';
+            if ((i & 15) == 15) {
+                *dst++ = '\n';
+            }
+        }
+        assert(dst == dst_end);
+        (void)dst_end;
+    }
+}
+
+// write bytes as one or more C string literals, either split at newlines (for source code)
+// or every 64 bytes (for bytecode), the last line isn't terminated with a newline,
+// non-printable characters are written as 3-digit octal escape sequences
+void Generator::string_literal_bytes(const uint8_t* data, size_t num_bytes, bool split_at_newlines) {
+    std::string line;
+    size_t line_bytes = 0;
+    bool first_line = true;
+    const auto flush = [&]() {
+        if (!first_line) {
+            content.push_back('\n');
+        }
+        content.append(indentation);
+        content.append("    \"");
+        content.append(line);
+        content.push_back('"');
+        line.clear();
+        line_bytes = 0;
+        first_line = false;
+    };
+    for (size_t i = 0; i < num_bytes; i++) {
+        const uint8_t c = data[i];
+        switch (c) {
+            case '\n':  line.append("\\n"); break;
+            case '\t':  line.append("\\t"); break;
+            case '"':   line.append("\\\""); break;
+            case '\\':  line.append("\\\\"); break;
+            // avoid trigraphs
+            case '?':   line.append("\\?"); break;
+            default:
+                if ((c >= 0x20) && (c < 0x7F)) {
+                    line.push_back((char)c);
                 } else {
-                    // if no bytecode exists, write the source code, but also a byte array with a trailing 0
-                    const std::string array_name = shader_source_array_name(snippet.name, slang);
-                    const size_t len = src->source_code.length() + 1;
-                    gen_shader_array_start(gen, array_name, len, slang);
-                    for (size_t i = 0; i < len; i++) {
-                        if ((i & 15) == 0) {
-                            l("    ");
-                        }
-                        l("{:#04x},", (int)src->source_code[i]);
-                        if ((i & 15) == 15) {
-                            l("\n");
-                        }
-                    }
-                    gen_shader_array_end(gen);
+                    line.push_back('\\');
+                    line.push_back((char)('0' + ((c >> 6) & 7)));
+                    line.push_back((char)('0' + ((c >> 3) & 7)));
+                    line.push_back((char)('0' + (c & 7)));
                 }
+                break;
+        }
+        line_bytes++;
+        if (split_at_newlines ? (c == '\n') : (line_bytes == 64)) {
+            flush();
+        }
+    }
+    if ((line_bytes > 0) || first_line) {
+        flush();
+    }
+}
+
+void Generator::gen_designated_initializer(const std::vector<std::pair<std::string, std::string>>& items) {
+    struct Node {
+        std::string designator;     // '.name' or '[index]'
+        std::string value;
+        std::vector<Node> children;
+    };
+    Node root;
+    for (const auto& item: items) {
+        const std::string& path = item.first;
+        Node* node = &root;
+        size_t pos = 0;
+        while (pos < path.size()) {
+            size_t end = path.find_first_of(".[", pos + 1);
+            if (end == std::string::npos) {
+                end = path.size();
+            }
+            std::string designator = path.substr(pos, end - pos);
+            if ((designator[0] != '.') && (designator[0] != '[')) {
+                designator = "." + designator;
+            }
+            auto it = std::find_if(node->children.begin(), node->children.end(), [&designator](const Node& child) {
+                return child.designator == designator;
+            });
+            if (it == node->children.end()) {
+                node->children.push_back({ designator, "", {} });
+                node = &node->children.back();
+            } else {
+                node = &(*it);
             }
+            pos = end;
         }
+        node->value = item.second;
     }
+    const std::function<void(const Node&)> gen_node = [this, &gen_node](const Node& node) {
+        for (const Node& child: node.children) {
+            if (child.children.empty()) {
+                l("{} = {},\n", child.designator, child.value);
+            } else {
+                l_open("{} = {{\n", child.designator);
+                gen_node(child);
+                l_close("}},\n");
+            }
+        }
+    };
+    gen_node(root);
 }
 
 void Generator::gen_shader_desc_funcs(const GenInput& gen) {
@@ -277,15 +627,44 @@ void Generator::gen_reflection_funcs(const GenInput& gen) {
 
 // default behaviour of end() is to write the output file
 ErrMsg Generator::end(const GenInput& gen) {
-    FILE* f = fopen(gen.args.output.c_str(), "w");
-    if (!f) {
-        return ErrMsg::error(gen.inp.base_path, 0, fmt::format("failed to open output file '{}'", gen.args.output));
+    for (const auto& [path, data]: embed_files) {
+        ErrMsg err = write_output_file(gen, path, data.data(), data.size(), false);
+        if (err.valid()) {
+            return err;
+        }
+    }
+    return close_output(gen, content);
+}
+
+ErrMsg Generator::open_output(const GenInput& gen, OutputSink& sink, const std::string& path, bool is_text) {
+    if (!sink.open(output_mode, path, is_text, *gen.args.vfs)) {
+        return ErrMsg::error(gen.inp.base_path, 0, fmt::format("failed to open output file '{}'", path));
     }
-    fwrite(content.c_str(), content.length(), 1, f);
-    fclose(f);
     return ErrMsg();
 }
 
+ErrMsg Generator::close_output(const GenInput& gen, OutputSink& sink) {
+    if (!sink.close()) {
+        return ErrMsg::error(gen.inp.base_path, 0, fmt::format("failed to write output file '{}'", sink.path()));
+    }
+    output_files.push_back(sink.path());
+    output_hashes[sink.path()] = sink.hash();
+    if (sink.mode() == OutputSink::Memory) {
+        captured_files[sink.path()] = std::move(sink.data());
+    }
+    return ErrMsg();
+}
+
+ErrMsg Generator::write_output_file(const GenInput& gen, const std::string& path, const void* data, size_t num_bytes, bool is_text) {
+    OutputSink sink;
+    ErrMsg err = open_output(gen, sink, path, is_text);
+    if (err.valid()) {
+        return err;
+    }
+    sink.append((const char*)data, num_bytes);
+    return close_output(gen, sink);
+}
+
 // check that each input shader has the expected stage shaders
 ErrMsg Generator::check_errors(const GenInput& gen) {
     for (int i = 0; i < Slang::Num; i++) {
@@ -1,7 +1,10 @@
 #pragma once
 #include <string>
+#include <map>
+#include <vector>
 #include "pystring.h"
 #include "types/gen_input.h"
+#include "sink.h"
 
 namespace shdc::gen {
 
@@ -10,6 +13,18 @@ class Generator {
 public:
     virtual ~Generator() {};
     virtual ErrMsg generate(const GenInput& gen);
+    // all files written by generate(), including unchanged files which were not rewritten
+    const std::vector<std::string>& get_output_files() const { return output_files; };
+    // by default output files are written to disk, alternatively they can be captured in memory or only hashed
+    void set_output_mode(OutputSink::Mode mode) { output_mode = mode; };
+    // output file content in OutputSink::Memory mode (path => content)
+    const std::map<std::string, std::string>& get_captured_files() const { return captured_files; };
+    // content hashes of all output files (path => hash)
+    const std::map<std::string, uint64_t>& get_output_hashes() const { return output_hashes; };
+    // stable 64-bit hash of a program's shader stage code and binding layout, for runtime pipeline caches
+    static uint64_t shader_content_hash(const GenInput& gen, const refl::ProgramReflection& prog, ShaderStage::Enum stage, Slang::Enum slang);
+    // combined content hash of all shader stages of a program
+    static uint64_t program_content_hash(const GenInput& gen, const refl::ProgramReflection& prog, Slang::Enum slang);
 
 protected:
     // called directly by generate() in this order
@@ -19,11 +34,13 @@ protected:
     virtual void gen_prerequisites(const GenInput& gen);
     virtual void gen_vertex_attr_consts(const GenInput& gen);
     virtual void gen_bind_slot_consts(const GenInput& gen);
+    virtual void gen_shader_hash_consts(const GenInput& gen);
     virtual void gen_uniform_block_decls(const GenInput& gen);
     virtual void gen_storage_buffer_decls(const GenInput& gen);
     virtual void gen_stb_impl_start(const GenInput& gen) { };
     virtual void gen_shader_arrays(const GenInput& gen);
     virtual void gen_shader_desc_funcs(const GenInput& gen);
+    virtual void gen_program_registry(const GenInput& gen) { };
     virtual void gen_reflection_funcs(const GenInput& gen);
     virtual void gen_epilog(const GenInput& gen);
     virtual void gen_stb_impl_end(const GenInput& gen) { };
@@ -32,6 +49,7 @@ protected:
     // called by gen_header()
     virtual void gen_program_info(const GenInput& gen, const refl::ProgramReflection& prog);
     virtual void gen_bindings_info(const GenInput& gen);
+    virtual void gen_cost_info(const GenInput& gen, const refl::ProgramReflection& prog);
 
     // called by gen_uniform_block_decls()
     virtual void gen_uniform_block_decl(const GenInput& gen, const refl::UniformBlock& ub) { assert(false && "implement me"); };
@@ -40,8 +58,14 @@ protected:
     virtual void gen_storage_buffer_decl(const GenInput& gen, const refl::Type& sbuf_struct) { assert(false && "implement me"); };
 
     // called by gen_shader_arrays()
+    void gen_slang_shader_arrays(const GenInput& gen, Slang::Enum slang);
+    virtual void gen_shader_array(const GenInput& gen, const std::string& array_name, const std::string& file_path, const uint8_t* data, size_t num_bytes, bool is_source, Slang::Enum slang);
+    // --array-encoding=embed: declare an array which pulls in a sidecar file (default is C23 #embed)
+    virtual void gen_shader_array_embed(const GenInput& gen, const std::string& array_name, const std::string& file_name, size_t num_bytes, Slang::Enum slang);
     virtual void gen_shader_array_start(const GenInput& gen, const std::string& array_name, size_t num_bytes, Slang::Enum slang) { assert(false && "implement me"); };
     virtual void gen_shader_array_end(const GenInput& gen) { assert(false && "implement me"); };
+    // identical arrays are only shared within the same group (e.g. the same #ifdef block)
+    virtual std::string shader_array_group(const GenInput& gen, Slang::Enum slang) { return ""; };
 
     // called by gen_shader_desc_funcs()
     virtual void gen_shader_desc_func(const GenInput& gen, const refl::ProgramReflection& prog) { assert(false && "implement me"); };
@@ -83,6 +107,7 @@ protected:
     virtual std::string texture_bind_slot_name(const refl::Texture& tex) { assert(false && "implement me"); return ""; };
     virtual std::string sampler_bind_slot_name(const refl::Sampler& smp) { assert(false && "implement me"); return ""; };
     virtual std::string uniform_block_bind_slot_name(const refl::UniformBlock& ub) { assert(false && "implement me"); return ""; };
+    virtual std::string shader_hash_name(const std::string& prog_name, ShaderStage::Enum stage, Slang::Enum slang) { assert(false && "implement me"); return ""; };
     virtual std::string storage_buffer_bind_slot_name(const refl::StorageBuffer& sbuf) { assert(false && "implement me"); return ""; };
     virtual std::string storage_image_bind_slot_name(const refl::StorageImage& simg) { assert(false && "implement me"); return ""; };
 
@@ -92,6 +117,7 @@ protected:
     virtual std::string storage_image_bind_slot_definition(const refl::StorageImage& simg) { assert(false && "implement me"); return ""; };
     virtual std::string sampler_bind_slot_definition(const refl::Sampler& smp) { assert(false && "implement me"); return ""; };
     virtual std::string uniform_block_bind_slot_definition(const refl::UniformBlock& ub) { assert(false && "implement me"); return ""; };
+    virtual std::string shader_hash_definition(const std::string& prog_name, ShaderStage::Enum stage, Slang::Enum slang, uint64_t hash) { assert(false && "implement me"); return ""; };
 
     struct ShaderStageArrayInfo {
     public:
@@ -103,6 +129,7 @@ protected:
     };
     ShaderStageArrayInfo shader_stage_array_info(const GenInput& gen, const refl::ProgramReflection& prog, ShaderStage::Enum stage, Slang::Enum slang);
 
+
     // line output
     template<typename... T> void l(fmt::string_view fmt, T&&... args) {
         const std::string str = fmt::format("{}{}", indentation, fmt::format(fmt::runtime(fmt), std::forward<T>(args)...));
@@ -147,6 +174,27 @@ protected:
         l_close("{}\n", comment_block_end());
     }
 
+    // path of a shader source or bytecode file next to the output file, used by the bare
+    // output formats and for the sidecar files of --array-encoding=embed
+    static std::string shader_file_path(const GenInput& gen, const std::string& name, const std::string& stage_name, Slang::Enum slang, bool is_binary);
+
+    // open and close an output sink according to the output mode, closing records the file for the dep-file
+    ErrMsg open_output(const GenInput& gen, OutputSink& sink, const std::string& path, bool is_text);
+    ErrMsg close_output(const GenInput& gen, OutputSink& sink);
+    // write an in-memory output file through a temporary output sink
+    ErrMsg write_output_file(const GenInput& gen, const std::string& path, const void* data, size_t num_bytes, bool is_text);
+
+    const std::string* find_shared_array(const GenInput& gen, const uint8_t* data, size_t num_bytes, bool is_source, Slang::Enum slang);
+
+    // fast byte array output for embedded shader arrays (avoids per-byte string formatting),
+    // the optional suffix is appended to the first array item (e.g. a Nim type suffix)
+    void hex_bytes(const uint8_t* data, size_t num_bytes, const std::string& first_item_suffix = "");
+    void string_literal_bytes(const uint8_t* data, size_t num_bytes, bool split_at_newlines);
+
+    // write a nested aggregate initializer from a flat list of (path, value) items,
+    // where paths look like 'vertex_func.source' or 'attrs[0].glsl_name'
+    void gen_designated_initializer(const std::vector<std::pair<std::string, std::string>>& items);
+
     // utility methods
     static ErrMsg check_errors(const GenInput& gen);
     static int roundup(int val, int round_to);
@@ -156,7 +204,21 @@ protected:
     static std::string to_ada_case(const std::string& str);
     static const char* hlsl_target(Slang::Enum slang, ShaderStage::Enum stage);
 
-    std::string content;
+    OutputSink content;
+    OutputSink::Mode output_mode = OutputSink::File;
+    std::vector<std::string> output_files;
+    std::map<std::string, std::string> captured_files;
+    std::map<std::string, uint64_t> output_hashes;
+    std::map<std::string, std::string> embed_files;    // sidecar files for --array-encoding=embed (path => content)
+    struct SharedArray {
+        std::string name;
+        std::string group;
+        const uint8_t* data = nullptr;
+        size_t num_bytes = 0;
+        bool is_source = false;
+    };
+    std::multimap<uint64_t, SharedArray> shared_arrays;    // content hash => emitted shader arrays
+    std::map<std::string, std::string> array_aliases;       // array name => name of identical emitted array
     int tab_width = 4;
     std::string indentation;
 
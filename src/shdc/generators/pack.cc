@@ -0,0 +1,442 @@
+/*
+    Generate a binary shader archive with shader blobs and reflection info
+*/
+#include "pack.h"
+#include "fmt/format.h"
+#include "pystring.h"
+#include <stdio.h>
+#include <algorithm>
+#include <map>
+
+namespace shdc::gen {
+
+using namespace refl;
+
+// all values are written in little-endian byte order
+struct PackWriter {
+    std::vector<uint8_t> data;
+
+    void u32(uint32_t val) {
+        for (int i = 0; i < 4; i++) {
+            data.push_back((uint8_t)(val >> (i * 8)));
+        }
+    }
+    void i32(int val) {
+        u32((uint32_t)val);
+    }
+    void u64(uint64_t val) {
+        u32((uint32_t)val);
+        u32((uint32_t)(val >> 32));
+    }
+    void patch_u32(size_t pos, uint32_t val) {
+        for (int i = 0; i < 4; i++) {
+            data[pos + i] = (uint8_t)(val >> (i * 8));
+        }
+    }
+    void bytes(const void* ptr, size_t num_bytes) {
+        data.insert(data.end(), (const uint8_t*)ptr, (const uint8_t*)ptr + num_bytes);
+    }
+    void align(size_t alignment) {
+        data.resize((data.size() + alignment - 1) & ~(alignment - 1), 0);
+    }
+    uint32_t pos() const {
+        return (uint32_t)data.size();
+    }
+};
+
+// zero-terminated strings, referenced by their offset into the string table, offset 0 is the empty string
+struct PackStrings {
+    std::string data = std::string(1, '\0');
+    std::map<std::string, uint32_t> offsets;
+
+    uint32_t add(const std::string& str) {
+        if (str.empty()) {
+            return 0;
+        }
+        auto it = offsets.find(str);
+        if (it != offsets.end()) {
+            return it->second;
+        }
+        const uint32_t offset = (uint32_t)data.size();
+        data.append(str);
+        data.push_back('\0');
+        offsets[str] = offset;
+        return offset;
+    }
+};
+
+// enum values are written with the numeric value of the matching sokol_gfx.h enum
+static uint32_t sg_shader_stage(ShaderStage::Enum e) {
+    switch (e) {
+        case ShaderStage::Vertex:   return 1;
+        case ShaderStage::Fragment: return 2;
+        case ShaderStage::Compute:  return 3;
+        default: return 0;
+    }
+}
+
+static uint32_t sg_attr_basetype(Type::Enum e) {
+    switch (e) {
+        case Type::Float:   return 1;
+        case Type::Int:     return 2;
+        case Type::UInt:    return 3;
+        default: return 0;
+    }
+}
+
+static uint32_t sg_uniform_type(Type::Enum e) {
+    switch (e) {
+        case Type::Float:  return 1;
+        case Type::Float2: return 2;
+        case Type::Float3: return 3;
+        case Type::Float4: return 4;
+        case Type::Int:    return 5;
+        case Type::Int2:   return 6;
+        case Type::Int3:   return 7;
+        case Type::Int4:   return 8;
+        case Type::Mat4x4: return 9;
+        default: return 0;
+    }
+}
+
+static uint32_t sg_flattened_uniform_type(Type::Enum e) {
+    switch (e) {
+        case Type::Float:
+        case Type::Float2:
+        case Type::Float3:
+        case Type::Float4:
+        case Type::Mat4x4:
+            return sg_uniform_type(Type::Float4);
+        case Type::Int:
+        case Type::Int2:
+        case Type::Int3:
+        case Type::Int4:
+            return sg_uniform_type(Type::Int4);
+        default:
+            return 0;
+    }
+}
+
+static uint32_t sg_image_type(ImageType::Enum e) {
+    switch (e) {
+        case ImageType::_2D:    return 1;
+        case ImageType::CUBE:   return 2;
+        case ImageType::_3D:    return 3;
+        case ImageType::ARRAY:  return 4;
+        default: return 0;
+    }
+}
+
+static uint32_t sg_image_sample_type(ImageSampleType::Enum e) {
+    switch (e) {
+        case ImageSampleType::FLOAT:                return 1;
+        case ImageSampleType::DEPTH:                return 2;
+        case ImageSampleType::SINT:                 return 3;
+        case ImageSampleType::UINT:                 return 4;
+        case ImageSampleType::UNFILTERABLE_FLOAT:   return 5;
+        default: return 0;
+    }
+}
+
+static uint32_t sg_sampler_type(SamplerType::Enum e) {
+    switch (e) {
+        case SamplerType::FILTERING:    return 1;
+        case SamplerType::NONFILTERING: return 2;
+        case SamplerType::COMPARISON:   return 3;
+        default: return 0;
+    }
+}
+
+static const uint32_t SG_UNIFORMLAYOUT_STD140 = 2;
+
+struct PackUniform {
+    uint32_t type;
+    uint32_t array_count;
+    uint32_t glsl_name;
+};
+
+enum PackViewType {
+    PACK_VIEWTYPE_NONE = 0,
+    PACK_VIEWTYPE_TEXTURE = 1,
+    PACK_VIEWTYPE_STORAGEBUFFER = 2,
+    PACK_VIEWTYPE_STORAGEIMAGE = 3,
+};
+
+static void write_program(PackWriter& w, PackStrings& strings, std::vector<PackUniform>& glsl_uniforms, const ProgramReflection& prog, uint32_t first_entry, uint32_t num_entries) {
+    w.u32(strings.add(prog.name));
+    w.u32(strings.add(fmt::format("{}_shader", prog.name)));
+    w.u32(first_entry);
+    w.u32(num_entries);
+    for (int i = 0; i < 3; i++) {
+        w.i32(prog.has_cs() ? prog.cs().cs_workgroup_size[i] : 0);
+    }
+    w.u32(0);   // reserved
+    for (int attr_index = 0; attr_index < StageAttr::Num; attr_index++) {
+        const StageAttr* attr = prog.has_vs() ? &prog.vs().inputs[attr_index] : nullptr;
+        if (attr && (attr->slot >= 0)) {
+            w.u32(sg_attr_basetype(attr->type_info.basetype()));
+            w.u32(strings.add(attr->name));
+            w.u32(strings.add(attr->sem_name));
+            w.i32(attr->sem_index);
+        } else {
+            w.u32(0); w.u32(0); w.u32(0); w.u32(0);
+        }
+    }
+    for (int ub_index = 0; ub_index < MaxUniformBlocks; ub_index++) {
+        const UniformBlock* ub = prog.bindings.find_uniform_block_by_sokol_slot(ub_index);
+        if (ub) {
+            const int ub_size = (ub->struct_info.size + 15) & ~15;
+            const uint32_t first_uniform = (uint32_t)glsl_uniforms.size();
+            if (ub->struct_info.struct_items.size() > 0) {
+                if (ub->flattened) {
+                    // same as the C generator: the type from the first item, but the size from the toplevel ub
+                    glsl_uniforms.push_back({
+                        sg_flattened_uniform_type(ub->struct_info.struct_items[0].type),
+                        (uint32_t)(ub_size / 16),
+                        strings.add(ub->name)
+                    });
+                } else {
+                    for (const Type& u: ub->struct_info.struct_items) {
+                        glsl_uniforms.push_back({
+                            sg_uniform_type(u.type),
+                            (uint32_t)u.array_count,
+                            strings.add(fmt::format("{}.{}", ub->inst_name, u.name))
+                        });
+                    }
+                }
+            }
+            w.u32(sg_shader_stage(ub->stage));
+            w.u32(SG_UNIFORMLAYOUT_STD140);
+            w.u32((uint32_t)ub_size);
+            w.i32(ub->hlsl_register_b_n);
+            w.i32(ub->msl_buffer_n);
+            w.i32(ub->wgsl_group0_binding_n);
+            w.i32(ub->spirv_set0_binding_n);
+            w.u32(first_uniform);
+            w.u32((uint32_t)glsl_uniforms.size() - first_uniform);
+        } else {
+            for (int i = 0; i < 9; i++) {
+                w.u32(0);
+            }
+        }
+    }
+    for (int view_index = 0; view_index < MaxViews; view_index++) {
+        const Bindings::View view = prog.bindings.get_view_by_sokol_slot(view_index);
+        uint32_t view_type = PACK_VIEWTYPE_NONE;
+        uint32_t stage = 0, image_type = 0, sample_type = 0, multisampled = 0, readonly = 0, writeonly = 0, access_format = 0;
+        int hlsl_t_n = -1, hlsl_u_n = -1, msl_n = -1, wgsl_n = -1, spirv_n = -1, glsl_n = -1;
+        if (view.type == BindSlot::Type::Texture) {
+            const Texture& tex = view.texture;
+            view_type = PACK_VIEWTYPE_TEXTURE;
+            stage = sg_shader_stage(tex.stage);
+            image_type = sg_image_type(tex.type);
+            sample_type = sg_image_sample_type(tex.sample_type);
+            multisampled = tex.multisampled ? 1 : 0;
+            hlsl_t_n = tex.hlsl_register_t_n;
+            msl_n = tex.msl_texture_n;
+            wgsl_n = tex.wgsl_group1_binding_n;
+            spirv_n = tex.spirv_set1_binding_n;
+        } else if (view.type == BindSlot::Type::StorageBuffer) {
+            const StorageBuffer& sbuf = view.storage_buffer;
+            view_type = PACK_VIEWTYPE_STORAGEBUFFER;
+            stage = sg_shader_stage(sbuf.stage);
+            readonly = sbuf.readonly ? 1 : 0;
+            hlsl_t_n = sbuf.hlsl_register_t_n;
+            hlsl_u_n = sbuf.hlsl_register_u_n;
+            msl_n = sbuf.msl_buffer_n;
+            wgsl_n = sbuf.wgsl_group1_binding_n;
+            spirv_n = sbuf.spirv_set1_binding_n;
+            glsl_n = sbuf.glsl_binding_n;
+        } else if (view.type == BindSlot::Type::StorageImage) {
+            const StorageImage& simg = view.storage_image;
+            view_type = PACK_VIEWTYPE_STORAGEIMAGE;
+            stage = sg_shader_stage(simg.stage);
+            image_type = sg_image_type(simg.type);
+            writeonly = simg.writeonly ? 1 : 0;
+            access_format = strings.add(StoragePixelFormat::to_str(simg.access_format));
+            hlsl_u_n = simg.hlsl_register_u_n;
+            msl_n = simg.msl_texture_n;
+            wgsl_n = simg.wgsl_group1_binding_n;
+            spirv_n = simg.spirv_set1_binding_n;
+            glsl_n = simg.glsl_binding_n;
+        }
+        if (view_type != PACK_VIEWTYPE_NONE) {
+            w.u32(view_type);
+            w.u32(stage);
+            w.u32(image_type);
+            w.u32(sample_type);
+            w.u32(multisampled);
+            w.u32(readonly);
+            w.u32(writeonly);
+            w.u32(access_format);
+            w.i32(hlsl_t_n);
+            w.i32(hlsl_u_n);
+            w.i32(msl_n);
+            w.i32(wgsl_n);
+            w.i32(spirv_n);
+            w.i32(glsl_n);
+        } else {
+            for (int i = 0; i < 14; i++) {
+                w.u32(0);
+            }
+        }
+    }
+    for (int smp_index = 0; smp_index < MaxSamplers; smp_index++) {
+        const Sampler* smp = prog.bindings.find_sampler_by_sokol_slot(smp_index);
+        if (smp) {
+            w.u32(sg_shader_stage(smp->stage));
+            w.u32(sg_sampler_type(smp->type));
+            w.i32(smp->hlsl_register_s_n);
+            w.i32(smp->msl_sampler_n);
+            w.i32(smp->wgsl_group1_binding_n);
+            w.i32(smp->spirv_set1_binding_n);
+        } else {
+            for (int i = 0; i < 6; i++) {
+                w.u32(0);
+            }
+        }
+    }
+    for (int tex_smp_index = 0; tex_smp_index < MaxTextureSamplers; tex_smp_index++) {
+        const TextureSampler* tex_smp = prog.bindings.find_texture_sampler_by_sokol_slot(tex_smp_index);
+        if (tex_smp) {
+            w.u32(sg_shader_stage(tex_smp->stage));
+            w.i32(prog.bindings.find_texture_by_name(tex_smp->texture_name)->sokol_slot);
+            w.i32(prog.bindings.find_sampler_by_name(tex_smp->sampler_name)->sokol_slot);
+            w.u32(strings.add(tex_smp->name));
+        } else {
+            for (int i = 0; i < 4; i++) {
+                w.u32(0);
+            }
+        }
+    }
+}
+
+// completely override the generate function, the archive contains the same
+// shader sources and blobs as the bare output format in a single file
+ErrMsg PackGenerator::generate(const GenInput& gen) {
+    mod_prefix = gen.inp.module.empty() ? "" : fmt::format("{}_", gen.inp.module);
+    ErrMsg err = check_errors(gen);
+    if (err.valid()) {
+        return err;
+    }
+
+    // programs are sorted by name, entries by (program, slang, stage), so that
+    // a loader can use binary searches on the memory-mapped archive
+    std::vector<const ProgramReflection*> progs;
+    for (const ProgramReflection& prog: gen.refl.progs) {
+        progs.push_back(&prog);
+    }
+    std::sort(progs.begin(), progs.end(), [](const ProgramReflection* a, const ProgramReflection* b) {
+        return a->name < b->name;
+    });
+    struct Entry {
+        uint32_t program_index;
+        Slang::Enum slang;
+        const StageReflection* refl;
+        const SpirvcrossSource* src;
+        const BytecodeBlob* blob;
+    };
+    std::vector<Entry> entries;
+    std::vector<std::pair<uint32_t,uint32_t>> entry_ranges;
+    for (uint32_t prog_index = 0; prog_index < (uint32_t)progs.size(); prog_index++) {
+        const uint32_t first_entry = (uint32_t)entries.size();
+        for (int i = 0; i < Slang::Num; i++) {
+            Slang::Enum slang = Slang::from_index(i);
+            if (gen.args.slang & Slang::bit(slang)) {
+                for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
+                    const StageReflection& refl = progs[prog_index]->stages[stage_index];
+                    if (refl.stage == ShaderStage::Invalid) {
+                        continue;
+                    }
+                    Entry entry;
+                    entry.program_index = prog_index;
+                    entry.slang = slang;
+                    entry.refl = &refl;
+                    entry.src = gen.spirvcross[slang].find_source_by_snippet_index(refl.snippet_index);
+                    entry.blob = gen.bytecode[slang].find_blob_by_snippet_index(refl.snippet_index);
+                    assert(entry.src || entry.blob);
+                    entries.push_back(entry);
+                }
+            }
+        }
+        entry_ranges.push_back({ first_entry, (uint32_t)entries.size() - first_entry });
+    }
+
+    PackWriter w;
+    PackStrings strings;
+    std::vector<PackUniform> glsl_uniforms;
+
+    // header, section offsets are patched below
+    w.u32(Magic);
+    w.u32(Version);
+    const uint32_t file_size_pos = w.pos(); w.u32(0);
+    w.u32(strings.add(gen.inp.module));
+    w.u32((uint32_t)progs.size());
+    const uint32_t programs_offset_pos = w.pos(); w.u32(0);
+    w.u32((uint32_t)entries.size());
+    const uint32_t entries_offset_pos = w.pos(); w.u32(0);
+    const uint32_t num_uniforms_pos = w.pos(); w.u32(0);
+    const uint32_t uniforms_offset_pos = w.pos(); w.u32(0);
+    const uint32_t strings_size_pos = w.pos(); w.u32(0);
+    const uint32_t strings_offset_pos = w.pos(); w.u32(0);
+
+    w.align(8);
+    w.patch_u32(programs_offset_pos, w.pos());
+    for (uint32_t prog_index = 0; prog_index < (uint32_t)progs.size(); prog_index++) {
+        write_program(w, strings, glsl_uniforms, *progs[prog_index], entry_ranges[prog_index].first, entry_ranges[prog_index].second);
+    }
+
+    w.align(8);
+    w.patch_u32(entries_offset_pos, w.pos());
+    std::vector<uint32_t> data_offset_pos;
+    for (const Entry& entry: entries) {
+        const bool is_bytecode = entry.blob != nullptr;
+        // source code includes the trailing zero so that it can be used in place as C string
+        const size_t num_bytes = is_bytecode ? entry.blob->data.size() : entry.src->source_code.length() + 1;
+        const char* d3d11_target = hlsl_target(entry.slang, entry.refl->stage);
+        w.u64(shader_content_hash(gen, *progs[entry.program_index], entry.refl->stage, entry.slang));
+        w.u32(entry.program_index);
+        w.u32((uint32_t)entry.slang);
+        w.u32(sg_shader_stage(entry.refl->stage));
+        w.u32(strings.add(entry.refl->entry_point_by_slang(entry.slang)));
+        w.u32(d3d11_target ? strings.add(d3d11_target) : 0);
+        data_offset_pos.push_back(w.pos()); w.u32(0);
+        w.u32((uint32_t)num_bytes);
+        w.u32(is_bytecode ? 1 : 0);
+        // reserved, pads the record to 48 bytes so that the hash of each record is 8-byte aligned
+        w.u32(0);
+        w.u32(0);
+    }
+
+    w.align(8);
+    w.patch_u32(num_uniforms_pos, (uint32_t)glsl_uniforms.size());
+    w.patch_u32(uniforms_offset_pos, w.pos());
+    for (const PackUniform& u: glsl_uniforms) {
+        w.u32(u.type);
+        w.u32(u.array_count);
+        w.u32(u.glsl_name);
+        w.u32(0);   // reserved
+    }
+
+    w.patch_u32(strings_offset_pos, w.pos());
+    w.patch_u32(strings_size_pos, (uint32_t)strings.data.size());
+    w.bytes(strings.data.data(), strings.data.size());
+
+    // shader blobs are 16-byte aligned
+    for (size_t i = 0; i < entries.size(); i++) {
+        const Entry& entry = entries[i];
+        w.align(16);
+        w.patch_u32(data_offset_pos[i], w.pos());
+        if (entry.blob) {
+            w.bytes(entry.blob->data.data(), entry.blob->data.size());
+        } else {
+            w.bytes(entry.src->source_code.c_str(), entry.src->source_code.length() + 1);
+        }
+    }
+    w.align(16);
+    w.patch_u32(file_size_pos, w.pos());
+
+    return write_output_file(gen, gen.args.output, w.data.data(), w.data.size(), false);
+}
+
+} // namespace
@@ -0,0 +1,14 @@
+#pragma once
+#include "bare.h"
+
+namespace shdc::gen {
+
+// a single binary shader archive per module (see docs/sokol-shdc.md 'Shader Archives')
+class PackGenerator: public BareGenerator {
+public:
+    static const uint32_t Magic = 0x4B505353;   // 'SSPK'
+    static const uint32_t Version = 1;
+    virtual ErrMsg generate(const GenInput& gen);
+};
+
+} // namespace
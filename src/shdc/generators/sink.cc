@@ -0,0 +1,175 @@
+/*
+    Buffered output of generated files
+*/
+#include "sink.h"
+#include "util.h"
+#include "fmt/format.h"
+#include "pystring.h"
+#include <filesystem>
+#include <utility>
+#include <vector>
+
+namespace shdc::gen {
+
+OutputSink::~OutputSink() {
+    discard();
+}
+
+bool OutputSink::open(Mode mode, const std::string& path, bool is_text, Vfs& file_vfs) {
+    discard();
+    sink_mode = mode;
+    vfs = &file_vfs;
+    streaming = (sink_mode == File) && vfs->is_native();
+    file_path = path;
+    text = is_text;
+    failed = false;
+    file_changed = false;
+    buffer.clear();
+    content_hash = util::hash64(nullptr, 0);
+    num_bytes_written = 0;
+    if (streaming) {
+        // stream into a temp file, which replaces the output file in close() if the content has changed
+        tmp_path = fmt::format("{}.tmp", file_path);
+        fp = fopen(tmp_path.c_str(), "wb");
+        if (!fp) {
+            return false;
+        }
+    }
+    opened = true;
+    return true;
+}
+
+// close the temp file and remove it, used when a sink is closed without writing the output
+void OutputSink::discard() {
+    if (fp) {
+        fclose(fp);
+        fp = nullptr;
+        remove(tmp_path.c_str());
+    }
+    opened = false;
+}
+
+void OutputSink::swap(OutputSink& other) {
+    std::swap(sink_mode, other.sink_mode);
+    std::swap(vfs, other.vfs);
+    std::swap(streaming, other.streaming);
+    std::swap(file_path, other.file_path);
+    std::swap(tmp_path, other.tmp_path);
+    std::swap(text, other.text);
+    std::swap(opened, other.opened);
+    std::swap(failed, other.failed);
+    std::swap(file_changed, other.file_changed);
+    std::swap(fp, other.fp);
+    std::swap(buffer, other.buffer);
+    std::swap(content_hash, other.content_hash);
+    std::swap(num_bytes_written, other.num_bytes_written);
+}
+
+void OutputSink::append(const char* data, size_t num_bytes) {
+    buffer.append(data, num_bytes);
+    if (buffer.length() >= FlushSize) {
+        flush();
+    }
+}
+
+void OutputSink::push_back(char c) {
+    buffer.push_back(c);
+    if (buffer.length() >= FlushSize) {
+        flush();
+    }
+}
+
+char* OutputSink::reserve(size_t num_bytes) {
+    if ((buffer.length() + num_bytes) > FlushSize) {
+        flush();
+    }
+    const size_t pos = buffer.length();
+    buffer.resize(pos + num_bytes);
+    return &buffer[pos];
+}
+
+// Memory mode and File mode on a non-disk Vfs keep everything in the buffer,
+// all other modes hash and write the buffered output and clear the buffer
+void OutputSink::flush() {
+    if (((sink_mode != HashOnly) && !streaming) || buffer.empty()) {
+        return;
+    }
+    #if defined(_WIN32)
+    // same result as writing in text mode
+    if (text) {
+        buffer = pystring::replace(buffer, "\n", "\r\n");
+    }
+    #endif
+    content_hash = util::hash64(buffer.data(), buffer.length(), content_hash);
+    num_bytes_written += buffer.length();
+    if (fp && (fwrite(buffer.data(), 1, buffer.length(), fp) != buffer.length())) {
+        failed = true;
+    }
+    buffer.clear();
+}
+
+bool OutputSink::close() {
+    if (!opened) {
+        return false;
+    }
+    opened = false;
+    if ((sink_mode != HashOnly) && !streaming) {
+        #if defined(_WIN32)
+        if (text) {
+            buffer = pystring::replace(buffer, "\n", "\r\n");
+        }
+        #endif
+        content_hash = util::hash64(buffer.data(), buffer.length(), content_hash);
+        num_bytes_written = buffer.length();
+        if (sink_mode == File) {
+            std::string existing;
+            if (vfs->read(file_path, existing) && (existing == buffer)) {
+                return true;
+            }
+            if (!vfs->write(file_path, buffer.data(), buffer.length())) {
+                return false;
+            }
+            file_changed = true;
+        }
+        return true;
+    }
+    flush();
+    if (sink_mode == HashOnly) {
+        return true;
+    }
+    failed = (0 != fclose(fp)) || failed;
+    fp = nullptr;
+    if (failed) {
+        remove(tmp_path.c_str());
+        return false;
+    }
+    // compare size and hash with the existing output file
+    bool unchanged = false;
+    FILE* existing = fopen(file_path.c_str(), "rb");
+    if (existing) {
+        std::vector<uint8_t> chunk(FlushSize);
+        uint64_t existing_hash = util::hash64(nullptr, 0);
+        size_t existing_size = 0;
+        size_t num_read = 0;
+        while ((num_read = fread(chunk.data(), 1, chunk.size(), existing)) > 0) {
+            existing_hash = util::hash64(chunk.data(), num_read, existing_hash);
+            existing_size += num_read;
+        }
+        fclose(existing);
+        unchanged = (existing_size == num_bytes_written) && (existing_hash == content_hash);
+    }
+    if (unchanged) {
+        remove(tmp_path.c_str());
+        return true;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, file_path, ec);
+    if (ec) {
+        remove(tmp_path.c_str());
+        return false;
+    }
+    file_changed = true;
+    return true;
+}
+
+} // namespace
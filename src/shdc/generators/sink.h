@@ -0,0 +1,65 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include "vfs.h"
+
+namespace shdc::gen {
+
+// a buffered sink for a generated output file, the output is either streamed
+// into the file (which is only replaced when the content has changed), captured
+// in memory, or only hashed (e.g. to check whether an output is up to date),
+// files on a non-disk Vfs are written as a whole when the sink is closed
+class OutputSink {
+public:
+    enum Mode {
+        File,
+        Memory,
+        HashOnly,
+    };
+    OutputSink() { };
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+    ~OutputSink();
+
+    bool open(Mode mode, const std::string& path, bool is_text, Vfs& vfs);
+    // flushes the remaining output, in File mode replaces the output file if the content has changed
+    bool close();
+    void swap(OutputSink& other);
+
+    void append(const char* data, size_t num_bytes);
+    void append(const std::string& str) { append(str.data(), str.length()); };
+    void push_back(char c);
+    // returns a pointer to num_bytes which must be filled by the caller
+    char* reserve(size_t num_bytes);
+
+    bool is_open() const { return opened; };
+    Mode mode() const { return sink_mode; };
+    const std::string& path() const { return file_path; };
+    // the following are valid after close()
+    uint64_t hash() const { return content_hash; };
+    size_t size() const { return num_bytes_written; };
+    bool changed() const { return file_changed; };
+    std::string& data() { return buffer; };     // captured content in Memory mode
+
+private:
+    static const size_t FlushSize = 64 * 1024;
+    void flush();
+    void discard();
+
+    Mode sink_mode = File;
+    Vfs* vfs = nullptr;
+    bool streaming = false;     // File mode on a disk Vfs
+    std::string file_path;
+    std::string tmp_path;
+    bool text = false;
+    bool opened = false;
+    bool failed = false;
+    bool file_changed = false;
+    FILE* fp = nullptr;
+    std::string buffer;
+    uint64_t content_hash = 0;
+    size_t num_bytes_written = 0;
+};
+
+} // namespace
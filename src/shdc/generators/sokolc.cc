@@ -4,12 +4,17 @@
 #include "sokolc.h"
 #include "fmt/format.h"
 #include "pystring.h"
+#include "util.h"
 #include <stdio.h>
+#include <ctype.h>
 
 namespace shdc::gen {
 
 using namespace refl;
 
+// FNV-1a offset basis, start value of the name hashes in generated reflection functions
+static const uint32_t name_hash_basis = 0x811C9DC5;
+
 static const char* sokol_define(Slang::Enum slang) {
     switch (slang) {
         case Slang::GLSL410:
@@ -37,10 +42,22 @@ static const char* sokol_define(Slang::Enum slang) {
 ErrMsg SokolCGenerator::begin(const GenInput& gen) {
     if (!gen.inp.module.empty()) {
         mod_prefix = fmt::format("{}_", gen.inp.module);
+        registry_prefix = mod_prefix;
+    } else {
+        // without a @module the registry symbols would clash between headers
+        // included into the same translation unit, so use the output filename
+        std::string root, ext;
+        pystring::os::path::splitext(root, ext, pystring::os::path::basename(gen.args.output));
+        registry_prefix.clear();
+        for (char c: root) {
+            registry_prefix += isalnum((unsigned char)c) ? c : '_';
+        }
+        registry_prefix += "_";
     }
     if (gen.args.output_format != Format::SOKOL_IMPL) {
         func_prefix = "static inline ";
     }
+    backend_file_error = ErrMsg();
     return Generator::begin(gen);
 }
 
@@ -56,8 +73,22 @@ void SokolCGenerator::gen_epilog(const GenInput& gen) {
 }
 
 void SokolCGenerator::gen_prerequisites(const GenInput& gen) {
-    if (gen.args.reflection) {
+    if (gen.args.reflection || gen.args.registry) {
         l("#include <string.h>\n");
+        // string hash functions for the program registry and reflection name lookups, must match util::phash_str() and util::phash_mix()
+        l("#if !defined(SOKOL_SHDC_HASH_INCLUDED)\n");
+        l("#define SOKOL_SHDC_HASH_INCLUDED\n");
+        l_open("static inline uint32_t _sokol_shdc_hash(uint32_t h, const char* str) {{\n");
+        l_open("while (*str) {{\n");
+        l("h = (h ^ (uint8_t)*str++) * 0x01000193u;\n");
+        l_close("}}\n");
+        l("return h;\n");
+        l_close("}}\n");
+        l_open("static inline uint32_t _sokol_shdc_mix(uint32_t h) {{\n");
+        l("h ^= h >> 16; h *= 0x85EBCA6Bu; h ^= h >> 13; h *= 0xC2B2AE35u; h ^= h >> 16;\n");
+        l("return h;\n");
+        l_close("}}\n");
+        l("#endif\n");
     }
     l("#if !defined(SOKOL_GFX_INCLUDED)\n");
     l("#error \"Please include sokol_gfx.h before {}\"\n", pystring::os::path::basename(gen.args.output));
@@ -69,10 +100,44 @@ void SokolCGenerator::gen_prerequisites(const GenInput& gen) {
     l("#define SOKOL_SHDC_ALIGN(a) __attribute__((aligned(a)))\n");
     l("#endif\n");
     l("#endif\n");
+    if (gen.args.registry) {
+        l("#if !defined(SOKOL_SHDC_PROGRAM_DEFINED)\n");
+        l("#define SOKOL_SHDC_PROGRAM_DEFINED\n");
+        l_open("typedef struct sokol_shdc_program {{\n");
+        l("const char* name;\n");
+        l("uint32_t name_hash;\n");
+        l("int id;\n");
+        l("const sg_shader_desc* (*shader_desc)(sg_backend backend);\n");
+        l("uint64_t (*content_hash)(sg_backend backend);\n");
+        l_close("}} sokol_shdc_program;\n");
+        l("#endif\n");
+        for (int prog_id = 0; prog_id < (int)gen.refl.progs.size(); prog_id++) {
+            l("#define PROG_{}{} ({})\n", registry_prefix, gen.refl.progs[prog_id].name, prog_id);
+        }
+    }
     if (gen.args.output_format == Format::SOKOL_IMPL) {
+        if (gen.args.registry && !gen.refl.progs.empty()) {
+            l("const sokol_shdc_program* {}shader_programs(int* out_num_programs);\n", registry_prefix);
+            l("const sokol_shdc_program* {}shader_program_by_id(int id);\n", registry_prefix);
+            l("const sokol_shdc_program* {}shader_program_by_name_hash(uint32_t name_hash);\n", registry_prefix);
+            l("const sokol_shdc_program* {}shader_program_by_name(const char* name);\n", registry_prefix);
+        }
         for (const auto& item: gen.inp.programs) {
             const Program& prog = item.second;
             l("const sg_shader_desc* {}{}_shader_desc(sg_backend backend);\n", mod_prefix, prog.name);
+            for (int i = 0; i < Slang::Num; i++) {
+                Slang::Enum slang = Slang::from_index(i);
+                if (gen.args.slang & Slang::bit(slang)) {
+                    if (gen.args.ifdef || gen.args.split_backends) {
+                        l("#if defined({})\n", sokol_define(slang));
+                    }
+                    l("const sg_shader_desc* {}(void);\n", backend_shader_desc_func_name(prog.name, slang));
+                    if (gen.args.ifdef || gen.args.split_backends) {
+                        l("#endif\n");
+                    }
+                }
+            }
+            l("uint64_t {}{}_content_hash(sg_backend backend);\n", mod_prefix, prog.name);
             if (gen.args.reflection) {
                 l("int {}{}_attr_slot(const char* attr_name);\n", mod_prefix, prog.name);
                 l("int {}{}_texture_slot(const char* tex_name);\n", mod_prefix, prog.name);
@@ -81,7 +146,9 @@ void SokolCGenerator::gen_prerequisites(const GenInput& gen) {
                 l("size_t {}{}_uniformblock_size(const char* ub_name);\n", mod_prefix, prog.name);
                 l("int {}{}_storagebuffer_slot(const char* sbuf_name);\n", mod_prefix, prog.name);
                 l("int {}{}_storageimage_slot(const char* simg_name);\n", mod_prefix, prog.name);
+                l("int {}{}_uniform_offset_by_index(int ub_slot, int u_index);\n", mod_prefix, prog.name);
                 l("int {}{}_uniform_offset(const char* ub_name, const char* u_name);\n", mod_prefix, prog.name);
+                l("sg_glsl_shader_uniform {}{}_uniform_desc_by_index(int ub_slot, int u_index);\n", mod_prefix, prog.name);
                 l("sg_glsl_shader_uniform {}{}_uniform_desc(const char* ub_name, const char* u_name);\n", mod_prefix, prog.name);
             }
         }
@@ -254,187 +321,255 @@ void SokolCGenerator::gen_storage_buffer_decl(const GenInput& gen, const Type& s
     l("#pragma pack(pop)\n");
 }
 
-void SokolCGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramReflection& prog) {
-    l_open("{}const sg_shader_desc* {}{}_shader_desc(sg_backend backend) {{\n", func_prefix, mod_prefix, prog.name);
-    for (int i = 0; i < Slang::Num; i++) {
-        Slang::Enum slang = Slang::from_index(i);
-        if (gen.args.slang & Slang::bit(slang)) {
-            if (gen.args.ifdef) {
-                l("#if defined({})\n", sokol_define(slang));
+// collect the (member path, value) pairs of a shader desc for one shader language
+std::vector<std::pair<std::string, std::string>> SokolCGenerator::shader_desc_items(const GenInput& gen, const ProgramReflection& prog, Slang::Enum slang) {
+    std::vector<std::pair<std::string, std::string>> items;
+    const auto d = [&items](const std::string& path, const std::string& value) {
+        items.push_back({ path, value });
+    };
+    for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
+        const ShaderStageArrayInfo& info = shader_stage_array_info(gen, prog, ShaderStage::from_index(stage_index), slang);
+        if (info.stage == ShaderStage::Invalid) {
+            continue;
+        }
+        const StageReflection& refl = prog.stages[stage_index];
+        std::string dsn;
+        switch (info.stage) {
+            case ShaderStage::Vertex: dsn = "vertex_func"; break;
+            case ShaderStage::Fragment: dsn = "fragment_func"; break;
+            case ShaderStage::Compute: dsn = "compute_func"; break;
+            default: dsn = "INVALID"; break;
+        }
+        if (info.has_bytecode) {
+            d(dsn + ".bytecode.ptr", info.bytecode_array_name);
+            d(dsn + ".bytecode.size", fmt::format("{}", info.bytecode_array_size));
+        } else {
+            d(dsn + ".source", fmt::format("(const char*){}", info.source_array_name));
+            const char* d3d11_tgt = hlsl_target(slang, info.stage);
+            if (d3d11_tgt) {
+                d(dsn + ".d3d11_target", fmt::format("\"{}\"", d3d11_tgt));
             }
-            l_open("if (backend == {}) {{\n", backend(slang));
-            l("static sg_shader_desc desc;\n");
-            l("static bool valid;\n");
-            l_open("if (!valid) {{\n");
-            l("valid = true;\n");
-            for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
-                const ShaderStageArrayInfo& info = shader_stage_array_info(gen, prog, ShaderStage::from_index(stage_index), slang);
-                if (info.stage == ShaderStage::Invalid) {
-                    continue;
-                }
-                const StageReflection& refl = prog.stages[stage_index];
-                std::string dsn;
-                switch (info.stage) {
-                    case ShaderStage::Vertex: dsn = "desc.vertex_func"; break;
-                    case ShaderStage::Fragment: dsn = "desc.fragment_func"; break;
-                    case ShaderStage::Compute: dsn = "desc.compute_func"; break;
-                    default: dsn = "INVALID"; break;
+        }
+        d(dsn + ".entry", fmt::format("\"{}\"", refl.entry_point_by_slang(slang)));
+    }
+    if (Slang::is_msl(slang) && prog.has_cs()) {
+        d("mtl_threads_per_threadgroup.x", fmt::format("{}", prog.cs().cs_workgroup_size[0]));
+        d("mtl_threads_per_threadgroup.y", fmt::format("{}", prog.cs().cs_workgroup_size[1]));
+        d("mtl_threads_per_threadgroup.z", fmt::format("{}", prog.cs().cs_workgroup_size[2]));
+    }
+    if (prog.has_vs()) {
+        for (int attr_index = 0; attr_index < StageAttr::Num; attr_index++) {
+            const StageAttr& attr = prog.vs().inputs[attr_index];
+            if (attr.slot >= 0) {
+                const std::string an = fmt::format("attrs[{}]", attr_index);
+                d(an + ".base_type", attr_basetype(attr.type_info.basetype()));
+                if (Slang::is_glsl(slang)) {
+                    d(an + ".glsl_name", fmt::format("\"{}\"", attr.name));
+                } else if (Slang::is_hlsl(slang)) {
+                    d(an + ".hlsl_sem_name", fmt::format("\"{}\"", attr.sem_name));
+                    d(an + ".hlsl_sem_index", fmt::format("{}", attr.sem_index));
                 }
-                if (info.has_bytecode) {
-                    l("{}.bytecode.ptr = {};\n", dsn, info.bytecode_array_name);
-                    l("{}.bytecode.size = {};\n", dsn, info.bytecode_array_size);
+            }
+        }
+    }
+    for (int ub_index = 0; ub_index < MaxUniformBlocks; ub_index++) {
+        const UniformBlock* ub = prog.bindings.find_uniform_block_by_sokol_slot(ub_index);
+        if (ub) {
+            const std::string ubn = fmt::format("uniform_blocks[{}]", ub_index);
+            d(ubn + ".stage", shader_stage(ub->stage));
+            d(ubn + ".layout", "SG_UNIFORMLAYOUT_STD140");
+            d(ubn + ".size", fmt::format("{}", roundup(ub->struct_info.size, 16)));
+            if (Slang::is_hlsl(slang)) {
+                d(ubn + ".hlsl_register_b_n", fmt::format("{}", ub->hlsl_register_b_n));
+            } else if (Slang::is_msl(slang)) {
+                d(ubn + ".msl_buffer_n", fmt::format("{}", ub->msl_buffer_n));
+            } else if (Slang::is_wgsl(slang)) {
+                d(ubn + ".wgsl_group0_binding_n", fmt::format("{}", ub->wgsl_group0_binding_n));
+            } else if (Slang::is_spirv(slang)) {
+                d(ubn + ".spirv_set0_binding_n", fmt::format("{}", ub->spirv_set0_binding_n));
+            } else if (Slang::is_glsl(slang) && (ub->struct_info.struct_items.size() > 0)) {
+                if (ub->flattened) {
+                    // NOT A BUG (to take the type from the first struct item, but the size from the toplevel ub)
+                    d(ubn + ".glsl_uniforms[0].type", flattened_uniform_type(ub->struct_info.struct_items[0].type));
+                    d(ubn + ".glsl_uniforms[0].array_count", fmt::format("{}", roundup(ub->struct_info.size, 16) / 16));
+                    d(ubn + ".glsl_uniforms[0].glsl_name", fmt::format("\"{}\"", ub->name));
                 } else {
-                    l("{}.source = (const char*){};\n", dsn, info.source_array_name);
-                    const char* d3d11_tgt = hlsl_target(slang, info.stage);
-                    if (d3d11_tgt) {
-                        l("{}.d3d11_target = \"{}\";\n", dsn, d3d11_tgt);
+                    for (int u_index = 0; u_index < (int)ub->struct_info.struct_items.size(); u_index++) {
+                        const Type& u = ub->struct_info.struct_items[u_index];
+                        const std::string un = fmt::format("{}.glsl_uniforms[{}]", ubn, u_index);
+                        d(un + ".type", uniform_type(u.type));
+                        d(un + ".array_count", fmt::format("{}", u.array_count));
+                        d(un + ".glsl_name", fmt::format("\"{}.{}\"", ub->inst_name, u.name));
                     }
                 }
-                l("{}.entry = \"{}\";\n", dsn, refl.entry_point_by_slang(slang));
             }
-            if (Slang::is_msl(slang) && prog.has_cs()) {
-                l("desc.mtl_threads_per_threadgroup.x = {};\n", prog.cs().cs_workgroup_size[0]);
-                l("desc.mtl_threads_per_threadgroup.y = {};\n", prog.cs().cs_workgroup_size[1]);
-                l("desc.mtl_threads_per_threadgroup.z = {};\n", prog.cs().cs_workgroup_size[2]);
+        }
+    }
+    for (int view_index = 0; view_index < MaxViews; view_index++) {
+        const Bindings::View view = prog.bindings.get_view_by_sokol_slot(view_index);
+        if (view.type == BindSlot::Type::Texture) {
+            const Texture* tex = &view.texture;
+            const std::string tn = fmt::format("views[{}].texture", view_index);
+            d(tn + ".stage", shader_stage(tex->stage));
+            d(tn + ".image_type", image_type(tex->type));
+            d(tn + ".sample_type", image_sample_type(tex->sample_type));
+            d(tn + ".multisampled", tex->multisampled ? "true" : "false");
+            if (Slang::is_hlsl(slang)) {
+                d(tn + ".hlsl_register_t_n", fmt::format("{}", tex->hlsl_register_t_n));
+            } else if (Slang::is_msl(slang)) {
+                d(tn + ".msl_texture_n", fmt::format("{}", tex->msl_texture_n));
+            } else if (Slang::is_wgsl(slang)) {
+                d(tn + ".wgsl_group1_binding_n", fmt::format("{}", tex->wgsl_group1_binding_n));
+            } else if (Slang::is_spirv(slang)) {
+                d(tn + ".spirv_set1_binding_n", fmt::format("{}", tex->spirv_set1_binding_n));
             }
-            if (prog.has_vs()) {
-                for (int attr_index = 0; attr_index < StageAttr::Num; attr_index++) {
-                    const StageAttr& attr = prog.vs().inputs[attr_index];
-                    if (attr.slot >= 0) {
-                        l("desc.attrs[{}].base_type = {};\n", attr_index, attr_basetype(attr.type_info.basetype()));
-                        if (Slang::is_glsl(slang)) {
-                            l("desc.attrs[{}].glsl_name = \"{}\";\n", attr_index, attr.name);
-                        } else if (Slang::is_hlsl(slang)) {
-                            l("desc.attrs[{}].hlsl_sem_name = \"{}\";\n", attr_index, attr.sem_name);
-                            l("desc.attrs[{}].hlsl_sem_index = {};\n", attr_index, attr.sem_index);
-                        }
-                    }
+        } else if (view.type == BindSlot::Type::StorageBuffer) {
+            const StorageBuffer* sbuf = &view.storage_buffer;
+            const std::string sbn = fmt::format("views[{}].storage_buffer", view_index);
+            d(sbn + ".stage", shader_stage(sbuf->stage));
+            d(sbn + ".readonly", fmt::format("{}", sbuf->readonly));
+            if (Slang::is_hlsl(slang)) {
+                if (sbuf->hlsl_register_t_n >= 0) {
+                    d(sbn + ".hlsl_register_t_n", fmt::format("{}", sbuf->hlsl_register_t_n));
                 }
-            }
-            for (int ub_index = 0; ub_index < MaxUniformBlocks; ub_index++) {
-                const UniformBlock* ub = prog.bindings.find_uniform_block_by_sokol_slot(ub_index);
-                if (ub) {
-                    const std::string ubn = fmt::format("desc.uniform_blocks[{}]", ub_index);
-                    l("{}.stage = {};\n", ubn, shader_stage(ub->stage));
-                    l("{}.layout = SG_UNIFORMLAYOUT_STD140;\n", ubn);
-                    l("{}.size = {};\n", ubn, roundup(ub->struct_info.size, 16));
-                    if (Slang::is_hlsl(slang)) {
-                        l("{}.hlsl_register_b_n = {};\n", ubn, ub->hlsl_register_b_n);
-                    } else if (Slang::is_msl(slang)) {
-                        l("{}.msl_buffer_n = {};\n", ubn, ub->msl_buffer_n);
-                    } else if (Slang::is_wgsl(slang)) {
-                        l("{}.wgsl_group0_binding_n = {};\n", ubn, ub->wgsl_group0_binding_n);
-                    } else if (Slang::is_spirv(slang)) {
-                        l("{}.spirv_set0_binding_n = {};\n", ubn, ub->spirv_set0_binding_n);
-                    } else if (Slang::is_glsl(slang) && (ub->struct_info.struct_items.size() > 0)) {
-                        if (ub->flattened) {
-                            // NOT A BUG (to take the type from the first struct item, but the size from the toplevel ub)
-                            l("{}.glsl_uniforms[0].type = {};\n", ubn, flattened_uniform_type(ub->struct_info.struct_items[0].type));
-                            l("{}.glsl_uniforms[0].array_count = {};\n", ubn, roundup(ub->struct_info.size, 16) / 16);
-                            l("{}.glsl_uniforms[0].glsl_name = \"{}\";\n", ubn, ub->name);
-                        } else {
-                            for (int u_index = 0; u_index < (int)ub->struct_info.struct_items.size(); u_index++) {
-                                const Type& u = ub->struct_info.struct_items[u_index];
-                                const std::string un = fmt::format("{}.glsl_uniforms[{}]", ubn, u_index);
-                                l("{}.type = {};\n", un, uniform_type(u.type));
-                                l("{}.array_count = {};\n", un, u.array_count);
-                                l("{}.glsl_name = \"{}.{}\";\n", un, ub->inst_name, u.name);
-                            }
-                        }
-                    }
+                if (sbuf->hlsl_register_u_n >= 0) {
+                    d(sbn + ".hlsl_register_u_n", fmt::format("{}", sbuf->hlsl_register_u_n));
                 }
+            } else if (Slang::is_msl(slang)) {
+                d(sbn + ".msl_buffer_n", fmt::format("{}", sbuf->msl_buffer_n));
+            } else if (Slang::is_wgsl(slang)) {
+                d(sbn + ".wgsl_group1_binding_n", fmt::format("{}", sbuf->wgsl_group1_binding_n));
+            } else if (Slang::is_spirv(slang)) {
+                d(sbn + ".spirv_set1_binding_n", fmt::format("{}", sbuf->spirv_set1_binding_n));
+            } else if (Slang::is_glsl(slang)) {
+                d(sbn + ".glsl_binding_n", fmt::format("{}", sbuf->glsl_binding_n));
             }
-            for (int view_index = 0; view_index < MaxViews; view_index++) {
-                const Bindings::View view = prog.bindings.get_view_by_sokol_slot(view_index);
-                if (view.type == BindSlot::Type::Texture) {
-                    const Texture* tex = &view.texture;
-                    const std::string& tn = fmt::format("desc.views[{}].texture", view_index);
-                    l("{}.stage = {};\n", tn, shader_stage(tex->stage));
-                    l("{}.image_type = {};\n", tn, image_type(tex->type));
-                    l("{}.sample_type = {};\n", tn, image_sample_type(tex->sample_type));
-                    l("{}.multisampled = {};\n", tn, tex->multisampled ? "true" : "false");
-                    if (Slang::is_hlsl(slang)) {
-                        l("{}.hlsl_register_t_n = {};\n", tn, tex->hlsl_register_t_n);
-                    } else if (Slang::is_msl(slang)) {
-                        l("{}.msl_texture_n = {};\n", tn, tex->msl_texture_n);
-                    } else if (Slang::is_wgsl(slang)) {
-                        l("{}.wgsl_group1_binding_n = {};\n", tn, tex->wgsl_group1_binding_n);
-                    } else if (Slang::is_spirv(slang)) {
-                        l("{}.spirv_set1_binding_n = {};\n", tn, tex->spirv_set1_binding_n);
-                    }
-                } else if (view.type == BindSlot::Type::StorageBuffer) {
-                    const StorageBuffer* sbuf = &view.storage_buffer;
-                    const std::string& sbn = fmt::format("desc.views[{}].storage_buffer", view_index);
-                    l("{}.stage = {};\n", sbn, shader_stage(sbuf->stage));
-                    l("{}.readonly = {};\n", sbn, sbuf->readonly);
-                    if (Slang::is_hlsl(slang)) {
-                        if (sbuf->hlsl_register_t_n >= 0) {
-                            l("{}.hlsl_register_t_n = {};\n", sbn, sbuf->hlsl_register_t_n);
-                        }
-                        if (sbuf->hlsl_register_u_n >= 0) {
-                            l("{}.hlsl_register_u_n = {};\n", sbn, sbuf->hlsl_register_u_n);
-                        }
-                    } else if (Slang::is_msl(slang)) {
-                        l("{}.msl_buffer_n = {};\n", sbn, sbuf->msl_buffer_n);
-                    } else if (Slang::is_wgsl(slang)) {
-                        l("{}.wgsl_group1_binding_n = {};\n", sbn, sbuf->wgsl_group1_binding_n);
-                    } else if (Slang::is_spirv(slang)) {
-                        l("{}.spirv_set1_binding_n = {};\n", sbn, sbuf->spirv_set1_binding_n);
-                    } else if (Slang::is_glsl(slang)) {
-                        l("{}.glsl_binding_n = {};\n", sbn, sbuf->glsl_binding_n);
-                    }
-                } else if (view.type == BindSlot::Type::StorageImage) {
-                    const StorageImage* simg = &view.storage_image;
-                    const std::string& sin = fmt::format("desc.views[{}].storage_image", view_index);
-                    l("{}.stage = {};\n", sin, shader_stage(simg->stage));
-                    l("{}.image_type = {};\n", sin, image_type(simg->type));
-                    l("{}.access_format = {};\n", sin, storage_pixel_format(simg->access_format));
-                    l("{}.writeonly = {};\n", sin, simg->writeonly);
-                    if (Slang::is_hlsl(slang)) {
-                        l("{}.hlsl_register_u_n = {};\n", sin, simg->hlsl_register_u_n);
-                    } else if (Slang::is_msl(slang)) {
-                        l("{}.msl_texture_n = {};\n", sin, simg->msl_texture_n);
-                    } else if (Slang::is_wgsl(slang)) {
-                        l("{}.wgsl_group1_binding_n = {};\n", sin, simg->wgsl_group1_binding_n);
-                    } else if (Slang::is_spirv(slang)) {
-                        l("{}.spirv_set1_binding_n = {};\n", sin, simg->spirv_set1_binding_n);
-                    } else if (Slang::is_glsl(slang)) {
-                        l("{}.glsl_binding_n = {};\n", sin, simg->glsl_binding_n);
-                    }
-                }
+        } else if (view.type == BindSlot::Type::StorageImage) {
+            const StorageImage* simg = &view.storage_image;
+            const std::string sin = fmt::format("views[{}].storage_image", view_index);
+            d(sin + ".stage", shader_stage(simg->stage));
+            d(sin + ".image_type", image_type(simg->type));
+            d(sin + ".access_format", storage_pixel_format(simg->access_format));
+            d(sin + ".writeonly", fmt::format("{}", simg->writeonly));
+            if (Slang::is_hlsl(slang)) {
+                d(sin + ".hlsl_register_u_n", fmt::format("{}", simg->hlsl_register_u_n));
+            } else if (Slang::is_msl(slang)) {
+                d(sin + ".msl_texture_n", fmt::format("{}", simg->msl_texture_n));
+            } else if (Slang::is_wgsl(slang)) {
+                d(sin + ".wgsl_group1_binding_n", fmt::format("{}", simg->wgsl_group1_binding_n));
+            } else if (Slang::is_spirv(slang)) {
+                d(sin + ".spirv_set1_binding_n", fmt::format("{}", simg->spirv_set1_binding_n));
+            } else if (Slang::is_glsl(slang)) {
+                d(sin + ".glsl_binding_n", fmt::format("{}", simg->glsl_binding_n));
             }
-            for (int smp_index = 0; smp_index < MaxSamplers; smp_index++) {
-                const Sampler* smp = prog.bindings.find_sampler_by_sokol_slot(smp_index);
-                if (smp) {
-                    const std::string sn = fmt::format("desc.samplers[{}]", smp_index);
-                    l("{}.stage = {};\n", sn, shader_stage(smp->stage));
-                    l("{}.sampler_type = {};\n", sn, sampler_type(smp->type));
-                    if (Slang::is_hlsl(slang)) {
-                        l("{}.hlsl_register_s_n = {};\n", sn, smp->hlsl_register_s_n);
-                    } else if (Slang::is_msl(slang)) {
-                        l("{}.msl_sampler_n = {};\n", sn, smp->msl_sampler_n);
-                    } else if (Slang::is_wgsl(slang)) {
-                        l("{}.wgsl_group1_binding_n = {};\n", sn, smp->wgsl_group1_binding_n);
-                    } else if (Slang::is_spirv(slang)) {
-                        l("{}.spirv_set1_binding_n = {};\n", sn, smp->spirv_set1_binding_n);
-                    }
-                }
+        }
+    }
+    for (int smp_index = 0; smp_index < MaxSamplers; smp_index++) {
+        const Sampler* smp = prog.bindings.find_sampler_by_sokol_slot(smp_index);
+        if (smp) {
+            const std::string sn = fmt::format("samplers[{}]", smp_index);
+            d(sn + ".stage", shader_stage(smp->stage));
+            d(sn + ".sampler_type", sampler_type(smp->type));
+            if (Slang::is_hlsl(slang)) {
+                d(sn + ".hlsl_register_s_n", fmt::format("{}", smp->hlsl_register_s_n));
+            } else if (Slang::is_msl(slang)) {
+                d(sn + ".msl_sampler_n", fmt::format("{}", smp->msl_sampler_n));
+            } else if (Slang::is_wgsl(slang)) {
+                d(sn + ".wgsl_group1_binding_n", fmt::format("{}", smp->wgsl_group1_binding_n));
+            } else if (Slang::is_spirv(slang)) {
+                d(sn + ".spirv_set1_binding_n", fmt::format("{}", smp->spirv_set1_binding_n));
             }
-            for (int tex_smp_index = 0; tex_smp_index < MaxTextureSamplers; tex_smp_index++) {
-                const TextureSampler* tex_smp = prog.bindings.find_texture_sampler_by_sokol_slot(tex_smp_index);
-                if (tex_smp) {
-                    const std::string tsn = fmt::format("desc.texture_sampler_pairs[{}]", tex_smp_index);
-                    l("{}.stage = {};\n", tsn, shader_stage(tex_smp->stage));
-                    l("{}.view_slot = {};\n", tsn, prog.bindings.find_texture_by_name(tex_smp->texture_name)->sokol_slot);
-                    l("{}.sampler_slot = {};\n", tsn, prog.bindings.find_sampler_by_name(tex_smp->sampler_name)->sokol_slot);
-                    if (Slang::is_glsl(slang)) {
-                        l("{}.glsl_name = \"{}\";\n", tsn, tex_smp->name);
-                    }
+        }
+    }
+    for (int tex_smp_index = 0; tex_smp_index < MaxTextureSamplers; tex_smp_index++) {
+        const TextureSampler* tex_smp = prog.bindings.find_texture_sampler_by_sokol_slot(tex_smp_index);
+        if (tex_smp) {
+            const std::string tsn = fmt::format("texture_sampler_pairs[{}]", tex_smp_index);
+            d(tsn + ".stage", shader_stage(tex_smp->stage));
+            d(tsn + ".view_slot", fmt::format("{}", prog.bindings.find_texture_by_name(tex_smp->texture_name)->sokol_slot));
+            d(tsn + ".sampler_slot", fmt::format("{}", prog.bindings.find_sampler_by_name(tex_smp->sampler_name)->sokol_slot));
+            if (Slang::is_glsl(slang)) {
+                d(tsn + ".glsl_name", fmt::format("\"{}\"", tex_smp->name));
+            }
+        }
+    }
+    d("label", fmt::format("\"{}{}_shader\"", mod_prefix, prog.name));
+    return items;
+}
+
+// The shader desc of each backend has its own accessor function, so that the linker can
+// drop the backends which are never referenced. In C the desc is a file-scope constant built
+// with designated initializers, C++ doesn't allow nested and array designators, so there it
+// is a function-local constant filled by a lambda during the (thread-safe) static initialization
+void SokolCGenerator::gen_backend_shader_desc(const GenInput& gen, const ProgramReflection& prog, Slang::Enum slang) {
+    const auto items = shader_desc_items(gen, prog, slang);
+    const std::string func_name = backend_shader_desc_func_name(prog.name, slang);
+    l("#if defined(__cplusplus)\n");
+    l_open("{}const sg_shader_desc* {}(void) {{\n", func_prefix, func_name);
+    l_open("static const sg_shader_desc desc = []() {{\n");
+    l("sg_shader_desc desc = {{}};\n");
+    for (const auto& item: items) {
+        l("desc.{} = {};\n", item.first, item.second);
+    }
+    l("return desc;\n");
+    l_close("}}();\n");
+    l("return &desc;\n");
+    l_close("}}\n");
+    l("#else\n");
+    l_open("static const sg_shader_desc _{} = {{\n", func_name);
+    for (const auto& item: items) {
+        l(".{} = {},\n", item.first, item.second);
+    }
+    l_close("}};\n");
+    l_open("{}const sg_shader_desc* {}(void) {{\n", func_prefix, func_name);
+    l("return &_{};\n", func_name);
+    l_close("}}\n");
+    l("#endif\n");
+}
+
+// with --split-backends, the per-backend shader descs live in the backend files
+// (see gen_shader_arrays()) and only exist when the backend file is included
+void SokolCGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramReflection& prog) {
+    if (!gen.args.split_backends) {
+        for (int i = 0; i < Slang::Num; i++) {
+            Slang::Enum slang = Slang::from_index(i);
+            if (gen.args.slang & Slang::bit(slang)) {
+                if (gen.args.ifdef) {
+                    l("#if defined({})\n", sokol_define(slang));
+                }
+                gen_backend_shader_desc(gen, prog, slang);
+                if (gen.args.ifdef) {
+                    l("#endif /* {} */\n", sokol_define(slang));
                 }
             }
-            l("desc.label = \"{}{}_shader\";\n", mod_prefix, prog.name);
+        }
+    }
+    l_open("{}const sg_shader_desc* {}{}_shader_desc(sg_backend backend) {{\n", func_prefix, mod_prefix, prog.name);
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            if (gen.args.ifdef || gen.args.split_backends) {
+                l("#if defined({})\n", sokol_define(slang));
+            }
+            l_open("if (backend == {}) {{\n", backend(slang));
+            l("return {}();\n", backend_shader_desc_func_name(prog.name, slang));
             l_close("}}\n");
-            l("return &desc;\n");
+            if (gen.args.ifdef || gen.args.split_backends) {
+                l("#endif /* {} */\n", sokol_define(slang));
+            }
+        }
+    }
+    l("return 0;\n");
+    l_close("}}\n");
+    l_open("{}uint64_t {}{}_content_hash(sg_backend backend) {{\n", func_prefix, mod_prefix, prog.name);
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            if (gen.args.ifdef) {
+                l("#if defined({})\n", sokol_define(slang));
+            }
+            l_open("if (backend == {}) {{\n", backend(slang));
+            l("return 0x{:016x}ULL;\n", program_content_hash(gen, prog, slang));
             l_close("}}\n");
             if (gen.args.ifdef) {
                 l("#endif /* {} */\n", sokol_define(slang));
@@ -445,16 +580,78 @@ void SokolCGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramRef
     l_close("}}\n");
 }
 
+// a module-level table of all programs for creating all shaders upfront (e.g. on a
+// loading screen), with O(1) lookup by program id and by name hash
+void SokolCGenerator::gen_program_registry(const GenInput& gen) {
+    const size_t n = gen.refl.progs.size();
+    if (n == 0) {
+        return;
+    }
+    std::vector<uint32_t> hashes;
+    l_open("static const sokol_shdc_program {}shader_registry[{}] = {{\n", registry_prefix, n);
+    for (int prog_id = 0; prog_id < (int)n; prog_id++) {
+        const ProgramReflection& prog = gen.refl.progs[prog_id];
+        const uint32_t name_hash = util::phash_str(name_hash_basis, prog.name);
+        hashes.push_back(name_hash);
+        l("{{ \"{}\", 0x{:08X}u, PROG_{}{}, {}{}_shader_desc, {}{}_content_hash }},\n",
+            prog.name, name_hash, registry_prefix, prog.name, mod_prefix, prog.name, mod_prefix, prog.name);
+    }
+    l_close("}};\n");
+    l_open("{}const sokol_shdc_program* {}shader_programs(int* out_num_programs) {{\n", func_prefix, registry_prefix);
+    l_open("if (out_num_programs) {{\n");
+    l("*out_num_programs = {};\n", n);
+    l_close("}}\n");
+    l("return {}shader_registry;\n", registry_prefix);
+    l_close("}}\n");
+    l_open("{}const sokol_shdc_program* {}shader_program_by_id(int id) {{\n", func_prefix, registry_prefix);
+    l_open("if ((id >= 0) && (id < {})) {{\n", n);
+    l("return &{}shader_registry[id];\n", registry_prefix);
+    l_close("}}\n");
+    l("return 0;\n");
+    l_close("}}\n");
+    l_open("{}const sokol_shdc_program* {}shader_program_by_name_hash(uint32_t name_hash) {{\n", func_prefix, registry_prefix);
+    std::vector<uint32_t> seeds;
+    std::vector<int> slots;
+    if (util::perfect_hash(hashes, seeds, slots)) {
+        std::vector<std::string> ids(n), seed_strs(n);
+        for (size_t i = 0; i < n; i++) {
+            ids[slots[i]] = std::to_string(i);
+            seed_strs[i] = fmt::format("{}u", seeds[i]);
+        }
+        l("static const int ids[{}] = {{ {} }};\n", n, pystring::join(", ", ids));
+        l("static const uint32_t seeds[{}] = {{ {} }};\n", n, pystring::join(", ", seed_strs));
+        l("const int id = ids[_sokol_shdc_mix(name_hash ^ seeds[_sokol_shdc_mix(name_hash) % {}]) % {}];\n", n, n);
+        l_open("if ({}shader_registry[id].name_hash == name_hash) {{\n", registry_prefix);
+        l("return &{}shader_registry[id];\n", registry_prefix);
+        l_close("}}\n");
+    } else {
+        l_open("for (int id = 0; id < {}; id++) {{\n", n);
+        l_open("if ({}shader_registry[id].name_hash == name_hash) {{\n", registry_prefix);
+        l("return &{}shader_registry[id];\n", registry_prefix);
+        l_close("}}\n");
+        l_close("}}\n");
+    }
+    l("return 0;\n");
+    l_close("}}\n");
+    l_open("{}const sokol_shdc_program* {}shader_program_by_name(const char* name) {{\n", func_prefix, registry_prefix);
+    l("const sokol_shdc_program* prog = {}shader_program_by_name_hash(_sokol_shdc_hash(0x{:08X}u, name));\n", registry_prefix, name_hash_basis);
+    l_open("if (prog && (0 == strcmp(prog->name, name))) {{\n");
+    l("return prog;\n");
+    l_close("}}\n");
+    l("return 0;\n");
+    l_close("}}\n");
+}
+
 void SokolCGenerator::gen_attr_slot_refl_func(const GenInput& gen, const ProgramReflection& prog) {
     l_open("{}int {}{}_attr_slot(const char* attr_name) {{\n", func_prefix, mod_prefix, prog.name);
     l("(void)attr_name;\n");
+    std::vector<std::pair<std::string, std::string>> items;
     for (const StageAttr& attr: prog.vs().inputs) {
         if (attr.slot >= 0) {
-            l_open("if (0 == strcmp(attr_name, \"{}\")) {{\n", attr.name);
-            l("return {};\n", attr.slot);
-            l_close("}}\n");
+            items.push_back({ attr.name, std::to_string(attr.slot) });
         }
     }
+    gen_name_lookup("attr_name", "int", items);
     l("return -1;\n");
     l_close("}}\n");
 }
@@ -462,13 +659,13 @@ void SokolCGenerator::gen_attr_slot_refl_func(const GenInput& gen, const Program
 void SokolCGenerator::gen_texture_slot_refl_func(const GenInput& gen, const ProgramReflection& prog) {
     l_open("{}int {}{}_texture_slot(const char* tex_name) {{\n", func_prefix, mod_prefix, prog.name);
     l("(void)tex_name;\n");
+    std::vector<std::pair<std::string, std::string>> items;
     for (const Texture& tex: prog.bindings.textures) {
         if (tex.sokol_slot >= 0) {
-            l_open("if (0 == strcmp(tex_name, \"{}\")) {{\n", tex.name);
-            l("return {};\n", tex.sokol_slot);
-            l_close("}}\n");
+            items.push_back({ tex.name, std::to_string(tex.sokol_slot) });
         }
     }
+    gen_name_lookup("tex_name", "int", items);
     l("return -1;\n");
     l_close("}}\n");
 }
@@ -476,13 +673,13 @@ void SokolCGenerator::gen_texture_slot_refl_func(const GenInput& gen, const Prog
 void SokolCGenerator::gen_sampler_slot_refl_func(const GenInput& gen, const ProgramReflection& prog) {
     l_open("{}int {}{}_sampler_slot(const char* smp_name) {{\n", func_prefix, mod_prefix, prog.name);
     l("(void)smp_name;\n");
+    std::vector<std::pair<std::string, std::string>> items;
     for (const Sampler& smp: prog.bindings.samplers) {
         if (smp.sokol_slot >= 0) {
-            l_open("if (0 == strcmp(smp_name, \"{}\")) {{\n", smp.name);
-            l("return {};\n", smp.sokol_slot);
-            l_close("}}\n");
+            items.push_back({ smp.name, std::to_string(smp.sokol_slot) });
         }
     }
+    gen_name_lookup("smp_name", "int", items);
     l("return -1;\n");
     l_close("}}\n");
 }
@@ -490,13 +687,13 @@ void SokolCGenerator::gen_sampler_slot_refl_func(const GenInput& gen, const Prog
 void SokolCGenerator::gen_uniform_block_slot_refl_func(const GenInput& gen, const ProgramReflection& prog) {
     l_open("{}int {}{}_uniformblock_slot(const char* ub_name) {{\n", func_prefix, mod_prefix, prog.name);
     l("(void)ub_name;\n");
+    std::vector<std::pair<std::string, std::string>> items;
     for (const UniformBlock& ub: prog.bindings.uniform_blocks) {
         if (ub.sokol_slot >= 0) {
-            l_open("if (0 == strcmp(ub_name, \"{}\")) {{\n", ub.name);
-            l("return {};\n", ub.sokol_slot);
-            l_close("}}\n");
+            items.push_back({ ub.name, std::to_string(ub.sokol_slot) });
         }
     }
+    gen_name_lookup("ub_name", "int", items);
     l("return -1;\n");
     l_close("}}\n");
 }
@@ -504,13 +701,13 @@ void SokolCGenerator::gen_uniform_block_slot_refl_func(const GenInput& gen, cons
 void SokolCGenerator::gen_uniform_block_size_refl_func(const GenInput& gen, const ProgramReflection& prog) {
     l_open("{}size_t {}{}_uniformblock_size(const char* ub_name) {{\n", func_prefix, mod_prefix, prog.name);
     l("(void)ub_name;\n");
+    std::vector<std::pair<std::string, std::string>> items;
     for (const UniformBlock& ub: prog.bindings.uniform_blocks) {
         if (ub.sokol_slot >= 0) {
-            l_open("if (0 == strcmp(ub_name, \"{}\")) {{\n", ub.name);
-            l("return sizeof({});\n", struct_name(ub.name));
-            l_close("}}\n");
+            items.push_back({ ub.name, fmt::format("sizeof({})", struct_name(ub.name)) });
         }
     }
+    gen_name_lookup("ub_name", "size_t", items);
     l("return 0;\n");
     l_close("}}\n");
 }
@@ -518,13 +715,13 @@ void SokolCGenerator::gen_uniform_block_size_refl_func(const GenInput& gen, cons
 void SokolCGenerator::gen_storage_buffer_slot_refl_func(const GenInput& gen, const ProgramReflection& prog) {
     l_open("{}int {}{}_storagebuffer_slot(const char* sbuf_name) {{\n", func_prefix, mod_prefix, prog.name);
     l("(void)sbuf_name;\n");
+    std::vector<std::pair<std::string, std::string>> items;
     for (const StorageBuffer& sbuf: prog.bindings.storage_buffers) {
         if (sbuf.sokol_slot >= 0) {
-            l_open("if (0 == strcmp(sbuf_name, \"{}\")) {{\n", sbuf.name);
-            l("return {};\n", sbuf.sokol_slot);
-            l_close("}}\n");
+            items.push_back({ sbuf.name, std::to_string(sbuf.sokol_slot) });
         }
     }
+    gen_name_lookup("sbuf_name", "int", items);
     l("return -1;\n");
     l_close("}}\n");
 }
@@ -532,59 +729,235 @@ void SokolCGenerator::gen_storage_buffer_slot_refl_func(const GenInput& gen, con
 void SokolCGenerator::gen_storage_image_slot_refl_func(const GenInput& gen, const ProgramReflection& prog) {
     l_open("{}int {}{}_storageimage_slot(const char* simg_name) {{\n", func_prefix, mod_prefix, prog.name);
     l("(void)simg_name;\n");
+    std::vector<std::pair<std::string, std::string>> items;
     for (const StorageImage& simg: prog.bindings.storage_images) {
         if (simg.sokol_slot >= 0) {
-            l_open("if (0 == strcmp(simg_name, \"{}\")) {{\n", simg.name);
-            l("return {};\n", simg.sokol_slot);
-            l_close("}}\n");
+            items.push_back({ simg.name, std::to_string(simg.sokol_slot) });
         }
     }
+    gen_name_lookup("simg_name", "int", items);
     l("return -1;\n");
     l_close("}}\n");
 }
 
 void SokolCGenerator::gen_uniform_offset_refl_func(const GenInput& gen, const ProgramReflection& prog) {
-    l_open("{}int {}{}_uniform_offset(const char* ub_name, const char* u_name) {{\n", func_prefix, mod_prefix, prog.name);
-    l("(void)ub_name; (void)u_name;\n");
+    l_open("{}int {}{}_uniform_offset_by_index(int ub_slot, int u_index) {{\n", func_prefix, mod_prefix, prog.name);
+    l("(void)ub_slot; (void)u_index;\n");
+    l_open("switch (ub_slot) {{\n");
     for (const UniformBlock& ub: prog.bindings.uniform_blocks) {
         if (ub.sokol_slot >= 0) {
-            l_open("if (0 == strcmp(ub_name, \"{}\")) {{\n", ub.name);
-            for (const Type& u: ub.struct_info.struct_items) {
-                l_open("if (0 == strcmp(u_name, \"{}\")) {{\n", u.name);
-                l("return {};\n", u.offset);
-                l_close("}}\n");
+            l_open("case {}:\n", ub.sokol_slot);
+            l_open("switch (u_index) {{\n");
+            for (int u_index = 0; u_index < (int)ub.struct_info.struct_items.size(); u_index++) {
+                l("case {}: return {};\n", u_index, ub.struct_info.struct_items[u_index].offset);
             }
+            l("default: break;\n");
             l_close("}}\n");
+            l("break;\n");
+            l_close();
         }
     }
+    l("default: break;\n");
+    l_close("}}\n");
+    l("return -1;\n");
+    l_close("}}\n");
+    l_open("{}int {}{}_uniform_offset(const char* ub_name, const char* u_name) {{\n", func_prefix, mod_prefix, prog.name);
+    l("(void)ub_name; (void)u_name;\n");
+    gen_uniform_name_lookup(prog, fmt::format("{}{}_uniform_offset_by_index", mod_prefix, prog.name));
     l("return -1;\n");
     l_close("}}\n");
 }
 
 void SokolCGenerator::gen_uniform_desc_refl_func(const GenInput& gen, const ProgramReflection& prog) {
-    l_open("{}sg_glsl_shader_uniform {}{}_uniform_desc(const char* ub_name, const char* u_name) {{\n", func_prefix, mod_prefix, prog.name);
-    l("(void)ub_name; (void)u_name;\n");
+    l_open("{}sg_glsl_shader_uniform {}{}_uniform_desc_by_index(int ub_slot, int u_index) {{\n", func_prefix, mod_prefix, prog.name);
+    l("(void)ub_slot; (void)u_index;\n");
     l("#if defined(__cplusplus)\n");
     l("sg_glsl_shader_uniform res = {{}};\n");
     l("#else\n");
     l("sg_glsl_shader_uniform res = {{0}};\n");
     l("#endif\n");
+    l_open("switch (ub_slot) {{\n");
     for (const UniformBlock& ub: prog.bindings.uniform_blocks) {
         if (ub.sokol_slot >= 0) {
-            l_open("if (0 == strcmp(ub_name, \"{}\")) {{\n", ub.name);
-            for (const Type& u: ub.struct_info.struct_items) {
-                l_open("if (0 == strcmp(u_name, \"{}\")) {{\n", u.name);
+            l_open("case {}:\n", ub.sokol_slot);
+            l_open("switch (u_index) {{\n");
+            for (int u_index = 0; u_index < (int)ub.struct_info.struct_items.size(); u_index++) {
+                const Type& u = ub.struct_info.struct_items[u_index];
+                l_open("case {}:\n", u_index);
                 l("res.type = {};\n", uniform_type(u.type));
                 l("res.array_count = {};\n", u.array_count);
                 l("res.glsl_name = \"{}\";\n", u.name);
-                l("return res;\n");
-                l_close("}}\n");
+                l("break;\n");
+                l_close();
             }
+            l("default: break;\n");
             l_close("}}\n");
+            l("break;\n");
+            l_close();
         }
     }
+    l("default: break;\n");
+    l_close("}}\n");
     l("return res;\n");
     l_close("}}\n");
+    l_open("{}sg_glsl_shader_uniform {}{}_uniform_desc(const char* ub_name, const char* u_name) {{\n", func_prefix, mod_prefix, prog.name);
+    l("(void)ub_name; (void)u_name;\n");
+    gen_uniform_name_lookup(prog, fmt::format("{}{}_uniform_desc_by_index", mod_prefix, prog.name));
+    l("return {}{}_uniform_desc_by_index(-1, -1);\n", mod_prefix, prog.name);
+    l_close("}}\n");
+}
+
+// hash-and-verify lookup of a name via a minimal perfect hash computed at generation
+// time, falls back to a strcmp() chain if no perfect hash could be found
+void SokolCGenerator::gen_name_lookup(const std::string& name_var, const std::string& value_type, const std::vector<std::pair<std::string, std::string>>& items) {
+    if (items.empty()) {
+        return;
+    }
+    std::vector<uint32_t> hashes;
+    for (const auto& item: items) {
+        hashes.push_back(util::phash_str(name_hash_basis, item.first));
+    }
+    std::vector<uint32_t> seeds;
+    std::vector<int> slots;
+    if (!util::perfect_hash(hashes, seeds, slots)) {
+        for (const auto& item: items) {
+            l_open("if (0 == strcmp({}, \"{}\")) {{\n", name_var, item.first);
+            l("return {};\n", item.second);
+            l_close("}}\n");
+        }
+        return;
+    }
+    const size_t n = items.size();
+    std::vector<std::string> names(n), values(n), seed_strs(n);
+    for (size_t i = 0; i < n; i++) {
+        names[slots[i]] = fmt::format("\"{}\"", items[i].first);
+        values[slots[i]] = items[i].second;
+        seed_strs[i] = fmt::format("{}u", seeds[i]);
+    }
+    l("static const char* const names[{}] = {{ {} }};\n", n, pystring::join(", ", names));
+    l("static const {} values[{}] = {{ {} }};\n", value_type, n, pystring::join(", ", values));
+    l("static const uint32_t seeds[{}] = {{ {} }};\n", n, pystring::join(", ", seed_strs));
+    l("const uint32_t h = _sokol_shdc_hash(0x{:08X}u, {});\n", name_hash_basis, name_var);
+    l("const uint32_t i = _sokol_shdc_mix(h ^ seeds[_sokol_shdc_mix(h) % {}]) % {};\n", n, n);
+    l_open("if (0 == strcmp({}, names[i])) {{\n", name_var);
+    l("return values[i];\n");
+    l_close("}}\n");
+}
+
+// same as gen_name_lookup(), but for the ub_name/u_name pair of the uniform reflection
+// functions, the key is hashed as 'ub_name.u_name' and forwarded to a *_by_index() function
+void SokolCGenerator::gen_uniform_name_lookup(const ProgramReflection& prog, const std::string& by_index_func) {
+    struct Item {
+        const UniformBlock* ub;
+        int u_index;
+    };
+    std::vector<Item> items;
+    std::vector<uint32_t> hashes;
+    for (const UniformBlock& ub: prog.bindings.uniform_blocks) {
+        if (ub.sokol_slot >= 0) {
+            for (int u_index = 0; u_index < (int)ub.struct_info.struct_items.size(); u_index++) {
+                items.push_back({ &ub, u_index });
+                hashes.push_back(util::phash_str(name_hash_basis, fmt::format("{}.{}", ub.name, ub.struct_info.struct_items[u_index].name)));
+            }
+        }
+    }
+    if (items.empty()) {
+        return;
+    }
+    std::vector<uint32_t> seeds;
+    std::vector<int> slots;
+    if (!util::perfect_hash(hashes, seeds, slots)) {
+        for (const UniformBlock& ub: prog.bindings.uniform_blocks) {
+            if (ub.sokol_slot >= 0) {
+                l_open("if (0 == strcmp(ub_name, \"{}\")) {{\n", ub.name);
+                for (int u_index = 0; u_index < (int)ub.struct_info.struct_items.size(); u_index++) {
+                    l_open("if (0 == strcmp(u_name, \"{}\")) {{\n", ub.struct_info.struct_items[u_index].name);
+                    l("return {}({}, {});\n", by_index_func, ub.sokol_slot, u_index);
+                    l_close("}}\n");
+                }
+                l_close("}}\n");
+            }
+        }
+        return;
+    }
+    const size_t n = items.size();
+    std::vector<std::string> ub_names(n), u_names(n), ub_slots(n), u_indices(n), seed_strs(n);
+    for (size_t i = 0; i < n; i++) {
+        const Item& item = items[i];
+        ub_names[slots[i]] = fmt::format("\"{}\"", item.ub->name);
+        u_names[slots[i]] = fmt::format("\"{}\"", item.ub->struct_info.struct_items[item.u_index].name);
+        ub_slots[slots[i]] = std::to_string(item.ub->sokol_slot);
+        u_indices[slots[i]] = std::to_string(item.u_index);
+        seed_strs[i] = fmt::format("{}u", seeds[i]);
+    }
+    l("static const char* const ub_names[{}] = {{ {} }};\n", n, pystring::join(", ", ub_names));
+    l("static const char* const u_names[{}] = {{ {} }};\n", n, pystring::join(", ", u_names));
+    l("static const int ub_slots[{}] = {{ {} }};\n", n, pystring::join(", ", ub_slots));
+    l("static const int u_indices[{}] = {{ {} }};\n", n, pystring::join(", ", u_indices));
+    l("static const uint32_t seeds[{}] = {{ {} }};\n", n, pystring::join(", ", seed_strs));
+    l("const uint32_t h = _sokol_shdc_hash(_sokol_shdc_hash(_sokol_shdc_hash(0x{:08X}u, ub_name), \".\"), u_name);\n", name_hash_basis);
+    l("const uint32_t i = _sokol_shdc_mix(h ^ seeds[_sokol_shdc_mix(h) % {}]) % {};\n", n, n);
+    l_open("if ((0 == strcmp(ub_name, ub_names[i])) && (0 == strcmp(u_name, u_names[i]))) {{\n");
+    l("return {}(ub_slots[i], u_indices[i]);\n", by_index_func);
+    l_close("}}\n");
+}
+
+// with --split-backends the shader arrays and shader descs of each shader language are
+// written to a separate file next to the output file, which is only included for the
+// matching SOKOL_* backend define
+void SokolCGenerator::gen_shader_arrays(const GenInput& gen) {
+    if (!gen.args.split_backends) {
+        Generator::gen_shader_arrays(gen);
+        return;
+    }
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            const std::string path = backend_file_path(gen, slang);
+            const std::string name = pystring::os::path::basename(path);
+            // the backend file is streamed through its own output sink
+            OutputSink backend_sink;
+            ErrMsg err = open_output(gen, backend_sink, path, true);
+            if (err.valid()) {
+                if (!backend_file_error.valid()) {
+                    backend_file_error = err;
+                }
+                continue;
+            }
+            content.swap(backend_sink);
+            l("#pragma once\n");
+            l("/* {} shader code for {}, machine generated, don't edit! */\n", Slang::to_str(slang), pystring::os::path::basename(gen.args.output));
+            gen_slang_shader_arrays(gen, slang);
+            for (const ProgramReflection& prog: gen.refl.progs) {
+                gen_backend_shader_desc(gen, prog, slang);
+            }
+            content.swap(backend_sink);
+            err = close_output(gen, backend_sink);
+            if (err.valid() && !backend_file_error.valid()) {
+                backend_file_error = err;
+            }
+            l("#if defined({})\n", sokol_define(slang));
+            l("#include \"{}\"\n", name);
+            l("#endif\n");
+        }
+    }
+}
+
+std::string SokolCGenerator::backend_file_path(const GenInput& gen, Slang::Enum slang) {
+    std::string root, ext;
+    pystring::os::path::splitext(root, ext, gen.args.output);
+    return fmt::format("{}.{}{}", root, Slang::to_str(slang), ext);
+}
+
+std::string SokolCGenerator::backend_shader_desc_func_name(const std::string& prog_name, Slang::Enum slang) {
+    return fmt::format("{}{}_shader_desc_{}", mod_prefix, prog_name, Slang::to_str(slang));
+}
+
+ErrMsg SokolCGenerator::end(const GenInput& gen) {
+    if (backend_file_error.valid()) {
+        return backend_file_error;
+    }
+    return Generator::end(gen);
 }
 
 void SokolCGenerator::gen_shader_array_start(const GenInput& gen, const std::string& array_name, size_t num_bytes, Slang::Enum slang) {
@@ -601,6 +974,15 @@ void SokolCGenerator::gen_shader_array_end(const GenInput& gen) {
     }
 }
 
+// with --ifdef, arrays can only be shared between shader languages of the same backend,
+// and with --split-backends only within the same shader language file
+std::string SokolCGenerator::shader_array_group(const GenInput& gen, Slang::Enum slang) {
+    if (gen.args.split_backends) {
+        return Slang::to_str(slang);
+    }
+    return gen.args.ifdef ? sokol_define(slang) : "";
+}
+
 void SokolCGenerator::gen_stb_impl_start(const GenInput &gen) {
     if (gen.args.output_format == Format::SOKOL_IMPL) {
         l("#if defined(SOKOL_SHDC_IMPL)\n");
@@ -798,6 +1180,10 @@ std::string SokolCGenerator::uniform_block_bind_slot_name(const UniformBlock& ub
     return fmt::format("UB_{}{}", mod_prefix, ub.name);
 }
 
+std::string SokolCGenerator::shader_hash_name(const std::string& prog_name, ShaderStage::Enum stage, Slang::Enum slang) {
+    return fmt::format("HASH_{}{}_{}_{}", mod_prefix, prog_name, ShaderStage::to_str(stage), Slang::to_str(slang));
+}
+
 std::string SokolCGenerator::vertex_attr_definition(const std::string& prog_name, const StageAttr& attr) {
     return fmt::format("#define {} ({})", vertex_attr_name(prog_name, attr), attr.slot);
 }
@@ -814,6 +1200,10 @@ std::string SokolCGenerator::uniform_block_bind_slot_definition(const UniformBlo
     return fmt::format("#define {} ({})", uniform_block_bind_slot_name(ub), ub.sokol_slot);
 }
 
+std::string SokolCGenerator::shader_hash_definition(const std::string& prog_name, ShaderStage::Enum stage, Slang::Enum slang, uint64_t hash) {
+    return fmt::format("#define {} (0x{:016x}ULL)", shader_hash_name(prog_name, stage, slang), hash);
+}
+
 std::string SokolCGenerator::storage_buffer_bind_slot_definition(const StorageBuffer& sbuf) {
     return fmt::format("#define {} ({})", storage_buffer_bind_slot_name(sbuf), sbuf.sokol_slot);
 }
@@ -5,19 +5,25 @@ namespace shdc::gen {
 
 class SokolCGenerator: public Generator {
     std::string mod_prefix;
+    std::string registry_prefix;    // --registry: mod_prefix, or derived from the output filename without a @module
     std::string func_prefix;
+    ErrMsg backend_file_error;  // --split-backends: first error when writing a backend file
 protected:
     virtual ErrMsg begin(const GenInput& gen);
+    virtual ErrMsg end(const GenInput& gen);
     virtual void gen_prolog(const GenInput& gen);
     virtual void gen_epilog(const GenInput& gen);
     virtual void gen_prerequisites(const GenInput& gen);
     virtual void gen_uniform_block_decl(const GenInput& gen, const refl::UniformBlock& ub);
     virtual void gen_storage_buffer_decl(const GenInput& gen, const refl::Type& struc);
+    virtual void gen_shader_arrays(const GenInput& gen);
     virtual void gen_shader_array_start(const GenInput& gen, const std::string& array_name, size_t num_bytes, Slang::Enum slang);
     virtual void gen_shader_array_end(const GenInput& gen);
+    virtual std::string shader_array_group(const GenInput& gen, Slang::Enum slang);
     virtual void gen_stb_impl_start(const GenInput& gen);
     virtual void gen_stb_impl_end(const GenInput& gen);
     virtual void gen_shader_desc_func(const GenInput& gen, const refl::ProgramReflection& prog);
+    virtual void gen_program_registry(const GenInput& gen);
     virtual void gen_attr_slot_refl_func(const GenInput& gen, const refl::ProgramReflection& prog);
     virtual void gen_texture_slot_refl_func(const GenInput& gen, const refl::ProgramReflection& prog);
     virtual void gen_sampler_slot_refl_func(const GenInput& gen, const refl::ProgramReflection& progm);
@@ -48,15 +54,23 @@ protected:
     virtual std::string texture_bind_slot_name(const refl::Texture& tex);
     virtual std::string sampler_bind_slot_name(const refl::Sampler& smp);
     virtual std::string uniform_block_bind_slot_name(const refl::UniformBlock& ub);
+    virtual std::string shader_hash_name(const std::string& prog_name, ShaderStage::Enum stage, Slang::Enum slang);
     virtual std::string storage_buffer_bind_slot_name(const refl::StorageBuffer& sbuf);
     virtual std::string storage_image_bind_slot_name(const refl::StorageImage& simg);
     virtual std::string vertex_attr_definition(const std::string& prog_name, const refl::StageAttr& attr);
     virtual std::string texture_bind_slot_definition(const refl::Texture& tex);
     virtual std::string sampler_bind_slot_definition(const refl::Sampler& smp);
     virtual std::string uniform_block_bind_slot_definition(const refl::UniformBlock& ub);
+    virtual std::string shader_hash_definition(const std::string& prog_name, ShaderStage::Enum stage, Slang::Enum slang, uint64_t hash);
     virtual std::string storage_buffer_bind_slot_definition(const refl::StorageBuffer& sbuf);
     virtual std::string storage_image_bind_slot_definition(const refl::StorageImage& simg);
 private:
+    std::vector<std::pair<std::string, std::string>> shader_desc_items(const GenInput& gen, const refl::ProgramReflection& prog, Slang::Enum slang);
+    void gen_backend_shader_desc(const GenInput& gen, const refl::ProgramReflection& prog, Slang::Enum slang);
+    std::string backend_file_path(const GenInput& gen, Slang::Enum slang);
+    std::string backend_shader_desc_func_name(const std::string& prog_name, Slang::Enum slang);
+    void gen_name_lookup(const std::string& name_var, const std::string& value_type, const std::vector<std::pair<std::string, std::string>>& items);
+    void gen_uniform_name_lookup(const refl::ProgramReflection& prog, const std::string& by_index_func);
     virtual void gen_struct_interior_decl_std430(const GenInput& gen, const refl::Type& struc, int pad_to_size);
 };
 
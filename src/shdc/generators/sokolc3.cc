@@ -190,187 +190,201 @@ void SokolC3Generator::gen_storage_buffer_decl(const GenInput& gen, const Type&
     l_close("}}\n");
 }
 
-void SokolC3Generator::gen_shader_desc_func(const GenInput& gen, const ProgramReflection& prog) {
-    l("fn SgShaderDesc {}_shader_desc(SgBackend backend)\n", prog.name);
-    l_open("{{\n");
-    l("SgShaderDesc desc;\n");
-    l("desc.label = \"{}_shader\";\n", prog.name);
-    l("switch (backend)\n");
-    l_open("{{\n");
-    for (int i = 0; i < Slang::Num; i++) {
-        Slang::Enum slang = Slang::from_index(i);
-        if (gen.args.slang & Slang::bit(slang)) {
-            l_open("case {}:\n", backend(slang));
-            for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
-                const ShaderStageArrayInfo& info = shader_stage_array_info(gen, prog, ShaderStage::from_index(stage_index), slang);
-                if (info.stage == ShaderStage::Invalid) {
-                    continue;
-                }
-                const StageReflection& refl = prog.stages[stage_index];
-                std::string dsn;
-                switch (info.stage) {
-                    case ShaderStage::Vertex: dsn = "desc.vertex_func"; break;
-                    case ShaderStage::Fragment: dsn = "desc.fragment_func"; break;
-                    case ShaderStage::Compute: dsn = "desc.compute_func"; break;
-                    default: dsn = "INVALID"; break;
+std::vector<std::pair<std::string, std::string>> SokolC3Generator::shader_desc_items(const GenInput& gen, const ProgramReflection& prog, Slang::Enum slang) {
+    std::vector<std::pair<std::string, std::string>> items;
+    const auto d = [&items](const std::string& path, const std::string& value) {
+        items.push_back({ path, value });
+    };
+    d("label", fmt::format("\"{}_shader\"", prog.name));
+    for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
+        const ShaderStageArrayInfo& info = shader_stage_array_info(gen, prog, ShaderStage::from_index(stage_index), slang);
+        if (info.stage == ShaderStage::Invalid) {
+            continue;
+        }
+        const StageReflection& refl = prog.stages[stage_index];
+        std::string dsn;
+        switch (info.stage) {
+            case ShaderStage::Vertex: dsn = "vertex_func"; break;
+            case ShaderStage::Fragment: dsn = "fragment_func"; break;
+            case ShaderStage::Compute: dsn = "compute_func"; break;
+            default: dsn = "INVALID"; break;
+        }
+        if (info.has_bytecode) {
+            d(dsn + ".bytecode.ptr", fmt::format("&{}", info.bytecode_array_name));
+            d(dsn + ".bytecode.size", fmt::format("{}", info.bytecode_array_size));
+        } else {
+            d(dsn + ".source", fmt::format("(ZString)&{}", info.source_array_name));
+            const char* d3d11_tgt = hlsl_target(slang, info.stage);
+            if (d3d11_tgt) {
+                d(dsn + ".d3d11_target", fmt::format("\"{}\"", d3d11_tgt));
+            }
+        }
+        d(dsn + ".entry", fmt::format("\"{}\"", refl.entry_point_by_slang(slang)));
+    }
+    if (Slang::is_msl(slang) && prog.has_cs()) {
+        d("mtl_threads_per_threadgroup.x", fmt::format("{}", prog.cs().cs_workgroup_size[0]));
+        d("mtl_threads_per_threadgroup.y", fmt::format("{}", prog.cs().cs_workgroup_size[1]));
+        d("mtl_threads_per_threadgroup.z", fmt::format("{}", prog.cs().cs_workgroup_size[2]));
+    }
+    if (prog.has_vs()) {
+        for (int attr_index = 0; attr_index < StageAttr::Num; attr_index++) {
+            const StageAttr& attr = prog.vs().inputs[attr_index];
+            if (attr.slot >= 0) {
+                d(fmt::format("attrs[{}].base_type", attr_index), attr_basetype(attr.type_info.basetype()));
+                if (Slang::is_glsl(slang)) {
+                    d(fmt::format("attrs[{}].glsl_name", attr_index), fmt::format("\"{}\"", attr.name));
+                } else if (Slang::is_hlsl(slang)) {
+                    d(fmt::format("attrs[{}].hlsl_sem_name", attr_index), fmt::format("\"{}\"", attr.sem_name));
+                    d(fmt::format("attrs[{}].hlsl_sem_index", attr_index), fmt::format("{}", attr.sem_index));
                 }
-                if (info.has_bytecode) {
-                    l("{}.bytecode.ptr = &{};\n", dsn, info.bytecode_array_name);
-                    l("{}.bytecode.size = {};\n", dsn, info.bytecode_array_size);
+            }
+        }
+    }
+    for (int ub_index = 0; ub_index < MaxUniformBlocks; ub_index++) {
+        const UniformBlock* ub = prog.bindings.find_uniform_block_by_sokol_slot(ub_index);
+        if (ub) {
+            const std::string ubn = fmt::format("uniform_blocks[{}]", ub_index);
+            d(ubn + ".stage", shader_stage(ub->stage));
+            d(ubn + ".layout", "SgUniformLayout.STD140");
+            d(ubn + ".size", fmt::format("{}", roundup(ub->struct_info.size, 16)));
+            if (Slang::is_hlsl(slang)) {
+                d(ubn + ".hlsl_register_b_n", fmt::format("{}", ub->hlsl_register_b_n));
+            } else if (Slang::is_msl(slang)) {
+                d(ubn + ".msl_buffer_n", fmt::format("{}", ub->msl_buffer_n));
+            } else if (Slang::is_wgsl(slang)) {
+                d(ubn + ".wgsl_group0_binding_n", fmt::format("{}", ub->wgsl_group0_binding_n));
+            } else if (Slang::is_spirv(slang)) {
+                d(ubn + ".spirv_set0_binding_n", fmt::format("{}", ub->spirv_set0_binding_n));
+            } else if (Slang::is_glsl(slang) && (ub->struct_info.struct_items.size() > 0)) {
+                if (ub->flattened) {
+                    // NOT A BUG (to take the type from the first struct item, but the size from the toplevel ub)
+                    d(ubn + ".glsl_uniforms[0].type", flattened_uniform_type(ub->struct_info.struct_items[0].type));
+                    d(ubn + ".glsl_uniforms[0].array_count", fmt::format("{}", roundup(ub->struct_info.size, 16) / 16));
+                    d(ubn + ".glsl_uniforms[0].glsl_name", fmt::format("\"{}\"", ub->name));
                 } else {
-                    l("{}.source = (ZString)&{};\n", dsn, info.source_array_name);
-                    const char* d3d11_tgt = hlsl_target(slang, info.stage);
-                    if (d3d11_tgt) {
-                        l("{}.d3d11_target = \"{}\";\n", dsn, d3d11_tgt);
+                    for (int u_index = 0; u_index < (int)ub->struct_info.struct_items.size(); u_index++) {
+                        const Type& u = ub->struct_info.struct_items[u_index];
+                        const std::string un = fmt::format("{}.glsl_uniforms[{}]", ubn, u_index);
+                        d(un + ".type", uniform_type(u.type));
+                        d(un + ".array_count", fmt::format("{}", u.array_count));
+                        d(un + ".glsl_name", fmt::format("\"{}.{}\"", ub->inst_name, u.name));
                     }
                 }
-                l("{}.entry = \"{}\";\n", dsn, refl.entry_point_by_slang(slang));
             }
-            if (Slang::is_msl(slang) && prog.has_cs()) {
-                l("desc.mtl_threads_per_threadgroup.x = {};\n", prog.cs().cs_workgroup_size[0]);
-                l("desc.mtl_threads_per_threadgroup.y = {};\n", prog.cs().cs_workgroup_size[1]);
-                l("desc.mtl_threads_per_threadgroup.z = {};\n", prog.cs().cs_workgroup_size[2]);
+        }
+    }
+    for (int view_index = 0; view_index < MaxViews; view_index++) {
+        const Bindings::View view = prog.bindings.get_view_by_sokol_slot(view_index);
+        if (view.type == BindSlot::Type::Texture) {
+            const Texture* tex = &view.texture;
+            const std::string tn = fmt::format("views[{}].texture", view_index);
+            d(tn + ".stage", shader_stage(tex->stage));
+            d(tn + ".multisampled", fmt::format("{}", tex->multisampled ? "true" : "false"));
+            d(tn + ".image_type", image_type(tex->type));
+            d(tn + ".sample_type", image_sample_type(tex->sample_type));
+            if (Slang::is_hlsl(slang)) {
+                d(tn + ".hlsl_register_t_n", fmt::format("{}", tex->hlsl_register_t_n));
+            } else if (Slang::is_msl(slang)) {
+                d(tn + ".msl_texture_n", fmt::format("{}", tex->msl_texture_n));
+            } else if (Slang::is_wgsl(slang)) {
+                d(tn + ".wgsl_group1_binding_n", fmt::format("{}", tex->wgsl_group1_binding_n));
+            } else if (Slang::is_spirv(slang)) {
+                d(tn + ".spirv_set1_binding_n", fmt::format("{}", tex->spirv_set1_binding_n));
             }
-            if (prog.has_vs()) {
-                for (int attr_index = 0; attr_index < StageAttr::Num; attr_index++) {
-                    const StageAttr& attr = prog.vs().inputs[attr_index];
-                    if (attr.slot >= 0) {
-                        l("desc.attrs[{}].base_type = {};\n", attr_index, attr_basetype(attr.type_info.basetype()));
-                        if (Slang::is_glsl(slang)) {
-                            l("desc.attrs[{}].glsl_name = \"{}\";\n", attr_index, attr.name);
-                        } else if (Slang::is_hlsl(slang)) {
-                            l("desc.attrs[{}].hlsl_sem_name = \"{}\";\n", attr_index, attr.sem_name);
-                            l("desc.attrs[{}].hlsl_sem_index = {};\n", attr_index, attr.sem_index);
-                        }
-                    }
+        } else if (view.type == BindSlot::Type::StorageBuffer) {
+            const StorageBuffer* sbuf = &view.storage_buffer;
+            const std::string& sbn = fmt::format("views[{}].storage_buffer", view_index);
+            d(sbn + ".stage", shader_stage(sbuf->stage));
+            d(sbn + ".readonly", fmt::format("{}", sbuf->readonly));
+            if (Slang::is_hlsl(slang)) {
+                if (sbuf->hlsl_register_t_n >= 0) {
+                    d(sbn + ".hlsl_register_t_n", fmt::format("{}", sbuf->hlsl_register_t_n));
                 }
-            }
-            for (int ub_index = 0; ub_index < MaxUniformBlocks; ub_index++) {
-                const UniformBlock* ub = prog.bindings.find_uniform_block_by_sokol_slot(ub_index);
-                if (ub) {
-                    const std::string ubn = fmt::format("desc.uniform_blocks[{}]", ub_index);
-                    l("{}.stage = {};\n", ubn, shader_stage(ub->stage));
-                    l("{}.layout = SgUniformLayout.STD140;\n", ubn);
-                    l("{}.size = {};\n", ubn, roundup(ub->struct_info.size, 16));
-                    if (Slang::is_hlsl(slang)) {
-                        l("{}.hlsl_register_b_n = {};\n", ubn, ub->hlsl_register_b_n);
-                    } else if (Slang::is_msl(slang)) {
-                        l("{}.msl_buffer_n = {};\n", ubn, ub->msl_buffer_n);
-                    } else if (Slang::is_wgsl(slang)) {
-                        l("{}.wgsl_group0_binding_n = {};\n", ubn, ub->wgsl_group0_binding_n);
-                    } else if (Slang::is_spirv(slang)) {
-                        l("{}.spirv_set0_binding_n = {};\n", ubn, ub->spirv_set0_binding_n);
-                    } else if (Slang::is_glsl(slang) && (ub->struct_info.struct_items.size() > 0)) {
-                        if (ub->flattened) {
-                            // NOT A BUG (to take the type from the first struct item, but the size from the toplevel ub)
-                            l("{}.glsl_uniforms[0].type = {};\n", ubn, flattened_uniform_type(ub->struct_info.struct_items[0].type));
-                            l("{}.glsl_uniforms[0].array_count = {};\n", ubn, roundup(ub->struct_info.size, 16) / 16);
-                            l("{}.glsl_uniforms[0].glsl_name = \"{}\";\n", ubn, ub->name);
-                        } else {
-                            for (int u_index = 0; u_index < (int)ub->struct_info.struct_items.size(); u_index++) {
-                                const Type& u = ub->struct_info.struct_items[u_index];
-                                const std::string un = fmt::format("{}.glsl_uniforms[{}]", ubn, u_index);
-                                l("{}.type = {};\n", un, uniform_type(u.type));
-                                l("{}.array_count = {};\n", un, u.array_count);
-                                l("{}.glsl_name = \"{}.{}\";\n", un, ub->inst_name, u.name);
-                            }
-                        }
-                    }
+                if (sbuf->hlsl_register_u_n >= 0) {
+                    d(sbn + ".hlsl_register_u_n", fmt::format("{}", sbuf->hlsl_register_u_n));
                 }
+            } else if (Slang::is_msl(slang)) {
+                d(sbn + ".msl_buffer_n", fmt::format("{}", sbuf->msl_buffer_n));
+            } else if (Slang::is_wgsl(slang)) {
+                d(sbn + ".wgsl_group1_binding_n", fmt::format("{}", sbuf->wgsl_group1_binding_n));
+            } else if (Slang::is_spirv(slang)) {
+                d(sbn + ".spirv_set1_binding_n", fmt::format("{}", sbuf->spirv_set1_binding_n));
+            } else if (Slang::is_glsl(slang)) {
+                d(sbn + ".glsl_binding_n", fmt::format("{}", sbuf->glsl_binding_n));
             }
-            for (int view_index = 0; view_index < MaxViews; view_index++) {
-                const Bindings::View view = prog.bindings.get_view_by_sokol_slot(view_index);
-                if (view.type == BindSlot::Type::Texture) {
-                    const Texture* tex = &view.texture;
-                    const std::string tn = fmt::format("desc.views[{}].texture", view_index);
-                    l("{}.stage = {};\n", tn, shader_stage(tex->stage));
-                    l("{}.multisampled = {};\n", tn, tex->multisampled ? "true" : "false");
-                    l("{}.image_type = {};\n", tn, image_type(tex->type));
-                    l("{}.sample_type = {};\n", tn, image_sample_type(tex->sample_type));
-                    if (Slang::is_hlsl(slang)) {
-                        l("{}.hlsl_register_t_n = {};\n", tn, tex->hlsl_register_t_n);
-                    } else if (Slang::is_msl(slang)) {
-                        l("{}.msl_texture_n = {};\n", tn, tex->msl_texture_n);
-                    } else if (Slang::is_wgsl(slang)) {
-                        l("{}.wgsl_group1_binding_n = {};\n", tn, tex->wgsl_group1_binding_n);
-                    } else if (Slang::is_spirv(slang)) {
-                        l("{}.spirv_set1_binding_n = {};\n", tn, tex->spirv_set1_binding_n);
-                    }
-                } else if (view.type == BindSlot::Type::StorageBuffer) {
-                    const StorageBuffer* sbuf = &view.storage_buffer;
-                    const std::string& sbn = fmt::format("desc.views[{}].storage_buffer", view_index);
-                    l("{}.stage = {};\n", sbn, shader_stage(sbuf->stage));
-                    l("{}.readonly = {};\n", sbn, sbuf->readonly);
-                    if (Slang::is_hlsl(slang)) {
-                        if (sbuf->hlsl_register_t_n >= 0) {
-                            l("{}.hlsl_register_t_n = {};\n", sbn, sbuf->hlsl_register_t_n);
-                        }
-                        if (sbuf->hlsl_register_u_n >= 0) {
-                            l("{}.hlsl_register_u_n = {};\n", sbn, sbuf->hlsl_register_u_n);
-                        }
-                    } else if (Slang::is_msl(slang)) {
-                        l("{}.msl_buffer_n = {};\n", sbn, sbuf->msl_buffer_n);
-                    } else if (Slang::is_wgsl(slang)) {
-                        l("{}.wgsl_group1_binding_n = {};\n", sbn, sbuf->wgsl_group1_binding_n);
-                    } else if (Slang::is_spirv(slang)) {
-                        l("{}.spirv_set1_binding_n = {};\n", sbn, sbuf->spirv_set1_binding_n);
-                    } else if (Slang::is_glsl(slang)) {
-                        l("{}.glsl_binding_n = {};\n", sbn, sbuf->glsl_binding_n);
-                    }
-                } else if (view.type == BindSlot::Type::StorageImage) {
-                    const StorageImage* simg = &view.storage_image;
-                    const std::string& sin = fmt::format("desc.views[{}].storage_image", view_index);
-                    l("{}.stage = {};\n", sin, shader_stage(simg->stage));
-                    l("{}.image_type = {};\n", sin, image_type(simg->type));
-                    l("{}.access_format = {};\n", sin, storage_pixel_format(simg->access_format));
-                    l("{}.writeonly = {};\n", sin, simg->writeonly);
-                    if (Slang::is_hlsl(slang)) {
-                        l("{}.hlsl_register_u_n = {};\n", sin, simg->hlsl_register_u_n);
-                    } else if (Slang::is_msl(slang)) {
-                        l("{}.msl_texture_n = {};\n", sin, simg->msl_texture_n);
-                    } else if (Slang::is_wgsl(slang)) {
-                        l("{}.wgsl_group1_binding_n = {};\n", sin, simg->wgsl_group1_binding_n);
-                    } else if (Slang::is_spirv(slang)) {
-                        l("{}.spirv_set1_binding_n = {};\n", sin, simg->spirv_set1_binding_n);
-                    } else if (Slang::is_glsl(slang)) {
-                        l("{}.glsl_binding_n = {};\n", sin, simg->glsl_binding_n);
-                    }
-                }
+        } else if (view.type == BindSlot::Type::StorageImage) {
+            const StorageImage* simg = &view.storage_image;
+            const std::string& sin = fmt::format("views[{}].storage_image", view_index);
+            d(sin + ".stage", shader_stage(simg->stage));
+            d(sin + ".image_type", image_type(simg->type));
+            d(sin + ".access_format", storage_pixel_format(simg->access_format));
+            d(sin + ".writeonly", fmt::format("{}", simg->writeonly));
+            if (Slang::is_hlsl(slang)) {
+                d(sin + ".hlsl_register_u_n", fmt::format("{}", simg->hlsl_register_u_n));
+            } else if (Slang::is_msl(slang)) {
+                d(sin + ".msl_texture_n", fmt::format("{}", simg->msl_texture_n));
+            } else if (Slang::is_wgsl(slang)) {
+                d(sin + ".wgsl_group1_binding_n", fmt::format("{}", simg->wgsl_group1_binding_n));
+            } else if (Slang::is_spirv(slang)) {
+                d(sin + ".spirv_set1_binding_n", fmt::format("{}", simg->spirv_set1_binding_n));
+            } else if (Slang::is_glsl(slang)) {
+                d(sin + ".glsl_binding_n", fmt::format("{}", simg->glsl_binding_n));
             }
-            for (int smp_index = 0; smp_index < MaxSamplers; smp_index++) {
-                const Sampler* smp = prog.bindings.find_sampler_by_sokol_slot(smp_index);
-                if (smp) {
-                    const std::string sn = fmt::format("desc.samplers[{}]", smp_index);
-                    l("{}.stage = {};\n", sn, shader_stage(smp->stage));
-                    l("{}.sampler_type = {};\n", sn, sampler_type(smp->type));
-                    if (Slang::is_hlsl(slang)) {
-                        l("{}.hlsl_register_s_n = {};\n", sn, smp->hlsl_register_s_n);
-                    } else if (Slang::is_msl(slang)) {
-                        l("{}.msl_sampler_n = {};\n", sn, smp->msl_sampler_n);
-                    } else if (Slang::is_wgsl(slang)) {
-                        l("{}.wgsl_group1_binding_n = {};\n", sn, smp->wgsl_group1_binding_n);
-                    } else if (Slang::is_spirv(slang)) {
-                        l("{}.spirv_set1_binding_n = {};\n", sn, smp->spirv_set1_binding_n);
-                    }
-                }
+        }
+    }
+    for (int smp_index = 0; smp_index < MaxSamplers; smp_index++) {
+        const Sampler* smp = prog.bindings.find_sampler_by_sokol_slot(smp_index);
+        if (smp) {
+            const std::string sn = fmt::format("samplers[{}]", smp_index);
+            d(sn + ".stage", shader_stage(smp->stage));
+            d(sn + ".sampler_type", sampler_type(smp->type));
+            if (Slang::is_hlsl(slang)) {
+                d(sn + ".hlsl_register_s_n", fmt::format("{}", smp->hlsl_register_s_n));
+            } else if (Slang::is_msl(slang)) {
+                d(sn + ".msl_sampler_n", fmt::format("{}", smp->msl_sampler_n));
+            } else if (Slang::is_wgsl(slang)) {
+                d(sn + ".wgsl_group1_binding_n", fmt::format("{}", smp->wgsl_group1_binding_n));
+            } else if (Slang::is_spirv(slang)) {
+                d(sn + ".spirv_set1_binding_n", fmt::format("{}", smp->spirv_set1_binding_n));
             }
-            for (int tex_smp_index = 0; tex_smp_index < MaxTextureSamplers; tex_smp_index++) {
-                const TextureSampler* tex_smp = prog.bindings.find_texture_sampler_by_sokol_slot(tex_smp_index);
-                if (tex_smp) {
-                    const std::string tsn = fmt::format("desc.texture_sampler_pairs[{}]", tex_smp_index);
-                    l("{}.stage = {};\n", tsn, shader_stage(tex_smp->stage));
-                    l("{}.view_slot = {};\n", tsn, prog.bindings.find_texture_by_name(tex_smp->texture_name)->sokol_slot);
-                    l("{}.sampler_slot = {};\n", tsn, prog.bindings.find_sampler_by_name(tex_smp->sampler_name)->sokol_slot);
-                    if (Slang::is_glsl(slang)) {
-                        l("{}.glsl_name = \"{}\";\n", tsn, tex_smp->name);
-                    }
-                }
+        }
+    }
+    for (int tex_smp_index = 0; tex_smp_index < MaxTextureSamplers; tex_smp_index++) {
+        const TextureSampler* tex_smp = prog.bindings.find_texture_sampler_by_sokol_slot(tex_smp_index);
+        if (tex_smp) {
+            const std::string tsn = fmt::format("texture_sampler_pairs[{}]", tex_smp_index);
+            d(tsn + ".stage", shader_stage(tex_smp->stage));
+            d(tsn + ".view_slot", fmt::format("{}", prog.bindings.find_texture_by_name(tex_smp->texture_name)->sokol_slot));
+            d(tsn + ".sampler_slot", fmt::format("{}", prog.bindings.find_sampler_by_name(tex_smp->sampler_name)->sokol_slot));
+            if (Slang::is_glsl(slang)) {
+                d(tsn + ".glsl_name", fmt::format("\"{}\"", tex_smp->name));
             }
-            l_close(); // current switch branch
         }
     }
+    return items;
+}
+
+void SokolC3Generator::gen_shader_desc_func(const GenInput& gen, const ProgramReflection& prog) {
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            l_open("const SgShaderDesc {}_shader_desc_{} = {{\n", prog.name, Slang::to_str(slang));
+            gen_designated_initializer(shader_desc_items(gen, prog, slang));
+            l_close("}};\n");
+        }
+    }
+    l("fn SgShaderDesc {}_shader_desc(SgBackend backend)\n", prog.name);
+    l_open("{{\n");
+    l("switch (backend)\n");
+    l_open("{{\n");
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            l("case {}: return {}_shader_desc_{};\n", backend(slang), prog.name, Slang::to_str(slang));
+        }
+    }
+    l("default: return {{}};\n");
     l_close("}}\n"); // close switch statement
-    l("return desc;\n");
     l_close("}}\n"); // close function
 }
 
@@ -378,6 +392,10 @@ void SokolC3Generator::gen_shader_array_start(const GenInput& gen, const std::st
     l("const char[{}] {} @private = {{\n", num_bytes, array_name);
 }
 
+void SokolC3Generator::gen_shader_array_embed(const GenInput& gen, const std::string& array_name, const std::string& file_name, size_t num_bytes, Slang::Enum slang) {
+    l("const char[{}] {} @private = $embed(\"{}\");\n", num_bytes, array_name, file_name);
+}
+
 void SokolC3Generator::gen_shader_array_end(const GenInput& gen) {
     l("\n}};\n");
 }
@@ -567,6 +585,10 @@ std::string SokolC3Generator::uniform_block_bind_slot_name(const UniformBlock& u
     return pystring::upper(fmt::format("UB_{}", ub.name));
 }
 
+std::string SokolC3Generator::shader_hash_name(const std::string& prog_name, ShaderStage::Enum stage, Slang::Enum slang) {
+    return pystring::upper(fmt::format("HASH_{}_{}_{}", prog_name, ShaderStage::to_str(stage), Slang::to_str(slang)));
+}
+
 std::string SokolC3Generator::vertex_attr_definition(const std::string& prog_name, const StageAttr& attr) {
     return fmt::format("const int {} = {};", vertex_attr_name(prog_name, attr), attr.slot);
 }
@@ -583,6 +605,10 @@ std::string SokolC3Generator::uniform_block_bind_slot_definition(const UniformBl
     return fmt::format("const int {} = {};", uniform_block_bind_slot_name(ub), ub.sokol_slot);
 }
 
+std::string SokolC3Generator::shader_hash_definition(const std::string& prog_name, ShaderStage::Enum stage, Slang::Enum slang, uint64_t hash) {
+    return fmt::format("const ulong {} = 0x{:016x};", shader_hash_name(prog_name, stage, slang), hash);
+}
+
 std::string SokolC3Generator::storage_buffer_bind_slot_definition(const StorageBuffer& sbuf) {
     return fmt::format("const int {} = {};", storage_buffer_bind_slot_name(sbuf), sbuf.sokol_slot);
 }
@@ -197,19 +197,23 @@ void SokolDGenerator::gen_shader_array_start(const GenInput& gen, const std::str
     l("__gshared char[{}] {} = [\n", num_bytes, array_name);
 
 }
+// import() looks up files in the string import paths (-J command line option)
+void SokolDGenerator::gen_shader_array_embed(const GenInput& gen, const std::string& array_name, const std::string& file_name, size_t num_bytes, Slang::Enum slang) {
+    l("__gshared char[{}] {} = import(\"{}\");\n", num_bytes, array_name, file_name);
+}
+
 void SokolDGenerator::gen_shader_array_end(const GenInput& gen) {
     l("\n];\n");
 }
 
 void SokolDGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramReflection& prog) {
-    l_open("sg.ShaderDesc {}ShaderDesc(sg.Backend backend) @trusted @nogc nothrow {{\n", prog.name);
-    l("sg.ShaderDesc desc;\n");
-    l("desc.label = \"{}_shader\";\n", prog.name);
-    l_open("switch (backend) {{\n");
     for (int i = 0; i < Slang::Num; i++) {
         Slang::Enum slang = Slang::from_index(i);
         if (gen.args.slang & Slang::bit(slang)) {
-            l_open("case {}:\n", backend(slang));
+            // module-level initializers are evaluated at compile time (CTFE)
+            l_open("__gshared sg.ShaderDesc {}ShaderDesc{} = () {{\n", prog.name, to_pascal_case(Slang::to_str(slang)));
+            l("sg.ShaderDesc desc;\n");
+            l("desc.label = \"{}_shader\";\n", prog.name);
             for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
                 const ShaderStageArrayInfo& info = shader_stage_array_info(gen, prog, ShaderStage::from_index(stage_index), slang);
                 if (info.stage == ShaderStage::Invalid) {
@@ -375,13 +379,20 @@ void SokolDGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramRef
                     }
                 }
             }
-            l("break;\n");
-            l_close(); // current switch branch
+            l("return desc;\n");
+            l_close("}}();\n");
         }
     }
-    l("default: break;\n");
+    l_open("sg.ShaderDesc {}ShaderDesc(sg.Backend backend) @trusted @nogc nothrow {{\n", prog.name);
+    l_open("switch (backend) {{\n");
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            l("case {}: return {}ShaderDesc{};\n", backend(slang), prog.name, to_pascal_case(Slang::to_str(slang)));
+        }
+    }
+    l("default: return sg.ShaderDesc.init;\n");
     l_close("}}\n"); // close switch statement
-    l("return desc;\n");
     l_close("}}\n"); // close function
 }
 
@@ -570,6 +581,10 @@ std::string SokolDGenerator::uniform_block_bind_slot_name(const UniformBlock& ub
     return pystring::upper(fmt::format("UB_{}", ub.name));
 }
 
+std::string SokolDGenerator::shader_hash_name(const std::string& prog_name, ShaderStage::Enum stage, Slang::Enum slang) {
+    return pystring::upper(fmt::format("HASH_{}_{}_{}", prog_name, ShaderStage::to_str(stage), Slang::to_str(slang)));
+}
+
 static std::string const_def(const std::string& name, int slot) {
     return fmt::format("enum {} = {};", name, slot);
 }
@@ -590,6 +605,10 @@ std::string SokolDGenerator::uniform_block_bind_slot_definition(const UniformBlo
     return const_def(uniform_block_bind_slot_name(ub), ub.sokol_slot);
 }
 
+std::string SokolDGenerator::shader_hash_definition(const std::string& prog_name, ShaderStage::Enum stage, Slang::Enum slang, uint64_t hash) {
+    return fmt::format("enum ulong {} = 0x{:016x}UL;", shader_hash_name(prog_name, stage, slang), hash);
+}
+
 std::string SokolDGenerator::storage_buffer_bind_slot_definition(const StorageBuffer& sbuf) {
     return const_def(storage_buffer_bind_slot_name(sbuf), sbuf.sokol_slot);
 }
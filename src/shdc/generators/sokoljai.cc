@@ -187,14 +187,13 @@ void SokolJaiGenerator::gen_storage_buffer_decl(const GenInput& gen, const Type&
 }
 
 void SokolJaiGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramReflection& prog) {
-    l_open("{}_shader_desc :: (backend: sg_backend) -> sg_shader_desc {{\n", prog.name);
-    l("desc: sg_shader_desc;\n");
-    l("desc.label = \"{}_shader\";\n", prog.name);
-    l("if backend == {{\n");
     for (int i = 0; i < Slang::Num; i++) {
         Slang::Enum slang = Slang::from_index(i);
         if (gen.args.slang & Slang::bit(slang)) {
-            l_open("case {};\n", backend(slang));
+            // the descriptor is evaluated at compile time with #run
+            l_open("{}_shader_desc_{} :: #run -> sg_shader_desc {{\n", prog.name, Slang::to_str(slang));
+            l("desc: sg_shader_desc;\n");
+            l("desc.label = \"{}_shader\";\n", prog.name);
             for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
                 const ShaderStageArrayInfo& info = shader_stage_array_info(gen, prog, ShaderStage::from_index(stage_index), slang);
                 if (info.stage == ShaderStage::Invalid) {
@@ -360,11 +359,20 @@ void SokolJaiGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
                     }
                 }
             }
-            l_close(); // current switch branch
+            l("return desc;\n");
+            l_close("}};\n");
+        }
+    }
+    l_open("{}_shader_desc :: (backend: sg_backend) -> sg_shader_desc {{\n", prog.name);
+    l("if backend == {{\n");
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            l("case {}; return {}_shader_desc_{};\n", backend(slang), prog.name, Slang::to_str(slang));
         }
     }
     l("}}\n"); // close switch statement
-    l("return desc;\n");
+    l("return .{{}};\n");
     l_close("}}\n"); // close function
 }
 
@@ -561,6 +569,10 @@ std::string SokolJaiGenerator::uniform_block_bind_slot_name(const UniformBlock&
     return fmt::format("UB_{}", ub.name);
 }
 
+std::string SokolJaiGenerator::shader_hash_name(const std::string& prog_name, ShaderStage::Enum stage, Slang::Enum slang) {
+    return fmt::format("HASH_{}_{}_{}", prog_name, ShaderStage::to_str(stage), Slang::to_str(slang));
+}
+
 std::string SokolJaiGenerator::vertex_attr_definition(const std::string& prog_name, const StageAttr& attr) {
     return fmt::format("{} :: {};", vertex_attr_name(prog_name, attr), attr.slot);
 }
@@ -577,6 +589,10 @@ std::string SokolJaiGenerator::uniform_block_bind_slot_definition(const UniformB
     return fmt::format("{} :: {};", uniform_block_bind_slot_name(ub), ub.sokol_slot);
 }
 
+std::string SokolJaiGenerator::shader_hash_definition(const std::string& prog_name, ShaderStage::Enum stage, Slang::Enum slang, uint64_t hash) {
+    return fmt::format("{} : u64 : 0x{:016x};", shader_hash_name(prog_name, stage, slang), hash);
+}
+
 std::string SokolJaiGenerator::storage_buffer_bind_slot_definition(const StorageBuffer& sbuf) {
     return fmt::format("{} :: {};", storage_buffer_bind_slot_name(sbuf), sbuf.sokol_slot);
 }
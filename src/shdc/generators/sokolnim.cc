@@ -10,71 +10,22 @@ namespace shdc::gen {
 
 using namespace refl;
 
-// need to special-case the gen-shader-arrays function because Nim
-// needs the type appeneded to the first array element
-void SokolNimGenerator::gen_shader_arrays(const GenInput& gen) {
-    for (int slang_idx = 0; slang_idx < Slang::Num; slang_idx++) {
-        Slang::Enum slang = Slang::from_index(slang_idx);
-        if (gen.args.slang & Slang::bit(slang)) {
-            const Spirvcross& spirvcross = gen.spirvcross[slang];
-            const Bytecode& bytecode = gen.bytecode[slang];
-            for (int snippet_index = 0; snippet_index < (int)gen.inp.snippets.size(); snippet_index++) {
-                const Snippet& snippet = gen.inp.snippets[snippet_index];
-                if ((snippet.type != Snippet::VS) && (snippet.type != Snippet::FS) && (snippet.type != Snippet::CS)) {
-                    continue;
-                }
-                const SpirvcrossSource* src = spirvcross.find_source_by_snippet_index(snippet_index);
-                assert(src);
-                const BytecodeBlob* blob = bytecode.find_blob_by_snippet_index(snippet_index);
-                std::vector<std::string> lines;
-                pystring::splitlines(src->source_code, lines);
-                // first write the source code in a comment block
-                cbl_start();
-                for (const std::string& line: lines) {
-                    cbl("{}\n", fix_shader_source_for_code_comment(line));
-                }
-                cbl_end();
-                if (blob) {
-                    const std::string array_name = shader_bytecode_array_name(snippet.name, slang);
-                    gen_shader_array_start(gen, array_name, blob->data.size(), slang);
-                    const size_t len = blob->data.size();
-                    for (size_t i = 0; i < len; i++) {
-                        if ((i & 15) == 0) {
-                            l("    ");
-                        }
-                        if (0 == i) {
-                            l("{:#04x}'u8,", blob->data[i]);
-                        } else {
-                            l("{:#04x},", blob->data[i]);
-                        }
-                        if ((i & 15) == 15) {
-                            l("\n");
-                        }
-                    }
-                    gen_shader_array_end(gen);
-                } else {
-                    // if no bytecode exists, write the source code, but also a byte array with a trailing 0
-                    const std::string array_name = shader_source_array_name(snippet.name, slang);
-                    const size_t len = src->source_code.length() + 1;
-                    gen_shader_array_start(gen, array_name, len, slang);
-                    for (size_t i = 0; i < len; i++) {
-                        if ((i & 15) == 0) {
-                            l("    ");
-                        }
-                        if (0 == i) {
-                            l("{:#04x}'u8,", (int)src->source_code[i]);
-                        } else {
-                            l("{:#04x},", (int)src->source_code[i]);
-                        }
-                        if ((i & 15) == 15) {
-                            l("\n");
-                        }
-                    }
-                    gen_shader_array_end(gen);
-                }
-            }
-        }
+// need to special-case the gen-shader-array function because Nim
+// needs the type appended to the first array element
+void SokolNimGenerator::gen_shader_array(const GenInput& gen, const std::string& array_name, const std::string& file_path, const uint8_t* data, size_t num_bytes, bool is_source, Slang::Enum slang) {
+    if (gen.args.array_encoding == ArrayEncoding::EMBED) {
+        Generator::gen_shader_array(gen, array_name, file_path, data, num_bytes, is_source, slang);
+        return;
     }
+    gen_shader_array_start(gen, array_name, num_bytes, slang);
+    hex_bytes(data, num_bytes, "'u8");
+    gen_shader_array_end(gen);
+}
+
+// staticRead() returns a string which is kept as a string constant, the
+// shader desc points directly at its data (see gen_shader_desc_func())
+void SokolNimGenerator::gen_shader_array_embed(const GenInput& gen, const std::string& array_name, const std::string& file_name, size_t num_bytes, Slang::Enum slang) {
+    l("const {} = staticRead(\"{}\")\n", array_name, file_name);
 }
 
 void SokolNimGenerator::gen_prolog(const GenInput& gen) {
@@ -270,13 +221,14 @@ void SokolNimGenerator::gen_storage_buffer_decl(const GenInput& gen, const Type&
 }
 
 void SokolNimGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramReflection& prog) {
-    l_open("proc {}ShaderDesc*(backend: sg.Backend): sg.ShaderDesc =\n", to_camel_case(prog.name));
-    l("result.label = \"{}_shader\"\n", prog.name);
-    l_open("case backend:\n");
     for (int i = 0; i < Slang::Num; i++) {
         Slang::Enum slang = Slang::from_index(i);
         if (gen.args.slang & Slang::bit(slang)) {
-            l_open("of {}:\n", backend(slang));
+            // Nim constants can't hold pointers, so this is a module-level 'let' which is
+            // initialized once at module initialization
+            l_open("let {}ShaderDesc{}*: sg.ShaderDesc = block:\n", to_camel_case(prog.name), to_pascal_case(Slang::to_str(slang)));
+            l("var desc: sg.ShaderDesc\n");
+            l("desc.label = \"{}_shader\"\n", prog.name);
             for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
                 const ShaderStageArrayInfo& info = shader_stage_array_info(gen, prog, ShaderStage::from_index(stage_index), slang);
                 if (info.stage == ShaderStage::Invalid) {
@@ -285,16 +237,25 @@ void SokolNimGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
                 const StageReflection& refl = prog.stages[stage_index];
                 std::string dsn;
                 switch (info.stage) {
-                    case ShaderStage::Vertex: dsn = "result.vertexFunc"; break;
-                    case ShaderStage::Fragment: dsn = "result.fragmentFunc"; break;
-                    case ShaderStage::Compute: dsn = "result.computeFunc"; break;
+                    case ShaderStage::Vertex: dsn = "desc.vertexFunc"; break;
+                    case ShaderStage::Fragment: dsn = "desc.fragmentFunc"; break;
+                    case ShaderStage::Compute: dsn = "desc.computeFunc"; break;
                     default: dsn = "INVALID"; break;
                 }
+                const bool embed = gen.args.array_encoding == ArrayEncoding::EMBED;
                 if (info.has_bytecode) {
-                    l("{}.bytecode.ptr = {}\n", dsn, info.bytecode_array_name);
+                    if (embed) {
+                        l("{}.bytecode.ptr = cast[pointer](cstring({}))\n", dsn, info.bytecode_array_name);
+                    } else {
+                        l("{}.bytecode.ptr = {}\n", dsn, info.bytecode_array_name);
+                    }
                     l("{}.bytecode.size = {}\n", dsn, info.bytecode_array_size);
                 } else {
-                    l("{}.source = cast[cstring](addr({}))\n", dsn, info.source_array_name);
+                    if (embed) {
+                        l("{}.source = cstring({})\n", dsn, info.source_array_name);
+                    } else {
+                        l("{}.source = cast[cstring](addr({}))\n", dsn, info.source_array_name);
+                    }
                     const char* d3d11_tgt = hlsl_target(slang, info.stage);
                     if (d3d11_tgt) {
                         l("{}.d3d11Target = \"{}\"\n", dsn, d3d11_tgt);
@@ -303,20 +264,20 @@ void SokolNimGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
                 l("{}.entry = \"{}\"\n", dsn, refl.entry_point_by_slang(slang));
             }
             if (Slang::is_msl(slang) && prog.has_cs()) {
-                l("result.mtlThreadsPerThreadgroup.x = {}\n", prog.cs().cs_workgroup_size[0]);
-                l("result.mtlThreadsPerThreadgroup.y = {}\n", prog.cs().cs_workgroup_size[1]);
-                l("result.mtlThreadsPerThreadgroup.z = {}\n", prog.cs().cs_workgroup_size[2]);
+                l("desc.mtlThreadsPerThreadgroup.x = {}\n", prog.cs().cs_workgroup_size[0]);
+                l("desc.mtlThreadsPerThreadgroup.y = {}\n", prog.cs().cs_workgroup_size[1]);
+                l("desc.mtlThreadsPerThreadgroup.z = {}\n", prog.cs().cs_workgroup_size[2]);
             }
             if (prog.has_vs()) {
                 for (int attr_index = 0; attr_index < StageAttr::Num; attr_index++) {
                     const StageAttr& attr = prog.vs().inputs[attr_index];
                     if (attr.slot >= 0) {
-                        l("result.attrs[{}].base_type = {}\n", attr_index, attr_basetype(attr.type_info.basetype()));
+                        l("desc.attrs[{}].base_type = {}\n", attr_index, attr_basetype(attr.type_info.basetype()));
                         if (Slang::is_glsl(slang)) {
-                            l("result.attrs[{}].glslName = \"{}\"\n", attr_index, attr.name);
+                            l("desc.attrs[{}].glslName = \"{}\"\n", attr_index, attr.name);
                         } else if (Slang::is_hlsl(slang)) {
-                            l("result.attrs[{}].hlslSemName = \"{}\"\n", attr_index, attr.sem_name);
-                            l("result.attrs[{}].hlslSemIndex = {}\n", attr_index, attr.sem_index);
+                            l("desc.attrs[{}].hlslSemName = \"{}\"\n", attr_index, attr.sem_name);
+                            l("desc.attrs[{}].hlslSemIndex = {}\n", attr_index, attr.sem_index);
                         }
                     }
                 }
@@ -324,7 +285,7 @@ void SokolNimGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
             for (int ub_index = 0; ub_index < MaxUniformBlocks; ub_index++) {
                 const UniformBlock* ub = prog.bindings.find_uniform_block_by_sokol_slot(ub_index);
                 if (ub) {
-                    const std::string ubn = fmt::format("result.uniformBlocks[{}]", ub_index);
+                    const std::string ubn = fmt::format("desc.uniformBlocks[{}]", ub_index);
                     l("{}.stage = {}\n", ubn, shader_stage(ub->stage));
                     l("{}.layout = uniformLayoutStd140\n", ubn);
                     l("{}.size = {}\n", ubn, roundup(ub->struct_info.size, 16));
@@ -358,7 +319,7 @@ void SokolNimGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
                 const Bindings::View view = prog.bindings.get_view_by_sokol_slot(view_index);
                 if (view.type == BindSlot::Type::Texture) {
                     const Texture* tex = &view.texture;
-                    const std::string tn = fmt::format("result.views[{}].texture", view_index);
+                    const std::string tn = fmt::format("desc.views[{}].texture", view_index);
                     l("{}.stage = {}\n", tn, shader_stage(tex->stage));
                     l("{}.multisampled = {}\n", tn, tex->multisampled ? "true" : "false");
                     l("{}.imageType = {}\n", tn, image_type(tex->type));
@@ -374,7 +335,7 @@ void SokolNimGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
                     }
                 } else if (view.type == BindSlot::Type::StorageBuffer) {
                     const StorageBuffer* sbuf = &view.storage_buffer;
-                    const std::string& sbn = fmt::format("result.views[{}].storageBuffer", view_index);
+                    const std::string& sbn = fmt::format("desc.views[{}].storageBuffer", view_index);
                     l("{}.stage = {}\n", sbn, shader_stage(sbuf->stage));
                     l("{}.readonly = {}\n", sbn, sbuf->readonly);
                     if (Slang::is_hlsl(slang)) {
@@ -395,7 +356,7 @@ void SokolNimGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
                     }
                 } else if (view.type == BindSlot::Type::StorageImage) {
                     const StorageImage* simg = &view.storage_image;
-                    const std::string& sin = fmt::format("result.views[{}].storageImage", view_index);
+                    const std::string& sin = fmt::format("desc.views[{}].storageImage", view_index);
                     l("{}.stage = {}\n", sin, shader_stage(simg->stage));
                     l("{}.imageType = {}\n", sin, image_type(simg->type));
                     l("{}.accessFormat = {}\n", sin, storage_pixel_format(simg->access_format));
@@ -416,7 +377,7 @@ void SokolNimGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
             for (int smp_index = 0; smp_index < MaxSamplers; smp_index++) {
                 const Sampler* smp = prog.bindings.find_sampler_by_sokol_slot(smp_index);
                 if (smp) {
-                    const std::string sn = fmt::format("result.samplers[{}]", smp_index);
+                    const std::string sn = fmt::format("desc.samplers[{}]", smp_index);
                     l("{}.stage = {}\n", sn, shader_stage(smp->stage));
                     l("{}.samplerType = {}\n", sn, sampler_type(smp->type));
                     if (Slang::is_hlsl(slang)) {
@@ -433,7 +394,7 @@ void SokolNimGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
             for (int tex_smp_index = 0; tex_smp_index < MaxTextureSamplers; tex_smp_index++) {
                 const TextureSampler* tex_smp = prog.bindings.find_texture_sampler_by_sokol_slot(tex_smp_index);
                 if (tex_smp) {
-                    const std::string tsn = fmt::format("result.textureSamplerPairs[{}]", tex_smp_index);
+                    const std::string tsn = fmt::format("desc.textureSamplerPairs[{}]", tex_smp_index);
                     l("{}.stage = {}\n", tsn, shader_stage(tex_smp->stage));
                     l("{}.viewSlot = {}\n", tsn, prog.bindings.find_texture_by_name(tex_smp->texture_name)->sokol_slot);
                     l("{}.samplerSlot = {}\n", tsn, prog.bindings.find_sampler_by_name(tex_smp->sampler_name)->sokol_slot);
@@ -442,7 +403,16 @@ void SokolNimGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
                     }
                 }
             }
-            l_close(); // current switch branch
+            l("desc\n");
+            l_close();
+        }
+    }
+    l_open("proc {}ShaderDesc*(backend: sg.Backend): sg.ShaderDesc =\n", to_camel_case(prog.name));
+    l_open("case backend:\n");
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            l("of {}: result = {}ShaderDesc{}\n", backend(slang), to_camel_case(prog.name), to_pascal_case(Slang::to_str(slang)));
         }
     }
     l("else: discard\n");
@@ -643,6 +613,10 @@ std::string SokolNimGenerator::uniform_block_bind_slot_name(const UniformBlock&
     return to_camel_case(fmt::format("UB_{}", ub.name));
 }
 
+std::string SokolNimGenerator::shader_hash_name(const std::string& prog_name, ShaderStage::Enum stage, Slang::Enum slang) {
+    return to_camel_case(fmt::format("HASH_{}_{}_{}", prog_name, ShaderStage::to_str(stage), Slang::to_str(slang)));
+}
+
 std::string SokolNimGenerator::vertex_attr_definition(const std::string& prog_name, const StageAttr& attr) {
     return fmt::format("const {}* = {}", vertex_attr_name(prog_name, attr), attr.slot);
 }
@@ -659,6 +633,10 @@ std::string SokolNimGenerator::uniform_block_bind_slot_definition(const UniformB
     return fmt::format("const {}* = {}", uniform_block_bind_slot_name(ub), ub.sokol_slot);
 }
 
+std::string SokolNimGenerator::shader_hash_definition(const std::string& prog_name, ShaderStage::Enum stage, Slang::Enum slang, uint64_t hash) {
+    return fmt::format("const {}* = 0x{:016x}'u64", shader_hash_name(prog_name, stage, slang), hash);
+}
+
 std::string SokolNimGenerator::storage_buffer_bind_slot_definition(const StorageBuffer& sbuf) {
     return fmt::format("const {}* = {}", storage_buffer_bind_slot_name(sbuf), sbuf.sokol_slot);
 }
@@ -196,14 +196,16 @@ void SokolOdinGenerator::gen_storage_buffer_decl(const GenInput& gen, const Type
 }
 
 void SokolOdinGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramReflection& prog) {
-    l_open("{}_shader_desc :: proc \"c\" (backend: sg.Backend) -> sg.Shader_Desc {{\n", prog.name);
-    l("desc: sg.Shader_Desc\n");
-    l("desc.label = \"{}_shader\"\n", prog.name);
-    l("#partial switch backend {{\n");
     for (int i = 0; i < Slang::Num; i++) {
         Slang::Enum slang = Slang::from_index(i);
         if (gen.args.slang & Slang::bit(slang)) {
-            l_open("case {}:\n", backend(slang));
+            // Odin has no compile-time evaluation of pointer-holding values, the
+            // per-backend descriptors are filled once before main() by an @(init) proc
+            l("{}_shader_desc_{}: sg.Shader_Desc\n", prog.name, Slang::to_str(slang));
+            l("@(init, private=\"file\")\n");
+            l_open("{}_shader_desc_{}_init :: proc \"contextless\" () {{\n", prog.name, Slang::to_str(slang));
+            l("desc := &{}_shader_desc_{}\n", prog.name, Slang::to_str(slang));
+            l("desc.label = \"{}_shader\"\n", prog.name);
             for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
                 const ShaderStageArrayInfo& info = shader_stage_array_info(gen, prog, ShaderStage::from_index(stage_index), slang);
                 if (info.stage == ShaderStage::Invalid) {
@@ -218,10 +220,10 @@ void SokolOdinGenerator::gen_shader_desc_func(const GenInput& gen, const Program
                     default: dsn = "INVALID";
                 }
                 if (info.has_bytecode) {
-                    l("{}.bytecode.ptr = &{}\n", dsn, info.bytecode_array_name);
+                    l("{}.bytecode.ptr = raw_data({}[:])\n", dsn, info.bytecode_array_name);
                     l("{}.bytecode.size = {}\n", dsn, info.bytecode_array_size);
                 } else {
-                    l("{}.source = transmute(cstring)&{}\n", dsn, info.source_array_name);
+                    l("{}.source = cstring(raw_data({}[:]))\n", dsn, info.source_array_name);
                     const char* d3d11_tgt = hlsl_target(slang, info.stage);
                     if (d3d11_tgt) {
                         l("{}.d3d11_target = \"{}\"\n", dsn, d3d11_tgt);
@@ -369,11 +371,19 @@ void SokolOdinGenerator::gen_shader_desc_func(const GenInput& gen, const Program
                     }
                 }
             }
-            l_close(); // current switch branch
+            l_close("}}\n");
+        }
+    }
+    l_open("{}_shader_desc :: proc \"c\" (backend: sg.Backend) -> sg.Shader_Desc {{\n", prog.name);
+    l("#partial switch backend {{\n");
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            l("case {}: return {}_shader_desc_{}\n", backend(slang), prog.name, Slang::to_str(slang));
         }
     }
     l("}}\n"); // close switch statement
-    l("return desc\n");
+    l("return {{}}\n");
     l_close("}}\n"); // close function
 }
 
@@ -510,6 +520,12 @@ void SokolOdinGenerator::gen_shader_array_start(const GenInput& gen, const std::
     l("@(private=\"file\")\n{} := [{}]u8 {{\n", array_name, num_bytes);
 }
 
+// #load() returns a []u8 slice instead of a fixed-size array, the shader desc
+// references both via raw_data(array[:])
+void SokolOdinGenerator::gen_shader_array_embed(const GenInput& gen, const std::string& array_name, const std::string& file_name, size_t num_bytes, Slang::Enum slang) {
+    l("@(private=\"file\")\n{} := #load(\"{}\")\n", array_name, file_name);
+}
+
 void SokolOdinGenerator::gen_shader_array_end(const GenInput& gen) {
     l("\n}}\n");
 }
@@ -700,6 +716,10 @@ std::string SokolOdinGenerator::uniform_block_bind_slot_name(const UniformBlock&
     return fmt::format("UB_{}{}", mod_prefix, ub.name);
 }
 
+std::string SokolOdinGenerator::shader_hash_name(const std::string& prog_name, ShaderStage::Enum stage, Slang::Enum slang) {
+    return fmt::format("HASH_{}{}_{}_{}", mod_prefix, prog_name, ShaderStage::to_str(stage), Slang::to_str(slang));
+}
+
 std::string SokolOdinGenerator::vertex_attr_definition(const std::string& prog_name, const StageAttr& attr) {
     return fmt::format("{} :: {}", vertex_attr_name(prog_name, attr), attr.slot);
 }
@@ -716,6 +736,10 @@ std::string SokolOdinGenerator::uniform_block_bind_slot_definition(const Uniform
     return fmt::format("{} :: {}", uniform_block_bind_slot_name(ub), ub.sokol_slot);
 }
 
+std::string SokolOdinGenerator::shader_hash_definition(const std::string& prog_name, ShaderStage::Enum stage, Slang::Enum slang, uint64_t hash) {
+    return fmt::format("{} : u64 : 0x{:016x}", shader_hash_name(prog_name, stage, slang), hash);
+}
+
 std::string SokolOdinGenerator::storage_buffer_bind_slot_definition(const StorageBuffer& sbuf) {
     return fmt::format("{} :: {}", storage_buffer_bind_slot_name(sbuf), sbuf.sokol_slot);
 }
@@ -202,14 +202,12 @@ void SokolRustGenerator::gen_storage_buffer_decl(const GenInput& gen, const Type
 }
 
 void SokolRustGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramReflection& prog) {
-    l_open("pub fn {}_shader_desc(backend: sg::Backend) -> sg::ShaderDesc {{\n", prog.name);
-    l("let mut desc = sg::ShaderDesc::new();\n");
-    l("desc.label = c\"{}_shader\".as_ptr();\n", prog.name);
-    l_open("match backend {{\n");
     for (int i = 0; i < Slang::Num; i++) {
         Slang::Enum slang = Slang::from_index(i);
         if (gen.args.slang & Slang::bit(slang)) {
-            l_open("{} => {{\n", backend(slang));
+            l_open("pub const {}_SHADER_DESC_{}: sg::ShaderDesc = {{\n", pystring::upper(prog.name), pystring::upper(Slang::to_str(slang)));
+            l("let mut desc = sg::ShaderDesc::new();\n");
+            l("desc.label = c\"{}_shader\".as_ptr();\n", prog.name);
             for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
                 const ShaderStageArrayInfo& info = shader_stage_array_info(gen, prog, ShaderStage::from_index(stage_index), slang);
                 if (info.stage == ShaderStage::Invalid) {
@@ -375,12 +373,20 @@ void SokolRustGenerator::gen_shader_desc_func(const GenInput& gen, const Program
                     }
                 }
             }
-            l_close("}},\n"); // current switch branch
+            l("desc\n");
+            l_close("}};\n");
         }
     }
-    l("_ => {{}},\n");
-    l_close("}}\n"); // close switch statement
-    l("desc\n");
+    l_open("pub fn {}_shader_desc(backend: sg::Backend) -> sg::ShaderDesc {{\n", prog.name);
+    l_open("match backend {{\n");
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            l("{} => {}_SHADER_DESC_{},\n", backend(slang), pystring::upper(prog.name), pystring::upper(Slang::to_str(slang)));
+        }
+    }
+    l("_ => sg::ShaderDesc::new(),\n");
+    l_close("}}\n"); // close match expression
     l_close("}}\n"); // close function
 }
 
@@ -388,6 +394,10 @@ void SokolRustGenerator::gen_shader_array_start(const GenInput& gen, const std::
     l("pub const {}: [u8; {}] = [\n", array_name, num_bytes);
 }
 
+void SokolRustGenerator::gen_shader_array_embed(const GenInput& gen, const std::string& array_name, const std::string& file_name, size_t num_bytes, Slang::Enum slang) {
+    l("pub const {}: [u8; {}] = *include_bytes!(\"{}\");\n", array_name, num_bytes, file_name);
+}
+
 void SokolRustGenerator::gen_shader_array_end(const GenInput& gen) {
     l("\n];\n");
 }
@@ -577,6 +587,10 @@ std::string SokolRustGenerator::uniform_block_bind_slot_name(const UniformBlock&
     return pystring::upper(fmt::format("UB_{}", ub.name));
 }
 
+std::string SokolRustGenerator::shader_hash_name(const std::string& prog_name, ShaderStage::Enum stage, Slang::Enum slang) {
+    return pystring::upper(fmt::format("HASH_{}_{}_{}", prog_name, ShaderStage::to_str(stage), Slang::to_str(slang)));
+}
+
 std::string SokolRustGenerator::vertex_attr_definition(const std::string& prog_name, const StageAttr& attr) {
     return fmt::format("pub const {}: usize = {};", vertex_attr_name(prog_name, attr), attr.slot);
 }
@@ -593,6 +607,10 @@ std::string SokolRustGenerator::uniform_block_bind_slot_definition(const Uniform
     return fmt::format("pub const {}: usize = {};", uniform_block_bind_slot_name(ub), ub.sokol_slot);
 }
 
+std::string SokolRustGenerator::shader_hash_definition(const std::string& prog_name, ShaderStage::Enum stage, Slang::Enum slang, uint64_t hash) {
+    return fmt::format("pub const {}: u64 = 0x{:016x};", shader_hash_name(prog_name, stage, slang), hash);
+}
+
 std::string SokolRustGenerator::storage_buffer_bind_slot_definition(const StorageBuffer& sbuf) {
     return fmt::format("pub const {}: usize = {};", storage_buffer_bind_slot_name(sbuf), sbuf.sokol_slot);
 }
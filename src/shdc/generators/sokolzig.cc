@@ -200,14 +200,12 @@ void SokolZigGenerator::gen_storage_buffer_decl(const GenInput& gen, const Type&
 }
 
 void SokolZigGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramReflection& prog) {
-    l_open("pub fn {}ShaderDesc(backend: sg.Backend) sg.ShaderDesc {{\n", to_camel_case(prog.name));
-    l("var desc: sg.ShaderDesc = .{{}};\n");
-    l("desc.label = \"{}_shader\";\n", prog.name);
-    l_open("switch (backend) {{\n");
     for (int i = 0; i < Slang::Num; i++) {
         Slang::Enum slang = Slang::from_index(i);
         if (gen.args.slang & Slang::bit(slang)) {
-            l_open("{} => {{\n", backend(slang));
+            l_open("pub const {}_shader_desc_{}: sg.ShaderDesc = blk: {{\n", prog.name, Slang::to_str(slang));
+            l("var desc: sg.ShaderDesc = .{{}};\n");
+            l("desc.label = \"{}_shader\";\n", prog.name);
             for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
                 const ShaderStageArrayInfo& info = shader_stage_array_info(gen, prog, ShaderStage::from_index(stage_index), slang);
                 if (info.stage == ShaderStage::Invalid) {
@@ -373,12 +371,20 @@ void SokolZigGenerator::gen_shader_desc_func(const GenInput& gen, const ProgramR
                     }
                 }
             }
-            l_close("}},\n"); // current switch branch
+            l("break :blk desc;\n");
+            l_close("}};\n");
+        }
+    }
+    l_open("pub fn {}ShaderDesc(backend: sg.Backend) sg.ShaderDesc {{\n", to_camel_case(prog.name));
+    l_open("return switch (backend) {{\n");
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (gen.args.slang & Slang::bit(slang)) {
+            l("{} => {}_shader_desc_{},\n", backend(slang), prog.name, Slang::to_str(slang));
         }
     }
-    l("else => {{}},\n");
-    l_close("}}\n"); // close switch statement
-    l("return desc;\n");
+    l("else => .{{}},\n");
+    l_close("}};\n"); // close switch expression
     l_close("}}\n"); // close function
 }
 
@@ -386,6 +392,12 @@ void SokolZigGenerator::gen_shader_array_start(const GenInput& gen, const std::s
     l("const {} = [{}]u8 {{\n", array_name, num_bytes);
 }
 
+// @embedFile() returns a pointer to a sentinel-terminated array, dereference
+// into an array value so that the shader desc can take its address as usual
+void SokolZigGenerator::gen_shader_array_embed(const GenInput& gen, const std::string& array_name, const std::string& file_name, size_t num_bytes, Slang::Enum slang) {
+    l("const {} = @embedFile(\"{}\").*;\n", array_name, file_name);
+}
+
 void SokolZigGenerator::gen_shader_array_end(const GenInput& gen) {
     l("\n}};\n");
 }
@@ -575,6 +587,10 @@ std::string SokolZigGenerator::uniform_block_bind_slot_name(const UniformBlock&
     return fmt::format("UB_{}", ub.name);
 }
 
+std::string SokolZigGenerator::shader_hash_name(const std::string& prog_name, ShaderStage::Enum stage, Slang::Enum slang) {
+    return fmt::format("HASH_{}_{}_{}", prog_name, ShaderStage::to_str(stage), Slang::to_str(slang));
+}
+
 std::string SokolZigGenerator::vertex_attr_definition(const std::string& prog_name, const StageAttr& attr) {
     return fmt::format("pub const {} = {};", vertex_attr_name(prog_name, attr), attr.slot);
 }
@@ -591,6 +607,10 @@ std::string SokolZigGenerator::uniform_block_bind_slot_definition(const UniformB
     return fmt::format("pub const {} = {};", uniform_block_bind_slot_name(ub), ub.sokol_slot);
 }
 
+std::string SokolZigGenerator::shader_hash_definition(const std::string& prog_name, ShaderStage::Enum stage, Slang::Enum slang, uint64_t hash) {
+    return fmt::format("pub const {}: u64 = 0x{:016x};", shader_hash_name(prog_name, stage, slang), hash);
+}
+
 std::string SokolZigGenerator::storage_buffer_bind_slot_definition(const StorageBuffer& sb) {
     return fmt::format("pub const {} = {};", storage_buffer_bind_slot_name(sb), sb.sokol_slot);
 }
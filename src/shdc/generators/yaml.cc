@@ -19,7 +19,11 @@ ErrMsg YamlGenerator::generate(const GenInput& gen) {
         return err;
     }
     // next generate a YAML file with reflection info
-    content.clear();
+    const std::string file_path = fmt::format("{}_{}reflection.yaml", gen.args.output, mod_prefix);
+    err = open_output(gen, content, file_path, true);
+    if (err.valid()) {
+        return err;
+    }
     l_open("shaders:\n");
     for (int slang_idx = 0; slang_idx < Slang::Num; slang_idx++) {
         Slang::Enum slang = Slang::from_index(slang_idx);
@@ -48,6 +52,7 @@ ErrMsg YamlGenerator::generate(const GenInput& gen) {
                     l("path: {}\n", file_path);
                     l("is_binary: {}\n", info.has_bytecode);
                     l("entry_point: {}\n", refl.entry_point_by_slang(slang));
+                    l("hash: 0x{:016x}\n", shader_content_hash(gen, prog, info.stage, slang));
                     const char* d3d11_tgt = hlsl_target(slang, info.stage);
                     if (d3d11_tgt) {
                         l("d3d11_target: {}\n", d3d11_tgt);
@@ -113,15 +118,7 @@ ErrMsg YamlGenerator::generate(const GenInput& gen) {
     }
     l_close();
 
-    // write result into output file
-    const std::string file_path = fmt::format("{}_{}reflection.yaml", gen.args.output, mod_prefix);
-    FILE* f = fopen(file_path.c_str(), "w");
-    if (!f) {
-        return ErrMsg::error(gen.inp.base_path, 0, fmt::format("failed to open output file '{}'", file_path));
-    }
-    fwrite(content.c_str(), content.length(), 1, f);
-    fclose(f);
-    return ErrMsg();
+    return close_output(gen, content);
 }
 
 void YamlGenerator::gen_attr(const GenInput& gen, const StageAttr& attr, Slang::Enum slang) {
@@ -0,0 +1,105 @@
+/*
+    minimal HTTP/1.1 client (see http.h)
+*/
+#include "http.h"
+#include "fmt/format.h"
+#include "pystring.h"
+#include "socket.h"
+#include <stdlib.h>
+
+namespace shdc {
+
+HttpUrl HttpUrl::parse(const std::string& url) {
+    HttpUrl res;
+    if (!pystring::startswith(url, "http://")) {
+        return res;
+    }
+    std::string rest = url.substr(7);
+    const size_t slash = rest.find('/');
+    std::string host_port = rest.substr(0, slash);
+    if (slash != std::string::npos) {
+        res.path = pystring::rstrip(rest.substr(slash), "/");
+    }
+    const size_t colon = host_port.find(':');
+    if (colon != std::string::npos) {
+        res.port = atoi(host_port.substr(colon + 1).c_str());
+        host_port = host_port.substr(0, colon);
+    }
+    res.host = host_port;
+    res.valid = !res.host.empty() && (res.port > 0) && (res.port < 65536);
+    return res;
+}
+
+HttpResponse Http::request(const HttpUrl& url, const std::string& method, const std::string& path, const std::string& body, int timeout_ms) {
+    HttpResponse res;
+    std::unique_ptr<Socket> sock = Socket::connect(url.host, url.port, timeout_ms, res.error);
+    if (!sock) {
+        return res;
+    }
+    std::string req = fmt::format("{} {}{} HTTP/1.1\r\nHost: {}:{}\r\nConnection: close\r\n", method, url.path, path, url.host, url.port);
+    if ((method == "PUT") || (method == "POST")) {
+        req += fmt::format("Content-Type: application/octet-stream\r\nContent-Length: {}\r\n", body.length());
+    }
+    req += "\r\n";
+    req += body;
+    if (!sock->send_all(req)) {
+        res.error = "failed to send request (timeout?)";
+        return res;
+    }
+
+    // read the response until the connection is closed, or the body is complete
+    std::string resp;
+    size_t header_end = std::string::npos;
+    size_t content_length = std::string::npos;
+    char buf[16 * 1024];
+    while (true) {
+        if ((header_end != std::string::npos) && (content_length != std::string::npos) && (resp.length() >= (header_end + content_length))) {
+            break;
+        }
+        const int num = sock->recv(buf, sizeof(buf));
+        if (num < 0) {
+            res.error = "failed to receive response (timeout?)";
+            return res;
+        }
+        if (num == 0) {
+            break;
+        }
+        resp.append(buf, (size_t)num);
+        if (header_end == std::string::npos) {
+            const size_t pos = resp.find("\r\n\r\n");
+            if (pos != std::string::npos) {
+                header_end = pos + 4;
+                std::vector<std::string> lines;
+                pystring::split(resp.substr(0, pos), lines, "\r\n");
+                for (size_t i = 1; i < lines.size(); i++) {
+                    const size_t colon = lines[i].find(':');
+                    if ((colon != std::string::npos) && (pystring::lower(lines[i].substr(0, colon)) == "content-length")) {
+                        content_length = (size_t)atoll(lines[i].substr(colon + 1).c_str());
+                    }
+                }
+            }
+        }
+    }
+    sock.reset();
+    if (header_end == std::string::npos) {
+        res.error = "incomplete response header";
+        return res;
+    }
+    // status line: HTTP/1.1 200 OK
+    std::vector<std::string> status_tokens;
+    pystring::split(resp.substr(0, resp.find("\r\n")), status_tokens);
+    if ((status_tokens.size() < 2) || !pystring::startswith(status_tokens[0], "HTTP/")) {
+        res.error = "invalid response status line";
+        return res;
+    }
+    res.body = resp.substr(header_end);
+    if ((content_length != std::string::npos) && (res.body.length() != content_length)) {
+        res.body.clear();
+        res.error = "incomplete response body";
+        return res;
+    }
+    res.status = atoi(status_tokens[1].c_str());
+    return res;
+}
+
+} // namespace shdc
@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+
+namespace shdc {
+
+// minimal blocking HTTP/1.1 client for the remote artifact cache, only plain
+// http:// URLs are supported, each request uses its own connection
+struct HttpUrl {
+    bool valid = false;
+    std::string host;
+    int port = 80;
+    std::string path;       // path prefix without trailing slash, may be empty
+
+    static HttpUrl parse(const std::string& url);
+};
+
+struct HttpResponse {
+    int status = 0;         // 0 if the request failed (connection error or timeout)
+    std::string error;      // reason of a failed request
+    std::string body;
+
+    bool ok() const { return (status >= 200) && (status < 300); };
+};
+
+struct Http {
+    // the timeout applies to connecting and to each send and receive
+    static HttpResponse request(const HttpUrl& url, const std::string& method, const std::string& path, const std::string& body, int timeout_ms);
+};
+
+} // namespace shdc
@@ -33,20 +33,13 @@ const SamplerTypeTag* Input::find_sampler_type_tag(const std::string& smp_name)
     }
 }
 
-static std::string load_file_into_str(const std::string& path) {
-    FILE* f = fopen(path.c_str(), "rb");
-    if (!f) {
-        return std::string();
-    }
-    fseek(f, 0, SEEK_END);
-    const size_t file_size = ftell(f);
-    fseek(f, 0, SEEK_SET);
-    char* buf = (char*) malloc(file_size + 1);
-    fread((void*)buf, file_size, 1, f);
-    buf[file_size] = 0;
-    std::string str(buf);
-    free((void*)buf);
-    return str;
+bool Input::is_lint_ignored(const std::string& rule, int line_index) const {
+    for (const LintIgnoreTag& tag: lint_ignore_tags) {
+        if (tag.ignores(rule, line_index)) {
+            return true;
+        }
+    }
+    return false;
 }
 
 /* removes comments from string
@@ -130,6 +123,7 @@ static const std::string msl_options_tag = "@msl_options";
 static const std::string include_tag = "@include";
 static const std::string image_sample_type_tag = "@image_sample_type";
 static const std::string sampler_type_tag = "@sampler_type";
+static const std::string lint_ignore_tag = "@lint_ignore";
 
 static bool normalize_pragma_sokol(std::vector<std::string>& toks, std::string &line, int line_index, Input& inp) {
     // Returns true if it saw no errors, even if it did nothing.
@@ -535,6 +529,9 @@ static bool parse(Input& inp) {
                 }
                 inp.sampler_type_tags[tokens[1]] = SamplerTypeTag(tokens[1], SamplerType::from_str(tokens[2]), line_index);
                 add_line = false;
+            } else if (tokens[0] == lint_ignore_tag) {
+                inp.lint_ignore_tags.push_back(LintIgnoreTag(std::vector<std::string>(tokens.begin() + 1, tokens.end()), line_index, in_snippet));
+                add_line = false;
             } else if (tokens[0][0] == '@') {
                 inp.out_error = inp.error(line_index, fmt::format("unknown meta tag: {}", tokens[0]));
                 return false;
@@ -564,20 +561,21 @@ static bool validate_include_tag(const std::vector<std::string>& tokens, int lin
     return true;
 }
 
-static bool load_and_preprocess(const std::string& path, const std::vector<std::string>& include_dirs, Input& inp, int parent_line_index) {
+static bool load_and_preprocess(const std::string& path, const std::vector<std::string>& include_dirs, const Input::FileLoader& loader, Input& inp, int parent_line_index) {
     std::string path_used = path;
-    std::string str = load_file_into_str(path_used);
-    if (str.empty()) {
+    std::string str;
+    bool found = loader(path_used, str);
+    if (!found) {
         // check include directories
         for (const std::string& include_dir : include_dirs) {
             path_used = pystring::os::path::join(include_dir, path);
-            str = load_file_into_str(path_used);
-            if (!str.empty()) {
+            found = loader(path_used, str);
+            if (found) {
                 break;
             }
         }
         // failure?
-        if (str.empty()) {
+        if (!found) {
             if (inp.base_path == path) {
                 inp.out_error = ErrMsg::error(path, 0, fmt::format("Failed to open input file '{}'", path));
             } else {
@@ -622,7 +620,7 @@ static bool load_and_preprocess(const std::string& path, const std::vector<std::
                 }
                 // insert included file
                 const std::string& include_filename = tokens[1];
-                if (!load_and_preprocess(include_filename, include_dirs, inp, line_index)) {
+                if (!load_and_preprocess(include_filename, include_dirs, loader, inp, line_index)) {
                     return false;
                 }
             } else {
@@ -643,7 +641,14 @@ static bool load_and_preprocess(const std::string& path, const std::vector<std::
 /* load file and parse into an Input object,
    check valid and error fields in returned object
 */
-Input Input::load_and_parse(const std::string& path, const std::string& module_override) {
+Input Input::load_and_parse(const std::string& path, const std::string& module_override, Vfs& vfs) {
+    return load_and_parse(path, module_override, [&vfs](const std::string& file_path, std::string& out_content) {
+        return vfs.read(file_path, out_content);
+    });
+}
+
+/* same as above, but all files are loaded through a callback (e.g. from memory) */
+Input Input::load_and_parse(const std::string& path, const std::string& module_override, const FileLoader& loader) {
     std::string dir;
     std::string filename;
     pystring::os::path::split(dir, filename, path);
@@ -651,7 +656,7 @@ Input Input::load_and_parse(const std::string& path, const std::string& module_o
 
     Input inp;
     inp.base_path = path;
-    if (load_and_preprocess(path, include_dirs, inp, 0)) {
+    if (load_and_preprocess(path, include_dirs, loader, inp, 0)) {
         parse(inp);
     }
     if (!module_override.empty()) {
@@ -756,6 +761,10 @@ void Input::dump_debug(ErrMsg::Format err_fmt) const {
     for (const auto& [key, val]: sampler_type_tags) {
         fmt::print(stderr, "      {}: {} (line: {})\n", key, SamplerType::to_str(val.type), val.line_index);
     }
+    fmt::print(stderr, "    lint ignore tags:\n");
+    for (const LintIgnoreTag& tag: lint_ignore_tags) {
+        fmt::print(stderr, "      [{}] (line: {}, in_snippet: {})\n", pystring::join(", ", tag.rules), tag.line_index, tag.in_snippet);
+    }
     fmt::print("\n");
 }
 
@@ -2,10 +2,12 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <functional>
 #include "types/errmsg.h"
 #include "types/line.h"
 #include "types/snippet.h"
 #include "types/program.h"
+#include "vfs.h"
 
 namespace shdc {
 
@@ -27,14 +29,20 @@ struct Input {
     std::map<std::string, Program> programs;    // all @program definitions
     std::map<std::string, ImageSampleTypeTag> image_sample_type_tags;
     std::map<std::string, SamplerTypeTag> sampler_type_tags;
+    std::vector<LintIgnoreTag> lint_ignore_tags;    // @lint_ignore tags for --perf-lint
 
-    static Input load_and_parse(const std::string& path, const std::string& module_override);
+    // loads the content of the input file or an @include file, returns false if not found
+    typedef std::function<bool(const std::string& path, std::string& out_content)> FileLoader;
+
+    static Input load_and_parse(const std::string& path, const std::string& module_override, Vfs& vfs);
+    static Input load_and_parse(const std::string& path, const std::string& module_override, const FileLoader& loader);
     ErrMsg error(int line_index, const std::string& msg) const;
     ErrMsg warning(int line_index, const std::string& msg) const;
     void dump_debug(ErrMsg::Format err_fmt) const;
     // return nullptr if not found
     const ImageSampleTypeTag* find_image_sample_type_tag(const std::string& tex_name) const;
     const SamplerTypeTag* find_sampler_type_tag(const std::string& smp_name) const;
+    bool is_lint_ignored(const std::string& rule, int line_index) const;
 };
 
 } // namespace shdc
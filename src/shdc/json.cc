@@ -0,0 +1,317 @@
+/*
+    minimal JSON parser and writer for the --lsp mode
+*/
+#include "json.h"
+#include "util.h"
+#include "fmt/format.h"
+#include <stdlib.h>
+#include <math.h>
+
+namespace shdc {
+
+Json Json::boolean_value(bool b) {
+    Json res;
+    res.type = Bool;
+    res.boolean = b;
+    return res;
+}
+
+Json Json::number_value(double n) {
+    Json res;
+    res.type = Number;
+    res.number = n;
+    return res;
+}
+
+Json Json::string_value(const std::string& s) {
+    Json res;
+    res.type = String;
+    res.str = s;
+    return res;
+}
+
+Json Json::array() {
+    Json res;
+    res.type = Array;
+    return res;
+}
+
+Json Json::object() {
+    Json res;
+    res.type = Object;
+    return res;
+}
+
+int Json::as_int(int default_value) const {
+    return (type == Number) ? (int)number : default_value;
+}
+
+std::string Json::as_str(const std::string& default_value) const {
+    return (type == String) ? str : default_value;
+}
+
+const Json& Json::operator[](const std::string& key) const {
+    static const Json null_value;
+    if (type == Object) {
+        for (const auto& [name, val]: members) {
+            if (name == key) {
+                return val;
+            }
+        }
+    }
+    return null_value;
+}
+
+Json& Json::set(const std::string& key, const Json& val) {
+    type = Object;
+    for (auto& [name, item]: members) {
+        if (name == key) {
+            item = val;
+            return item;
+        }
+    }
+    members.push_back({ key, val });
+    return members.back().second;
+}
+
+Json& Json::push_back(const Json& val) {
+    type = Array;
+    items.push_back(val);
+    return items.back();
+}
+
+// recursive descent parser state
+struct JsonParser {
+    const std::string& src;
+    size_t pos = 0;
+
+    JsonParser(const std::string& s): src(s) { };
+    void skip_ws() {
+        while ((pos < src.length()) && ((src[pos] == ' ') || (src[pos] == '\t') || (src[pos] == '\n') || (src[pos] == '\r'))) {
+            pos++;
+        }
+    }
+    bool match(const char* lit) {
+        const std::string s(lit);
+        if (src.compare(pos, s.length(), s) == 0) {
+            pos += s.length();
+            return true;
+        }
+        return false;
+    }
+    bool parse_hex4(uint32_t& out_cp) {
+        if (pos + 4 > src.length()) {
+            return false;
+        }
+        out_cp = 0;
+        for (int i = 0; i < 4; i++) {
+            const char c = src[pos++];
+            out_cp <<= 4;
+            if ((c >= '0') && (c <= '9')) {
+                out_cp |= (uint32_t)(c - '0');
+            } else if ((c >= 'a') && (c <= 'f')) {
+                out_cp |= (uint32_t)(c - 'a' + 10);
+            } else if ((c >= 'A') && (c <= 'F')) {
+                out_cp |= (uint32_t)(c - 'A' + 10);
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+    static void append_utf8(std::string& str, uint32_t cp) {
+        if (cp < 0x80) {
+            str += (char)cp;
+        } else if (cp < 0x800) {
+            str += (char)(0xC0 | (cp >> 6));
+            str += (char)(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            str += (char)(0xE0 | (cp >> 12));
+            str += (char)(0x80 | ((cp >> 6) & 0x3F));
+            str += (char)(0x80 | (cp & 0x3F));
+        } else {
+            str += (char)(0xF0 | (cp >> 18));
+            str += (char)(0x80 | ((cp >> 12) & 0x3F));
+            str += (char)(0x80 | ((cp >> 6) & 0x3F));
+            str += (char)(0x80 | (cp & 0x3F));
+        }
+    }
+    bool parse_string(std::string& out_str) {
+        // opening quote has already been checked
+        pos++;
+        out_str.clear();
+        while (pos < src.length()) {
+            const char c = src[pos++];
+            if (c == '"') {
+                return true;
+            } else if (c != '\\') {
+                out_str += c;
+                continue;
+            }
+            if (pos >= src.length()) {
+                return false;
+            }
+            const char esc = src[pos++];
+            switch (esc) {
+                case '"':  out_str += '"'; break;
+                case '\\': out_str += '\\'; break;
+                case '/':  out_str += '/'; break;
+                case 'b':  out_str += '\b'; break;
+                case 'f':  out_str += '\f'; break;
+                case 'n':  out_str += '\n'; break;
+                case 'r':  out_str += '\r'; break;
+                case 't':  out_str += '\t'; break;
+                case 'u': {
+                    uint32_t cp = 0;
+                    if (!parse_hex4(cp)) {
+                        return false;
+                    }
+                    // combine UTF-16 surrogate pairs
+                    if ((cp >= 0xD800) && (cp < 0xDC00) && match("\\u")) {
+                        uint32_t lo = 0;
+                        if (!parse_hex4(lo) || (lo < 0xDC00) || (lo >= 0xE000)) {
+                            return false;
+                        }
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    }
+                    append_utf8(out_str, cp);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return false;
+    }
+    bool parse_value(Json& out_json, int depth) {
+        if (depth > 64) {
+            return false;
+        }
+        skip_ws();
+        if (pos >= src.length()) {
+            return false;
+        }
+        const char c = src[pos];
+        if (c == '{') {
+            pos++;
+            out_json = Json::object();
+            skip_ws();
+            if (match("}")) {
+                return true;
+            }
+            while (true) {
+                skip_ws();
+                std::string key;
+                if ((pos >= src.length()) || (src[pos] != '"') || !parse_string(key)) {
+                    return false;
+                }
+                skip_ws();
+                if (!match(":")) {
+                    return false;
+                }
+                Json val;
+                if (!parse_value(val, depth + 1)) {
+                    return false;
+                }
+                out_json.members.push_back({ key, std::move(val) });
+                skip_ws();
+                if (match("}")) {
+                    return true;
+                } else if (!match(",")) {
+                    return false;
+                }
+            }
+        } else if (c == '[') {
+            pos++;
+            out_json = Json::array();
+            skip_ws();
+            if (match("]")) {
+                return true;
+            }
+            while (true) {
+                Json val;
+                if (!parse_value(val, depth + 1)) {
+                    return false;
+                }
+                out_json.items.push_back(std::move(val));
+                skip_ws();
+                if (match("]")) {
+                    return true;
+                } else if (!match(",")) {
+                    return false;
+                }
+            }
+        } else if (c == '"') {
+            out_json = Json::string_value("");
+            return parse_string(out_json.str);
+        } else if (match("true")) {
+            out_json = Json::boolean_value(true);
+            return true;
+        } else if (match("false")) {
+            out_json = Json::boolean_value(false);
+            return true;
+        } else if (match("null")) {
+            out_json = Json();
+            return true;
+        } else {
+            const char* start = src.c_str() + pos;
+            char* end = nullptr;
+            const double n = strtod(start, &end);
+            if (end == start) {
+                return false;
+            }
+            pos += (size_t)(end - start);
+            out_json = Json::number_value(n);
+            return true;
+        }
+    }
+};
+
+bool Json::parse(const std::string& src, Json& out_json) {
+    JsonParser parser(src);
+    if (!parser.parse_value(out_json, 0)) {
+        out_json = Json();
+        return false;
+    }
+    parser.skip_ws();
+    return parser.pos == src.length();
+}
+
+std::string Json::dump() const {
+    switch (type) {
+        case Bool:
+            return boolean ? "true" : "false";
+        case Number:
+            if ((number == floor(number)) && (fabs(number) < 1e15)) {
+                return fmt::format("{}", (int64_t)number);
+            } else {
+                return fmt::format("{}", number);
+            }
+        case String:
+            return util::json_string(str);
+        case Array: {
+            std::string res = "[";
+            for (size_t i = 0; i < items.size(); i++) {
+                if (i > 0) {
+                    res += ",";
+                }
+                res += items[i].dump();
+            }
+            return res + "]";
+        }
+        case Object: {
+            std::string res = "{";
+            for (size_t i = 0; i < members.size(); i++) {
+                if (i > 0) {
+                    res += ",";
+                }
+                res += fmt::format("{}:{}", util::json_string(members[i].first), members[i].second.dump());
+            }
+            return res + "}";
+        }
+        default:
+            return "null";
+    }
+}
+
+} // namespace shdc
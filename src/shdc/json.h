@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace shdc {
+
+// a minimal JSON value for the JSON-RPC messages of the --lsp mode and the job
+// timings of distributed compilation, objects keep their items in insertion order
+struct Json {
+    enum Type {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object,
+    };
+    Type type = Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string str;
+    std::vector<Json> items;                             // array items
+    std::vector<std::pair<std::string, Json>> members;   // object items
+
+    static Json boolean_value(bool b);
+    static Json number_value(double n);
+    static Json string_value(const std::string& s);
+    static Json array();
+    static Json object();
+
+    // parse a JSON string, returns false on syntax errors
+    static bool parse(const std::string& src, Json& out_json);
+    std::string dump() const;
+
+    bool is_null() const { return type == Null; };
+    int as_int(int default_value = 0) const;
+    std::string as_str(const std::string& default_value = "") const;
+    // object member lookup, returns a null value if the member doesn't exist
+    const Json& operator[](const std::string& key) const;
+    // add an object member or array item, returns a reference to the added value
+    Json& set(const std::string& key, const Json& val);
+    Json& push_back(const Json& val);
+};
+
+} // namespace shdc
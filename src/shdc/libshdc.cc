@@ -0,0 +1,293 @@
+/*
+    libshdc C API implementation (see libshdc.h).
+*/
+#include "libshdc.h"
+#include "spirv.h"
+#include "pipeline.h"
+#include "generators/generate.h"
+#include "generators/generator.h"
+#include "fmt/format.h"
+#include "pystring.h"
+#include <deque>
+#include <set>
+
+using namespace shdc;
+using namespace shdc::refl;
+using namespace shdc::gen;
+
+struct shdc_context {
+    SpirvCache spirv_cache;
+    SpirvcrossCache spirvcross_cache;
+    // any intermediate files are only written to memory
+    std::shared_ptr<Vfs> vfs = std::make_shared<MemoryVfs>();
+
+    // everything below is the storage of the last result
+    Args args;
+    Input inp;
+    Pipeline pip;
+    std::vector<ErrMsg> errors;
+    std::map<std::string, std::string> captured_files;
+    std::deque<std::string> strings;
+    struct ProgramItems {
+        std::vector<shdc_shader> shaders;
+        std::vector<shdc_attr> attrs;
+        std::vector<shdc_uniform_block> uniform_blocks;
+        std::vector<shdc_view> views;
+        std::vector<shdc_sampler> samplers;
+        std::vector<shdc_texture_sampler> texture_samplers;
+    };
+    std::vector<ProgramItems> program_items;
+    std::vector<shdc_message> messages;
+    std::vector<shdc_program> programs;
+    std::vector<shdc_file> files;
+    shdc_result result;
+};
+
+static const char* store_string(shdc_context* ctx, const std::string& str) {
+    ctx->strings.push_back(str);
+    return ctx->strings.back().c_str();
+}
+
+static shdc_stage to_shdc_stage(ShaderStage::Enum stage) {
+    switch (stage) {
+        case ShaderStage::Fragment: return SHDC_STAGE_FRAGMENT;
+        case ShaderStage::Compute: return SHDC_STAGE_COMPUTE;
+        default: return SHDC_STAGE_VERTEX;
+    }
+}
+
+// setup Args from the compile desc, like Args::parse() does for the command line
+static bool setup_args(shdc_context* ctx, const shdc_desc* desc) {
+    Args& args = ctx->args;
+    args = Args();
+    args.vfs = ctx->vfs;
+    args.input = desc->path ? desc->path : "shader.glsl";
+    args.module = desc->module ? desc->module : "";
+    if (desc->defines) {
+        pystring::split(desc->defines, args.defines, ":");
+    }
+    std::vector<std::string> items;
+    pystring::split(desc->slang ? desc->slang : "", items, ":");
+    for (const std::string& item: items) {
+        bool item_valid = false;
+        for (int i = 0; i < Slang::Num; i++) {
+            if (item == Slang::to_str(Slang::from_index(i))) {
+                args.slang |= Slang::bit(Slang::from_index(i));
+                item_valid = true;
+                break;
+            }
+        }
+        if (!item_valid) {
+            ctx->errors.push_back(ErrMsg::error(fmt::format("unknown shader language '{}' (valid: {})", item, Slang::bits_to_str(0xFFFF, " "))));
+        }
+    }
+    if (args.slang == 0) {
+        ctx->errors.push_back(ErrMsg::error("no shader languages (shdc_desc.slang)"));
+    }
+    args.byte_code = desc->byte_code;
+    if (args.byte_code) {
+        for (int i = 0; i < Slang::Num; i++) {
+            const Slang::Enum slang = Slang::from_index(i);
+            if ((args.slang & Slang::bit(slang)) && Slang::is_msl(slang)) {
+                ctx->errors.push_back(ErrMsg::error("Metal bytecode compilation is not supported by libshdc"));
+                break;
+            }
+        }
+    }
+    if (desc->format) {
+        pystring::split(desc->format, items, ":");
+        for (const std::string& item: items) {
+            const Format::Enum format = Format::from_str(item);
+            if (format == Format::INVALID) {
+                ctx->errors.push_back(ErrMsg::error(fmt::format("unknown output format '{}'", item)));
+            } else {
+                args.output_formats.push_back(format);
+            }
+        }
+    }
+    // the first format writes the output path, all other formats get their own file with the
+    // extension of the output format, like one --output per format on the command line
+    args.output = desc->output ? desc->output : fmt::format("{}.h", args.input);
+    args.outputs.push_back(args.output);
+    std::string root, ext;
+    pystring::os::path::splitext(root, ext, args.output);
+    std::set<std::string> output_paths = { args.output };
+    for (size_t i = 1; i < args.output_formats.size(); i++) {
+        const Format::Enum format = args.output_formats[i];
+        const std::string path = fmt::format("{}{}", root, Format::extension(format));
+        if (!output_paths.insert(path).second) {
+            ctx->errors.push_back(ErrMsg::error(fmt::format("output format {} would overwrite the output of another format ({})", Format::to_str(format), path)));
+        }
+        args.outputs.push_back(path);
+    }
+    if (!args.output_formats.empty()) {
+        args.output_format = args.output_formats[0];
+    }
+    args.reflection = desc->reflection;
+    args.registry = desc->registry;
+    if (args.registry) {
+        for (Format::Enum format: args.output_formats) {
+            if ((format != Format::SOKOL) && (format != Format::SOKOL_IMPL)) {
+                ctx->errors.push_back(ErrMsg::error(fmt::format("registry is only supported for the sokol and sokol_impl output formats (not {})", Format::to_str(format))));
+            }
+        }
+    }
+    args.no_log_cmdline = true;
+    args.valid = ctx->errors.empty();
+    args.exit_code = args.valid ? 0 : 10;
+    return args.valid;
+}
+
+static void build_programs(shdc_context* ctx) {
+    const GenInput gen(ctx->args, ctx->inp, ctx->pip.spirvcross, ctx->pip.bytecode, ctx->pip.refl, ctx->pip.analysis);
+    ctx->program_items.resize(ctx->pip.refl.progs.size());
+    for (size_t prog_index = 0; prog_index < ctx->pip.refl.progs.size(); prog_index++) {
+        const ProgramReflection& prog = ctx->pip.refl.progs[prog_index];
+        shdc_context::ProgramItems& items = ctx->program_items[prog_index];
+        for (int i = 0; i < Slang::Num; i++) {
+            const Slang::Enum slang = Slang::from_index(i);
+            if (!(ctx->args.slang & Slang::bit(slang))) {
+                continue;
+            }
+            for (int stage_index = 0; stage_index < ShaderStage::Num; stage_index++) {
+                const ShaderStage::Enum stage = ShaderStage::from_index(stage_index);
+                const StageReflection& refl = prog.stage(stage);
+                if (refl.stage == ShaderStage::Invalid) {
+                    continue;
+                }
+                const SpirvcrossSource* src = ctx->pip.spirvcross[slang].find_source_by_snippet_index(refl.snippet_index);
+                const BytecodeBlob* blob = ctx->pip.bytecode[slang].find_blob_by_snippet_index(refl.snippet_index);
+                shdc_shader shd = {};
+                shd.slang = Slang::to_str(slang);
+                shd.stage = to_shdc_stage(stage);
+                shd.entry_point = store_string(ctx, refl.entry_point_by_slang(slang));
+                shd.source = src ? src->source_code.c_str() : "";
+                if (blob) {
+                    shd.bytecode = { blob->data.data(), blob->data.size() };
+                }
+                shd.hash = Generator::shader_content_hash(gen, prog, stage, slang);
+                items.shaders.push_back(shd);
+            }
+        }
+        if (prog.has_vs()) {
+            for (const StageAttr& attr: prog.vs().inputs) {
+                if (attr.slot >= 0) {
+                    items.attrs.push_back({ attr.slot, attr.name.c_str(), attr.sem_name.c_str(), attr.sem_index });
+                }
+            }
+        }
+        for (const UniformBlock& ub: prog.bindings.uniform_blocks) {
+            items.uniform_blocks.push_back({ to_shdc_stage(ub.stage), ub.sokol_slot, ub.struct_info.size, ub.name.c_str(), ub.inst_name.c_str() });
+        }
+        for (const Texture& tex: prog.bindings.textures) {
+            items.views.push_back({ SHDC_VIEW_TEXTURE, to_shdc_stage(tex.stage), tex.sokol_slot, tex.name.c_str() });
+        }
+        for (const StorageBuffer& sbuf: prog.bindings.storage_buffers) {
+            items.views.push_back({ SHDC_VIEW_STORAGE_BUFFER, to_shdc_stage(sbuf.stage), sbuf.sokol_slot, sbuf.name.c_str() });
+        }
+        for (const StorageImage& simg: prog.bindings.storage_images) {
+            items.views.push_back({ SHDC_VIEW_STORAGE_IMAGE, to_shdc_stage(simg.stage), simg.sokol_slot, simg.name.c_str() });
+        }
+        for (const Sampler& smp: prog.bindings.samplers) {
+            items.samplers.push_back({ to_shdc_stage(smp.stage), smp.sokol_slot, smp.name.c_str() });
+        }
+        for (const TextureSampler& tex_smp: prog.bindings.texture_samplers) {
+            items.texture_samplers.push_back({ to_shdc_stage(tex_smp.stage), tex_smp.sokol_slot, tex_smp.name.c_str(), tex_smp.texture_name.c_str(), tex_smp.sampler_name.c_str() });
+        }
+        shdc_program res_prog = {};
+        res_prog.name = prog.name.c_str();
+        res_prog.num_shaders = (int)items.shaders.size();
+        res_prog.shaders = items.shaders.data();
+        res_prog.num_attrs = (int)items.attrs.size();
+        res_prog.attrs = items.attrs.data();
+        res_prog.num_uniform_blocks = (int)items.uniform_blocks.size();
+        res_prog.uniform_blocks = items.uniform_blocks.data();
+        res_prog.num_views = (int)items.views.size();
+        res_prog.views = items.views.data();
+        res_prog.num_samplers = (int)items.samplers.size();
+        res_prog.samplers = items.samplers.data();
+        res_prog.num_texture_samplers = (int)items.texture_samplers.size();
+        res_prog.texture_samplers = items.texture_samplers.data();
+        ctx->programs.push_back(res_prog);
+    }
+}
+
+shdc_context* shdc_create_context(void) {
+    Spirv::initialize_spirv_tools();
+    return new shdc_context();
+}
+
+void shdc_destroy_context(shdc_context* ctx) {
+    if (ctx) {
+        delete ctx;
+        Spirv::finalize_spirv_tools();
+    }
+}
+
+const shdc_result* shdc_compile(shdc_context* ctx, const shdc_desc* desc) {
+    ctx->inp = Input();
+    ctx->pip = Pipeline();
+    ctx->errors.clear();
+    ctx->captured_files.clear();
+    ctx->strings.clear();
+    ctx->program_items.clear();
+    ctx->messages.clear();
+    ctx->programs.clear();
+    ctx->files.clear();
+    ctx->result = {};
+    Pipeline::trim_caches(ctx->spirvcross_cache, ctx->spirv_cache);
+
+    bool ok = setup_args(ctx, desc);
+    if (ok) {
+        // the main source comes from the desc, everything else from the file loader
+        const std::string main_path = ctx->args.input;
+        ctx->inp = Input::load_and_parse(main_path, ctx->args.module, [desc, &main_path](const std::string& path, std::string& out_content) {
+            if ((path == main_path) && desc->source) {
+                out_content = desc->source;
+                return true;
+            }
+            shdc_range content = {};
+            if (desc->loader.load && desc->loader.load(path.c_str(), &content, desc->loader.user_data)) {
+                out_content.assign((const char*)content.ptr, content.size);
+                return true;
+            }
+            return false;
+        });
+        ctx->pip = Pipeline::run(ctx->args, ctx->inp, ctx->spirvcross_cache, &ctx->spirv_cache);
+        ctx->errors = ctx->pip.messages;
+        ok = !ctx->pip.failed;
+    }
+    if (ok && !ctx->args.output_formats.empty()) {
+        const GenInput gen_input(ctx->args, ctx->inp, ctx->pip.spirvcross, ctx->pip.bytecode, ctx->pip.refl, ctx->pip.analysis);
+        std::vector<std::string> output_files;
+        const ErrMsg err = generate(gen_input, OutputSink::Memory, output_files, ctx->captured_files);
+        if (err.valid()) {
+            ctx->errors.push_back(err);
+            ok = false;
+        }
+        // each output format must have produced at least one file of its own
+        if (ok && (ctx->captured_files.size() < ctx->args.output_formats.size())) {
+            ctx->errors.push_back(ErrMsg::error(fmt::format("expected at least {} generated files, got {}", ctx->args.output_formats.size(), ctx->captured_files.size())));
+            ok = false;
+        }
+    }
+    if (ok) {
+        build_programs(ctx);
+        for (const auto& [path, content]: ctx->captured_files) {
+            ctx->files.push_back({ path.c_str(), { content.data(), content.size() } });
+        }
+    }
+    for (const ErrMsg& err: ctx->errors) {
+        ctx->messages.push_back({ err.type == ErrMsg::ERROR, err.file.c_str(), err.line_index + 1, err.msg.c_str() });
+    }
+
+    shdc_result& res = ctx->result;
+    res.ok = ok;
+    res.num_messages = (int)ctx->messages.size();
+    res.messages = ctx->messages.data();
+    res.num_programs = (int)ctx->programs.size();
+    res.programs = ctx->programs.data();
+    res.num_files = (int)ctx->files.size();
+    res.files = ctx->files.data();
+    return &res;
+}
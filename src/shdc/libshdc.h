@@ -0,0 +1,191 @@
+#pragma once
+/*
+    libshdc: the sokol-shdc compiler as a library with an in-memory C API.
+
+    Compiles a sokol-shdc annotated GLSL source string into the shader code
+    (and optionally bytecode) of all requested shader languages plus reflection
+    info, and can optionally run the sokol-shdc code generators. Nothing touches
+    the filesystem: @include files are resolved through a user-provided callback,
+    and generated code is returned in memory.
+
+    A context keeps compiler state alive between calls (glslang process
+    initialization plus the SPIRV compilation and SPIRV-Cross translation caches),
+    so recompiling a shader after an edit only recompiles the changed snippets.
+
+    Usage:
+
+        shdc_context* ctx = shdc_create_context();
+        ...
+        const shdc_result* res = shdc_compile(ctx, &(shdc_desc){
+            .path = "shaders/triangle.glsl",
+            .source = src,
+            .slang = "glsl430:hlsl5:metal_macos",
+            .loader = { .load = my_load_include, .user_data = my_vfs },
+        });
+        for (int i = 0; i < res->num_messages; i++) {
+            ...
+        }
+        if (res->ok) {
+            for (int i = 0; i < res->num_programs; i++) {
+                const shdc_program* prog = &res->programs[i];
+                ...
+            }
+        }
+        ...
+        shdc_destroy_context(ctx);
+
+    All pointers in a result are owned by the context and remain valid until
+    the next call to shdc_compile() or shdc_destroy_context(). A context must
+    only be used from one thread at a time.
+
+    Limitations:
+        - Metal bytecode compilation runs the Metal toolchain with temporary
+          files, and is rejected by shdc_compile()
+        - the --analyze, --heatmap, --budget and --dependency-file features of
+          the command line tool are not available
+*/
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct shdc_context shdc_context;
+
+typedef struct shdc_range {
+    const void* ptr;
+    size_t size;
+} shdc_range;
+
+typedef enum shdc_stage {
+    SHDC_STAGE_VERTEX,
+    SHDC_STAGE_FRAGMENT,
+    SHDC_STAGE_COMPUTE,
+} shdc_stage;
+
+typedef enum shdc_view_type {
+    SHDC_VIEW_TEXTURE,
+    SHDC_VIEW_STORAGE_BUFFER,
+    SHDC_VIEW_STORAGE_IMAGE,
+} shdc_view_type;
+
+/*
+    shdc_file_loader
+
+    Called for each file which isn't the main source (e.g. @include files),
+    first with the path as written in the @include statement, and then with
+    the path relative to the directory of the main source. Return false
+    if the file doesn't exist. The content must remain valid until the
+    callback is called again or shdc_compile() returns.
+*/
+typedef struct shdc_file_loader {
+    bool (*load)(const char* path, shdc_range* out_content, void* user_data);
+    void* user_data;
+} shdc_file_loader;
+
+typedef struct shdc_desc {
+    const char* path;           // virtual path of the main source, used in messages and to resolve @include
+    const char* source;         // main source code, if null it is loaded through the file loader
+    const char* slang;          // colon-separated shader languages, same as --slang (e.g. "glsl430:hlsl5")
+    const char* module;         // optional @module override
+    const char* defines;        // optional colon-separated preprocessor defines
+    bool byte_code;             // compile HLSL bytecode (only on Windows)
+    const char* format;         // optional colon-separated output formats for generated code (e.g. "sokol:sokol_zig")
+    const char* output;         // virtual output path of the first format (default: path + ".h"), other formats replace the extension (e.g. ".zig")
+    bool reflection;            // same as --reflection for generated code
+    bool registry;              // same as --registry for generated code
+    shdc_file_loader loader;
+} shdc_desc;
+
+typedef struct shdc_message {
+    bool error;                 // false for warnings
+    const char* file;
+    int line;                   // 1-based, 0 if unknown
+    const char* msg;
+} shdc_message;
+
+typedef struct shdc_shader {
+    const char* slang;          // e.g. "hlsl5"
+    shdc_stage stage;
+    const char* entry_point;
+    const char* source;         // translated shader source code
+    shdc_range bytecode;        // empty if no bytecode was compiled
+    uint64_t hash;              // same as the content hash in generated code
+} shdc_shader;
+
+typedef struct shdc_attr {
+    int slot;
+    const char* name;
+    const char* sem_name;       // HLSL semantic name
+    int sem_index;
+} shdc_attr;
+
+typedef struct shdc_uniform_block {
+    shdc_stage stage;
+    int slot;
+    int size;
+    const char* name;           // struct name
+    const char* inst_name;
+} shdc_uniform_block;
+
+typedef struct shdc_view {
+    shdc_view_type type;
+    shdc_stage stage;
+    int slot;
+    const char* name;
+} shdc_view;
+
+typedef struct shdc_sampler {
+    shdc_stage stage;
+    int slot;
+    const char* name;
+} shdc_sampler;
+
+typedef struct shdc_texture_sampler {
+    shdc_stage stage;
+    int slot;
+    const char* name;
+    const char* texture_name;
+    const char* sampler_name;
+} shdc_texture_sampler;
+
+typedef struct shdc_program {
+    const char* name;
+    int num_shaders;            // one per shader stage and shader language
+    const shdc_shader* shaders;
+    int num_attrs;              // vertex shader inputs
+    const shdc_attr* attrs;
+    int num_uniform_blocks;
+    const shdc_uniform_block* uniform_blocks;
+    int num_views;
+    const shdc_view* views;
+    int num_samplers;
+    const shdc_sampler* samplers;
+    int num_texture_samplers;
+    const shdc_texture_sampler* texture_samplers;
+} shdc_program;
+
+typedef struct shdc_file {
+    const char* path;
+    shdc_range content;
+} shdc_file;
+
+typedef struct shdc_result {
+    bool ok;
+    int num_messages;           // errors and warnings
+    const shdc_message* messages;
+    int num_programs;
+    const shdc_program* programs;
+    int num_files;              // generated files if shdc_desc.format was set
+    const shdc_file* files;
+} shdc_result;
+
+shdc_context* shdc_create_context(void);
+void shdc_destroy_context(shdc_context* ctx);
+const shdc_result* shdc_compile(shdc_context* ctx, const shdc_desc* desc);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,492 @@
+/*
+    Language server mode (--lsp), see lsp.h.
+*/
+#include "lsp.h"
+#include "json.h"
+#include "vfs.h"
+#include "input.h"
+#include "pipeline.h"
+#include "fmt/format.h"
+#include "pystring.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <filesystem>
+#if defined(_WIN32)
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+namespace shdc {
+
+using namespace refl;
+
+// JSON-RPC error codes and LSP constants
+static const int ErrorParse = -32700;
+static const int ErrorMethodNotFound = -32601;
+static const int SeverityError = 1;
+static const int SeverityWarning = 2;
+static const int TextDocumentSyncFull = 1;
+
+static std::string normalize_path(const std::string& path) {
+    std::error_code ec;
+    std::filesystem::path p = std::filesystem::absolute(path, ec);
+    if (ec) {
+        p = path;
+    }
+    return p.lexically_normal().generic_string();
+}
+
+// @include files are loaded through paths relative to the including file,
+// so paths must be normalized before looking up unsaved editor buffers
+class LspVfs: public OverlayVfs {
+public:
+    LspVfs(): OverlayVfs(Vfs::disk()) { };
+    virtual bool read(const std::string& path, std::string& out_content) {
+        return OverlayVfs::read(normalize_path(path), out_content);
+    }
+};
+
+static std::string uri_to_path(const std::string& uri) {
+    const std::string str = pystring::startswith(uri, "file://") ? uri.substr(7) : uri;
+    std::string path;
+    for (size_t i = 0; i < str.length(); i++) {
+        if ((str[i] == '%') && ((i + 2) < str.length())) {
+            path += (char)strtol(str.substr(i + 1, 2).c_str(), nullptr, 16);
+            i += 2;
+        } else {
+            path += str[i];
+        }
+    }
+    #if defined(_WIN32)
+    // file:///C:/dir/file.glsl => C:/dir/file.glsl
+    if ((path.length() > 2) && (path[0] == '/') && (path[2] == ':')) {
+        path = path.substr(1);
+    }
+    #endif
+    return normalize_path(path);
+}
+
+static std::string path_to_uri(const std::string& path) {
+    const std::string norm_path = normalize_path(path);
+    std::string uri = "file://";
+    if (!pystring::startswith(norm_path, "/")) {
+        // Windows drive letter
+        uri += "/";
+    }
+    for (const char c: norm_path) {
+        if (isalnum((unsigned char)c) || strchr("/-._~:", c)) {
+            uri += c;
+        } else {
+            uri += fmt::format("%{:02X}", (int)(unsigned char)c);
+        }
+    }
+    return uri;
+}
+
+// read one Content-Length framed JSON-RPC message from stdin, returns false at end of input
+static bool read_message(std::string& out_content) {
+    int content_length = -1;
+    std::string line;
+    while (true) {
+        const int c = fgetc(stdin);
+        if (c == EOF) {
+            return false;
+        }
+        if (c != '\n') {
+            line += (char)c;
+            continue;
+        }
+        line = pystring::strip(line);
+        if (line.empty()) {
+            if (content_length >= 0) {
+                break;
+            }
+            continue;
+        }
+        const size_t colon = line.find(':');
+        if ((colon != std::string::npos) && (pystring::lower(pystring::strip(line.substr(0, colon))) == "content-length")) {
+            content_length = atoi(line.substr(colon + 1).c_str());
+        }
+        line.clear();
+    }
+    out_content.resize(content_length);
+    if (content_length == 0) {
+        return true;
+    }
+    return fread((void*)out_content.data(), 1, content_length, stdin) == (size_t)content_length;
+}
+
+static void write_message(const Json& msg) {
+    const std::string content = msg.dump();
+    fmt::print(stdout, "Content-Length: {}\r\n\r\n", content.length());
+    fwrite(content.data(), 1, content.length(), stdout);
+    fflush(stdout);
+}
+
+static Json lsp_position(int line, int character) {
+    Json pos = Json::object();
+    pos.set("line", Json::number_value(line));
+    pos.set("character", Json::number_value(character));
+    return pos;
+}
+
+// a resource type as written in GLSL, e.g. 'mat4' or 'light_t[4]'
+static std::string type_str(const Type& type) {
+    std::string res = (type.type == Type::Struct) ? type.struct_typename : type.type_as_glsl();
+    if (type.is_array) {
+        res += fmt::format("[{}]", type.array_count);
+    }
+    return res;
+}
+
+// the identifier under a cursor position, character positions are treated as byte offsets
+static std::string word_at(const std::string& text, int line, int character) {
+    size_t line_start = 0;
+    for (int i = 0; i < line; i++) {
+        line_start = text.find('\n', line_start);
+        if (line_start == std::string::npos) {
+            return "";
+        }
+        line_start++;
+    }
+    size_t line_end = text.find('\n', line_start);
+    if (line_end == std::string::npos) {
+        line_end = text.length();
+    }
+    auto is_ident_char = [](char c) { return isalnum((unsigned char)c) || (c == '_'); };
+    size_t start = std::min(line_start + (size_t)std::max(character, 0), line_end);
+    size_t end = start;
+    while ((start > line_start) && is_ident_char(text[start - 1])) {
+        start--;
+    }
+    while ((end < line_end) && is_ident_char(text[end])) {
+        end++;
+    }
+    return text.substr(start, end - start);
+}
+
+// markdown hover paragraphs for all reflected resources with a name
+static std::vector<std::string> hover_items(const Reflection& refl, const std::string& word) {
+    std::vector<std::string> items;
+    auto add = [&items](const std::string& item) {
+        if (std::find(items.begin(), items.end(), item) == items.end()) {
+            items.push_back(item);
+        }
+    };
+    for (const ProgramReflection& prog: refl.progs) {
+        const Bindings& bindings = prog.bindings;
+        for (const UniformBlock& ub: bindings.uniform_blocks) {
+            if ((word == ub.name) || (word == ub.inst_name)) {
+                add(fmt::format("**uniform block** `{}` (program `{}`, {} stage)\n\nslot: {}, size: {} bytes",
+                    ub.name, prog.name, ShaderStage::to_str(ub.stage), ub.sokol_slot, ub.struct_info.size));
+            }
+            for (const Type& item: ub.struct_info.struct_items) {
+                if (word == item.name) {
+                    add(fmt::format("`{} {}` in uniform block `{}` (program `{}`)\n\noffset: {}, size: {} bytes",
+                        type_str(item), item.name, ub.name, prog.name, item.offset, item.size));
+                }
+            }
+        }
+        for (const StorageBuffer& sbuf: bindings.storage_buffers) {
+            if ((word == sbuf.name) || (word == sbuf.inst_name)) {
+                add(fmt::format("**storage buffer** `{}` (program `{}`, {} stage)\n\nview slot: {}, {}",
+                    sbuf.name, prog.name, ShaderStage::to_str(sbuf.stage), sbuf.sokol_slot, sbuf.readonly ? "readonly" : "read/write"));
+            }
+        }
+        for (const StorageImage& simg: bindings.storage_images) {
+            if (word == simg.name) {
+                add(fmt::format("**storage image** `{}` (program `{}`, {} stage)\n\nview slot: {}, type: {}",
+                    simg.name, prog.name, ShaderStage::to_str(simg.stage), simg.sokol_slot, ImageType::to_str(simg.type)));
+            }
+        }
+        for (const Texture& tex: bindings.textures) {
+            if (word == tex.name) {
+                add(fmt::format("**texture** `{}` (program `{}`, {} stage)\n\nview slot: {}, type: {}",
+                    tex.name, prog.name, ShaderStage::to_str(tex.stage), tex.sokol_slot, ImageType::to_str(tex.type)));
+            }
+        }
+        for (const Sampler& smp: bindings.samplers) {
+            if (word == smp.name) {
+                add(fmt::format("**sampler** `{}` (program `{}`, {} stage)\n\nsampler slot: {}",
+                    smp.name, prog.name, ShaderStage::to_str(smp.stage), smp.sokol_slot));
+            }
+        }
+        if (prog.has_vs()) {
+            for (const StageAttr& attr: prog.vs().inputs) {
+                if ((attr.slot >= 0) && (word == attr.name)) {
+                    add(fmt::format("**vertex attribute** `{} {}` (program `{}`)\n\nlocation: {}",
+                        type_str(attr.type_info), attr.name, prog.name, attr.slot));
+                }
+            }
+        }
+    }
+    return items;
+}
+
+// an open editor document
+struct Document {
+    std::string uri;
+    std::string path;                   // normalized file path
+    std::string text;                   // current editor content
+    std::vector<std::string> files;     // normalized paths of all source files of the last compilation (base file first)
+    std::set<std::string> published;    // uris which received diagnostics from this document
+    Reflection refl;                    // reflection info of the last successful compilation
+};
+
+struct LspServer {
+    Args args;
+    std::shared_ptr<LspVfs> vfs = std::make_shared<LspVfs>();
+    SpirvCache spirv_cache;
+    SpirvcrossCache spirvcross_cache;
+    std::map<std::string, Document> docs;   // uri => open document
+    bool shutdown_requested = false;
+
+    LspServer(const Args& a): args(a) { };
+    std::string uri_of(const std::string& path) const;
+    bool includes(const Document& doc, const std::string& path) const;
+    void compile(Document& doc);
+    void recompile_affected(const std::string& uri);
+    void publish(const std::string& uri, const Json& diagnostics);
+    Json hover(const Json& params) const;
+    void respond(const Json& id, const Json& result);
+    void respond_error(const Json& id, int code, const std::string& msg);
+    void handle(const Json& msg);
+};
+
+// use the client's uri for open documents, so that diagnostics are matched exactly
+std::string LspServer::uri_of(const std::string& path) const {
+    const std::string norm_path = normalize_path(path);
+    for (const auto& [uri, doc]: docs) {
+        if (doc.path == norm_path) {
+            return uri;
+        }
+    }
+    return path_to_uri(norm_path);
+}
+
+bool LspServer::includes(const Document& doc, const std::string& path) const {
+    return (doc.path != path) && (std::find(doc.files.begin(), doc.files.end(), path) != doc.files.end());
+}
+
+void LspServer::compile(Document& doc) {
+    Pipeline::trim_caches(spirvcross_cache, spirv_cache);
+    // nothing is written in language server mode, and bytecode compilation is
+    // skipped since it runs external compilers which are too slow for each keystroke
+    Args comp_args = args;
+    comp_args.vfs = vfs;
+    comp_args.input = doc.path;
+    comp_args.analysis_file.clear();
+    comp_args.heatmap_file.clear();
+    comp_args.save_intermediate_spirv = false;
+    comp_args.byte_code = false;
+    comp_args.debug_dump = false;
+
+    Input inp = Input::load_and_parse(doc.path, args.module, *vfs);
+    const Pipeline pip = Pipeline::run(comp_args, inp, spirvcross_cache, &spirv_cache);
+    if (!pip.failed) {
+        doc.refl = pip.refl;
+    }
+    doc.files.clear();
+    for (const std::string& filename: inp.filenames) {
+        doc.files.push_back(normalize_path(filename));
+    }
+
+    // diagnostics are grouped by source file, files without messages get an empty
+    // list so that the diagnostics of a previous compilation are cleared
+    std::map<std::string, Json> diagnostics;    // uri => diagnostics array
+    diagnostics[doc.uri] = Json::array();
+    for (const std::string& file: doc.files) {
+        diagnostics[uri_of(file)] = Json::array();
+    }
+    for (const ErrMsg& msg: pip.messages) {
+        const int line = std::max(msg.line_index, 0);
+        Json range = Json::object();
+        range.set("start", lsp_position(line, 0));
+        range.set("end", lsp_position(line + 1, 0));
+        Json diag = Json::object();
+        diag.set("range", range);
+        diag.set("severity", Json::number_value((msg.type == ErrMsg::WARNING) ? SeverityWarning : SeverityError));
+        diag.set("source", Json::string_value("sokol-shdc"));
+        diag.set("message", Json::string_value(msg.msg));
+        diagnostics[msg.file.empty() ? doc.uri : uri_of(msg.file)].push_back(diag);
+    }
+    for (const std::string& uri: doc.published) {
+        if (diagnostics.count(uri) == 0) {
+            diagnostics[uri] = Json::array();
+        }
+    }
+    doc.published.clear();
+    for (const auto& [uri, diags]: diagnostics) {
+        publish(uri, diags);
+        if (!diags.items.empty()) {
+            doc.published.insert(uri);
+        }
+    }
+}
+
+// after a document has changed, recompile all open documents which @include it,
+// a document which is only included by others isn't compiled on its own since
+// its snippets may depend on @blocks of the including file
+void LspServer::recompile_affected(const std::string& uri) {
+    const std::string path = uri_to_path(uri);
+    std::vector<std::string> targets;
+    for (const auto& [doc_uri, doc]: docs) {
+        if (includes(doc, path)) {
+            targets.push_back(doc_uri);
+        }
+    }
+    if (targets.empty() && (docs.count(uri) > 0)) {
+        targets.push_back(uri);
+    }
+    for (const std::string& target: targets) {
+        compile(docs[target]);
+    }
+}
+
+void LspServer::publish(const std::string& uri, const Json& diagnostics) {
+    Json params = Json::object();
+    params.set("uri", Json::string_value(uri));
+    params.set("diagnostics", diagnostics);
+    Json msg = Json::object();
+    msg.set("jsonrpc", Json::string_value("2.0"));
+    msg.set("method", Json::string_value("textDocument/publishDiagnostics"));
+    msg.set("params", params);
+    write_message(msg);
+}
+
+// hover info comes from the reflection of the document itself, or of the documents including it
+Json LspServer::hover(const Json& params) const {
+    const std::string uri = params["textDocument"]["uri"].as_str();
+    auto it = docs.find(uri);
+    if (it == docs.end()) {
+        return Json();
+    }
+    const Document& doc = it->second;
+    const std::string word = word_at(doc.text, params["position"]["line"].as_int(), params["position"]["character"].as_int());
+    if (word.empty()) {
+        return Json();
+    }
+    std::vector<std::string> items = hover_items(doc.refl, word);
+    for (const auto& [other_uri, other_doc]: docs) {
+        if (includes(other_doc, doc.path)) {
+            for (const std::string& item: hover_items(other_doc.refl, word)) {
+                if (std::find(items.begin(), items.end(), item) == items.end()) {
+                    items.push_back(item);
+                }
+            }
+        }
+    }
+    if (items.empty()) {
+        return Json();
+    }
+    Json contents = Json::object();
+    contents.set("kind", Json::string_value("markdown"));
+    contents.set("value", Json::string_value(pystring::join("\n\n---\n\n", items)));
+    Json result = Json::object();
+    result.set("contents", contents);
+    return result;
+}
+
+void LspServer::respond(const Json& id, const Json& result) {
+    Json msg = Json::object();
+    msg.set("jsonrpc", Json::string_value("2.0"));
+    msg.set("id", id);
+    msg.set("result", result);
+    write_message(msg);
+}
+
+void LspServer::respond_error(const Json& id, int code, const std::string& msg_str) {
+    Json error = Json::object();
+    error.set("code", Json::number_value(code));
+    error.set("message", Json::string_value(msg_str));
+    Json msg = Json::object();
+    msg.set("jsonrpc", Json::string_value("2.0"));
+    msg.set("id", id);
+    msg.set("error", error);
+    write_message(msg);
+}
+
+void LspServer::handle(const Json& msg) {
+    const std::string method = msg["method"].as_str();
+    const Json& id = msg["id"];
+    const Json& params = msg["params"];
+    if (method == "initialize") {
+        Json capabilities = Json::object();
+        capabilities.set("textDocumentSync", Json::number_value(TextDocumentSyncFull));
+        capabilities.set("hoverProvider", Json::boolean_value(true));
+        Json server_info = Json::object();
+        server_info.set("name", Json::string_value("sokol-shdc"));
+        Json result = Json::object();
+        result.set("capabilities", capabilities);
+        result.set("serverInfo", server_info);
+        respond(id, result);
+    } else if (method == "shutdown") {
+        shutdown_requested = true;
+        respond(id, Json());
+    } else if (method == "textDocument/didOpen") {
+        const Json& text_doc = params["textDocument"];
+        const std::string uri = text_doc["uri"].as_str();
+        Document& doc = docs[uri];
+        doc.uri = uri;
+        doc.path = uri_to_path(uri);
+        doc.text = text_doc["text"].as_str();
+        vfs->set_file(doc.path, doc.text);
+        recompile_affected(uri);
+    } else if (method == "textDocument/didChange") {
+        const std::string uri = params["textDocument"]["uri"].as_str();
+        const Json& changes = params["contentChanges"];
+        auto it = docs.find(uri);
+        if ((it != docs.end()) && !changes.items.empty()) {
+            // with full document sync, the last change contains the complete text
+            Document& doc = it->second;
+            doc.text = changes.items.back()["text"].as_str();
+            vfs->set_file(doc.path, doc.text);
+            recompile_affected(uri);
+        }
+    } else if (method == "textDocument/didClose") {
+        const std::string uri = params["textDocument"]["uri"].as_str();
+        auto it = docs.find(uri);
+        if (it != docs.end()) {
+            vfs->clear_file(it->second.path);
+            for (const std::string& published_uri: it->second.published) {
+                publish(published_uri, Json::array());
+            }
+            docs.erase(it);
+            // documents including the closed file now see the content on disk
+            recompile_affected(uri);
+        }
+    } else if (method == "textDocument/hover") {
+        respond(id, hover(params));
+    } else if (!id.is_null()) {
+        respond_error(id, ErrorMethodNotFound, fmt::format("unsupported method '{}'", method));
+    }
+    // all other notifications (initialized, didSave, $/...) are ignored
+}
+
+int Lsp::run(const Args& args) {
+    #if defined(_WIN32)
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+    #endif
+    LspServer server(args);
+    std::string content;
+    while (read_message(content)) {
+        Json msg;
+        if (!Json::parse(content, msg)) {
+            server.respond_error(Json(), ErrorParse, "failed to parse JSON-RPC message");
+            continue;
+        }
+        if (msg["method"].as_str() == "exit") {
+            break;
+        }
+        server.handle(msg);
+    }
+    return server.shutdown_requested ? 0 : 1;
+}
+
+} // namespace shdc
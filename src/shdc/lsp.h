@@ -0,0 +1,14 @@
+#pragma once
+#include "args.h"
+
+namespace shdc {
+
+// language server mode (--lsp): speaks the Language Server Protocol over stdin/stdout,
+// recompiles open documents on each change and publishes the compiler errors and
+// warnings as diagnostics, hovering over a resource shows its reflection info
+struct Lsp {
+    // returns when the client sends the exit notification or closes stdin, returns the exit code
+    static int run(const Args& args);
+};
+
+} // namespace shdc
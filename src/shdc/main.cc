@@ -4,11 +4,13 @@
 #include "spirv.h"
 #include "args.h"
 #include "input.h"
-#include "spirvcross.h"
-#include "bytecode.h"
-#include "reflection.h"
+#include "pipeline.h"
+#include "lsp.h"
+#include "worker.h"
 #include "util.h"
 #include "generators/generate.h"
+#include "fmt/format.h"
+#include <chrono>
 
 using namespace shdc;
 using namespace shdc::refl;
@@ -26,115 +28,63 @@ int main(int argc, const char** argv) {
         return args.exit_code;
     }
 
-    // load the source and parse tagged blocks
-    Input inp = Input::load_and_parse(args.input, args.module);
-    if (args.debug_dump) {
-        inp.dump_debug(args.error_format);
-    }
-    if (inp.out_error.valid()) {
-        inp.out_error.print(args.error_format);
-        return 10;
+    // language server mode, compiles documents from the editor until the client exits
+    if (args.lsp) {
+        const int exit_code = Lsp::run(args);
+        Spirv::finalize_spirv_tools();
+        return exit_code;
     }
 
-    // output source file dependencies
-    if (!args.dependency_file.empty()) {
-        const ErrMsg err = util::write_dep_file(args, inp);
-        if (err.valid()) {
-            err.print(args.error_format);
-            return 10;
-        }
+    // compile worker mode, runs the jobs of --workers coordinators until killed
+    if (args.worker) {
+        const int exit_code = Worker::run(args);
+        Spirv::finalize_spirv_tools();
+        return exit_code;
     }
 
-    // compile source snippets to SPIRV blobs (multiple compilations is necessary
-    // because of conditional compilation by target language)
-    std::array<Spirv,Slang::Num> spirv;
-    for (int i = 0; i < Slang::Num; i++) {
-        Slang::Enum slang = Slang::from_index(i);
-        if (args.slang & Slang::bit(slang)) {
-            spirv[i] = Spirv::compile_glsl_and_extract_bindings(inp, slang, args.defines);
-            if (args.debug_dump) {
-                spirv[i].dump_debug(inp, args.error_format);
-            }
-            if (!spirv[i].errors.empty()) {
-                bool has_errors = false;
-                for (const ErrMsg& err: spirv[i].errors) {
-                    if (err.type == ErrMsg::ERROR) {
-                        has_errors = true;
-                    }
-                    err.print(args.error_format);
-                }
-                if (has_errors) {
-                    return 10;
-                }
-            }
-            if (args.save_intermediate_spirv) {
-                if (!spirv[i].write_to_file(args, inp, slang)) {
-                    return 10;
-                }
-            }
-        }
+    // load the source and parse tagged blocks
+    Input inp = Input::load_and_parse(args.input, args.module, *args.vfs);
+    if (args.debug_dump) {
+        inp.dump_debug(args.error_format);
     }
 
-    // cross-translate SPIRV to shader dialects
-    std::array<Spirvcross,Slang::Num> spirvcross;
-    for (int i = 0; i < Slang::Num; i++) {
-        Slang::Enum slang = Slang::from_index(i);
-        if (args.slang & Slang::bit(slang)) {
-            spirvcross[i] = Spirvcross::translate(inp, spirv[i], slang);
-            if (args.debug_dump) {
-                spirvcross[i].dump_debug(args.error_format, slang);
-            }
-            if (spirvcross[i].error.valid()) {
-                spirvcross[i].error.print(args.error_format);
-                return 10;
-            }
-        }
+    // compile to SPIRV, cross-translate, compile bytecode, build reflection info
+    SpirvcrossCache spirvcross_cache;
+    const Pipeline pip = Pipeline::run(args, inp, spirvcross_cache);
+    for (const ErrMsg& msg: pip.messages) {
+        msg.print(args.error_format);
     }
-
-    // compile shader-byte code if requested (HLSL / Metal)
-    std::array<Bytecode, Slang::Num> bytecode;
-    for (int i = 0; i < Slang::Num; i++) {
-        Slang::Enum slang = Slang::from_index(i);
-        if (args.byte_code || Slang::is_spirv(slang)) {
-            if (args.slang & Slang::bit(slang)) {
-                bytecode[i] = Bytecode::compile(args, inp, spirvcross[i], slang);
-                if (args.debug_dump) {
-                    bytecode[i].dump_debug();
-                }
-                if (!bytecode[i].errors.empty()) {
-                    bool has_errors = false;
-                    for (const ErrMsg& err: bytecode[i].errors) {
-                        if (err.type == ErrMsg::ERROR) {
-                            has_errors = true;
-                        }
-                        err.print(args.error_format);
-                    }
-                    if (has_errors) {
-                        return 10;
-                    }
-                }
-            }
-        }
+    if (args.debug_dump && args.cache) {
+        args.cache->dump_debug();
     }
-
-    // build merged Reflection info
-    const Reflection refl = Reflection::build(args, inp, spirvcross);
-    if (refl.error.valid()) {
-        refl.error.print(args.error_format);
+    if (pip.failed) {
         return 10;
     }
-    if (args.debug_dump) {
-        refl.dump_debug(args.error_format);
-    }
 
     // generate output files
-    const GenInput gen_input(args, inp, spirvcross, bytecode, refl);
-    ErrMsg gen_error = generate(args.output_format, gen_input);
+    const GenInput gen_input(args, inp, pip.spirvcross, pip.bytecode, pip.refl, pip.analysis);
+    std::vector<std::string> output_files;
+    const auto gen_start = std::chrono::steady_clock::now();
+    ErrMsg gen_error = generate(gen_input, output_files);
+    if (args.debug_dump) {
+        // only the code generators, used by scripts/bench-array-encodings.py
+        const double gen_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - gen_start).count();
+        fmt::print(stderr, "sokol-shdc: code generation: {:.3f} ms\n", gen_ms);
+    }
     if (gen_error.valid()) {
         gen_error.print(args.error_format);
         return 10;
     }
 
+    // output source file dependencies of all generated files
+    if (!args.dependency_file.empty()) {
+        const ErrMsg err = util::write_dep_file(args, inp, output_files);
+        if (err.valid()) {
+            err.print(args.error_format);
+            return 10;
+        }
+    }
+
     // success
     Spirv::finalize_spirv_tools();
     return 0;
@@ -0,0 +1,318 @@
+/*
+    shader performance linter on optimized SPIRV (--perf-lint)
+*/
+#include <set>
+#include <map>
+#include <tuple>
+#include <algorithm>
+#include "perflint.h"
+#include "spvmodule.h"
+#include "util.h"
+#include "fmt/format.h"
+
+namespace shdc {
+
+static const std::string divergent_derivatives_rule = "divergent-derivatives";
+static const std::string dynamic_uniform_index_rule = "dynamic-uniform-index";
+static const std::string discard_rule = "discard";
+static const std::string int_div_mod_rule = "int-div-mod";
+static const std::string redundant_sample_rule = "redundant-sample";
+static const std::string vs_per_draw_constant_rule = "vs-per-draw-constant";
+
+bool PerfLint::is_valid_rule(const std::string& rule) {
+    return (rule == divergent_derivatives_rule) ||
+           (rule == dynamic_uniform_index_rule) ||
+           (rule == discard_rule) ||
+           (rule == int_div_mod_rule) ||
+           (rule == redundant_sample_rule) ||
+           (rule == vs_per_draw_constant_rule);
+}
+
+// the operand range [first, last) of a value instruction which holds ids (as opposed to literals)
+static std::pair<size_t,size_t> id_operand_range(const SpvInst& inst) {
+    switch (inst.op) {
+        case spv::OpCompositeExtract:
+            return { 2, 3 };
+        case spv::OpVectorShuffle:
+        case spv::OpCompositeInsert:
+            return { 2, 4 };
+        case spv::OpExtInst:
+            return { 4, inst.num_operands() };
+        default:
+            return { 2, inst.num_operands() };
+    }
+}
+
+static bool is_implicit_lod_sample(spv::Op op) {
+    return (op == spv::OpImageSampleImplicitLod) ||
+           (op == spv::OpImageSampleDrefImplicitLod) ||
+           (op == spv::OpImageSampleProjImplicitLod) ||
+           (op == spv::OpImageSampleProjDrefImplicitLod) ||
+           (op == spv::OpImageQueryLod);
+}
+
+static bool is_derivative(spv::Op op) {
+    return (op >= spv::OpDPdx) && (op <= spv::OpFwidthCoarse);
+}
+
+static bool is_texture_access(spv::Op op) {
+    return ((op >= spv::OpImageSampleImplicitLod) && (op <= spv::OpImageRead)) ||
+           ((op >= spv::OpImageSparseSampleImplicitLod) && (op <= spv::OpImageSparseDrefGather));
+}
+
+static bool is_alu(const SpvInst& inst, uint32_t glsl_std_450) {
+    const spv::Op op = inst.op;
+    return ((op >= spv::OpConvertFToU) && (op <= spv::OpBitcast)) ||
+           ((op >= spv::OpSNegate) && (op <= spv::OpBitCount)) ||
+           ((op == spv::OpExtInst) && (inst.operand(2) == glsl_std_450));
+}
+
+// a structured control flow construct which is currently open
+struct Construct {
+    uint32_t merge_id = 0;
+    bool is_loop = false;
+    bool divergent = false;
+};
+
+static void check_blob(const Input& inp, const SpirvBlob& blob, std::set<std::pair<std::string,int>>& reported, std::vector<ErrMsg>& out_warnings) {
+    const Snippet& snippet = inp.snippets[blob.snippet_index];
+    const SpvModule mod = SpvModule::parse(blob.bytecode);
+    if (!mod.valid) {
+        return;
+    }
+    const int fallback_line_index = util::first_snippet_line_index_skipping_include_blocks(inp, snippet);
+    int cur_line_index = fallback_line_index;
+    const auto warn = [&](const std::string& rule, const std::string& msg) {
+        if (reported.count({ rule, cur_line_index }) > 0) {
+            return;
+        }
+        reported.insert({ rule, cur_line_index });
+        if (!inp.is_lint_ignored(rule, cur_line_index)) {
+            out_warnings.push_back(inp.warning(cur_line_index, fmt::format("{} [{}]", msg, rule)));
+        }
+    };
+
+    // global declarations
+    const int first_func = mod.first_function();
+    std::map<uint32_t,int> type_map;    // type id => instruction index
+    std::set<uint32_t> constants;
+    std::set<uint32_t> uniform_ptrs;    // uniform block variables and access chains with constant indices
+    std::set<uint32_t> varying_ptrs;    // input, storage buffer and workgroup variables
+    uint32_t glsl_std_450 = 0;
+    bool writes_frag_depth = false;
+    for (int i = 0; i < first_func; i++) {
+        const SpvInst& inst = mod.insts[i];
+        if ((inst.op >= spv::OpTypeVoid) && (inst.op <= spv::OpTypeFunction)) {
+            type_map[inst.operand(0)] = i;
+        } else if ((inst.op >= spv::OpConstantTrue) && (inst.op <= spv::OpSpecConstantOp)) {
+            constants.insert(inst.operand(1));
+        } else if ((inst.op == spv::OpExtInstImport) && (inst.string_operand(1) == "GLSL.std.450")) {
+            glsl_std_450 = inst.operand(0);
+        } else if ((inst.op == spv::OpDecorate) && (inst.operand(1) == spv::DecorationBuiltIn) && (inst.operand(2) == spv::BuiltInFragDepth)) {
+            writes_frag_depth = true;
+        } else if (inst.op == spv::OpVariable) {
+            const uint32_t storage_class = inst.operand(2);
+            const auto ptr_it = type_map.find(inst.operand(0));
+            const uint32_t pointee = (ptr_it != type_map.end()) ? mod.insts[ptr_it->second].operand(2) : 0;
+            const bool is_buffer_block = mod.has_decoration(pointee, spv::DecorationBufferBlock);
+            if (((storage_class == spv::StorageClassUniform) && !is_buffer_block) || (storage_class == spv::StorageClassPushConstant)) {
+                uniform_ptrs.insert(inst.operand(1));
+            } else if ((storage_class == spv::StorageClassInput) ||
+                       (storage_class == spv::StorageClassStorageBuffer) ||
+                       (storage_class == spv::StorageClassWorkgroup) ||
+                       ((storage_class == spv::StorageClassUniform) && is_buffer_block))
+            {
+                varying_ptrs.insert(inst.operand(1));
+            }
+        }
+    }
+
+    // function bodies
+    std::set<uint32_t> divergent;       // values which may differ between invocations of a draw call
+    std::set<uint32_t> per_draw;        // values which only depend on constants and uniforms
+    std::set<std::vector<uint32_t>> block_samples;
+    std::vector<Construct> constructs;
+    Construct pending;
+    bool has_pending = false;
+    const auto all_in = [](const std::set<uint32_t>& set, const SpvInst& inst, std::pair<size_t,size_t> range) {
+        for (size_t oi = range.first; oi < range.second; oi++) {
+            if (set.count(inst.operand(oi)) == 0) {
+                return false;
+            }
+        }
+        return true;
+    };
+    const auto any_in = [](const std::set<uint32_t>& set, const SpvInst& inst, std::pair<size_t,size_t> range) {
+        for (size_t oi = range.first; oi < range.second; oi++) {
+            if (set.count(inst.operand(oi)) > 0) {
+                return true;
+            }
+        }
+        return false;
+    };
+    for (int i = first_func; i < (int)mod.insts.size(); i++) {
+        const SpvInst& inst = mod.insts[i];
+        const spv::Op op = inst.op;
+
+        // source line tracking
+        if (op == spv::OpLine) {
+            const int snippet_line_index = (int)inst.operand(1) - 1 - blob.linenr_offset;
+            if ((snippet_line_index >= 0) && (snippet_line_index < (int)snippet.lines.size())) {
+                cur_line_index = snippet.lines[snippet_line_index];
+            }
+            continue;
+        } else if (op == spv::OpNoLine) {
+            cur_line_index = fallback_line_index;
+            continue;
+        }
+
+        // structured control flow tracking
+        if (op == spv::OpLabel) {
+            while (!constructs.empty() && (constructs.back().merge_id == inst.operand(0))) {
+                constructs.pop_back();
+            }
+            block_samples.clear();
+            continue;
+        } else if ((op == spv::OpSelectionMerge) || (op == spv::OpLoopMerge)) {
+            pending = Construct();
+            pending.merge_id = inst.operand(0);
+            pending.is_loop = (op == spv::OpLoopMerge);
+            has_pending = true;
+            continue;
+        } else if ((op == spv::OpBranchConditional) || (op == spv::OpSwitch) || (op == spv::OpBranch)) {
+            const bool cond_divergent = (op != spv::OpBranch) && (divergent.count(inst.operand(0)) > 0);
+            if (has_pending) {
+                pending.divergent = cond_divergent;
+                constructs.push_back(pending);
+                has_pending = false;
+            } else if (cond_divergent) {
+                // a conditional break or continue, all following loop iterations are divergent
+                for (auto it = constructs.rbegin(); it != constructs.rend(); ++it) {
+                    if (it->is_loop) {
+                        it->divergent = true;
+                        break;
+                    }
+                }
+            }
+            continue;
+        }
+        const bool in_divergent_flow = std::any_of(constructs.begin(), constructs.end(), [](const Construct& c) { return c.divergent; });
+
+        // dataflow: divergent and per-draw-constant values
+        if (op == spv::OpStore) {
+            // function-local variables inherit the properties of stored values
+            if (divergent.count(inst.operand(1)) > 0) {
+                divergent.insert(inst.operand(0));
+            }
+        } else if (inst.has_type_and_result()) {
+            const uint32_t result_id = inst.operand(1);
+            const auto range = id_operand_range(inst);
+            if ((op == spv::OpAccessChain) || (op == spv::OpInBoundsAccessChain)) {
+                const uint32_t base = inst.operand(2);
+                const std::pair<size_t,size_t> indices = { 3, inst.num_operands() };
+                if (uniform_ptrs.count(base) > 0) {
+                    if (all_in(constants, inst, indices)) {
+                        uniform_ptrs.insert(result_id);
+                    } else {
+                        warn(dynamic_uniform_index_rule, "dynamic indexing into uniform data, this may be slow or fall back to a slower memory path on some GPUs");
+                    }
+                } else if (varying_ptrs.count(base) > 0) {
+                    varying_ptrs.insert(result_id);
+                }
+                if (any_in(divergent, inst, range)) {
+                    divergent.insert(result_id);
+                }
+            } else if (op == spv::OpLoad) {
+                const uint32_t ptr = inst.operand(2);
+                if (uniform_ptrs.count(ptr) > 0) {
+                    per_draw.insert(result_id);
+                } else if ((varying_ptrs.count(ptr) > 0) || (divergent.count(ptr) > 0)) {
+                    divergent.insert(result_id);
+                }
+            } else if (is_texture_access(op) || ((op >= spv::OpAtomicLoad) && (op <= spv::OpAtomicXor))) {
+                divergent.insert(result_id);
+            } else {
+                if (any_in(divergent, inst, range)) {
+                    divergent.insert(result_id);
+                }
+                if ((op != spv::OpFunctionCall) && (op != spv::OpPhi) && (range.second > range.first)) {
+                    bool is_per_draw = true;
+                    bool has_uniform_operand = false;
+                    for (size_t oi = range.first; oi < range.second; oi++) {
+                        const uint32_t id = inst.operand(oi);
+                        if (per_draw.count(id) > 0) {
+                            has_uniform_operand = true;
+                        } else if (constants.count(id) == 0) {
+                            is_per_draw = false;
+                            break;
+                        }
+                    }
+                    if (is_per_draw && has_uniform_operand) {
+                        per_draw.insert(result_id);
+                        if ((snippet.type == Snippet::VS) && is_alu(inst, glsl_std_450)) {
+                            warn(vs_per_draw_constant_rule, "vertex shader computation only depends on uniforms and is repeated for each vertex, consider computing it on the CPU");
+                        }
+                    }
+                }
+            }
+        }
+
+        // per-instruction rules
+        if (snippet.type == Snippet::FS) {
+            if ((is_implicit_lod_sample(op) || is_derivative(op)) && in_divergent_flow) {
+                warn(divergent_derivatives_rule, "derivatives or implicit-LOD texture sampling inside non-uniform control flow are undefined and may be slow, sample with an explicit LOD or gradient or move the operation out of the branch");
+            }
+            if ((op == spv::OpKill) || (op == spv::OpTerminateInvocation) || (op == spv::OpDemoteToHelperInvocationEXT)) {
+                if (!writes_frag_depth) {
+                    warn(discard_rule, "discard may disable early depth testing, consider alpha-to-coverage or blending if possible");
+                }
+            }
+            if ((op == spv::OpSDiv) || (op == spv::OpUDiv) || (op == spv::OpSMod) || (op == spv::OpSRem) || (op == spv::OpUMod)) {
+                if (constants.count(inst.operand(3)) == 0) {
+                    warn(int_div_mod_rule, "integer division or modulo by a non-constant value is expensive on many GPUs");
+                }
+            }
+        }
+        if ((op >= spv::OpImageSampleImplicitLod) && (op <= spv::OpImageDrefGather)) {
+            // same sample op with same image/sampler and coordinates in the same basic block
+            std::vector<uint32_t> key = { (uint32_t)op };
+            for (size_t oi = 2; oi < inst.num_operands(); oi++) {
+                uint32_t id = inst.operand(oi);
+                // look through OpSampledImage to the loaded texture and sampler variables
+                for (int di = first_func; (oi == 2) && (di < i); di++) {
+                    const SpvInst& def = mod.insts[di];
+                    if ((def.op == spv::OpSampledImage) && (def.operand(1) == id)) {
+                        key.push_back(def.operand(2));
+                        id = def.operand(3);
+                        break;
+                    }
+                }
+                key.push_back(id);
+            }
+            if (block_samples.count(key) > 0) {
+                warn(redundant_sample_rule, "redundant texture sample with identical texture, sampler and coordinates");
+            } else {
+                block_samples.insert(key);
+            }
+        }
+    }
+}
+
+PerfLint PerfLint::check(const Input& inp, const Spirv& debug_spirv) {
+    PerfLint res;
+    for (const LintIgnoreTag& tag: inp.lint_ignore_tags) {
+        for (const std::string& rule: tag.rules) {
+            if (!is_valid_rule(rule)) {
+                res.warnings.push_back(inp.warning(tag.line_index, fmt::format("unknown perf-lint rule '{}' in @lint_ignore", rule)));
+            }
+        }
+    }
+    // each rule is only reported once per source line, even if the line is part of several snippets
+    std::set<std::pair<std::string,int>> reported;
+    for (const SpirvBlob& blob: debug_spirv.blobs) {
+        check_blob(inp, blob, reported, res.warnings);
+    }
+    return res;
+}
+
+} // namespace shdc
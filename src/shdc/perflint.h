@@ -0,0 +1,18 @@
+#pragma once
+#include <vector>
+#include "input.h"
+#include "spirv.h"
+#include "types/errmsg.h"
+
+namespace shdc {
+
+// performance linter on optimized SPIRV (--perf-lint), the SPIRV must have been
+// compiled with line debug info to map warnings back to input source lines
+struct PerfLint {
+    std::vector<ErrMsg> warnings;
+
+    static PerfLint check(const Input& inp, const Spirv& debug_spirv);
+    static bool is_valid_rule(const std::string& rule);
+};
+
+} // namespace shdc
@@ -0,0 +1,209 @@
+/*
+    The shader compilation pipeline, without command line parsing and code generation.
+*/
+#include "pipeline.h"
+#include "varyings.h"
+#include "perflint.h"
+#include "budget.h"
+#include "worker.h"
+#include "fmt/format.h"
+#include <memory>
+
+namespace shdc {
+
+using namespace refl;
+
+// the compilation and translation caches are keyed by content, so they stay valid across
+// runs, but are cleared now and then to not grow unbounded during a long editing session
+static const size_t MaxCachedCompilations = 1024;
+static const size_t MaxCachedTranslations = 1024;
+
+// add a list of errors and warnings, returns true if it contained errors
+static bool add_messages(Pipeline& pip, const std::vector<ErrMsg>& errors) {
+    bool has_errors = false;
+    for (const ErrMsg& err: errors) {
+        if (err.type == ErrMsg::ERROR) {
+            has_errors = true;
+        }
+        pip.messages.push_back(err);
+    }
+    return has_errors;
+}
+
+static void fail(Pipeline& pip, const ErrMsg& err) {
+    pip.messages.push_back(err);
+    pip.failed = true;
+}
+
+Pipeline Pipeline::run(const Args& args, Input& inp, SpirvcrossCache& spirvcross_cache, SpirvCache* spirv_cache) {
+    Pipeline pip;
+    if (inp.out_error.valid()) {
+        fail(pip, inp.out_error);
+        return pip;
+    }
+
+    // optionally compile on --workers processes first, their results end up in the in-memory
+    // caches so that the steps below only compile what the workers couldn't (e.g. snippets
+    // with errors or warnings, or all of them if no worker is reachable)
+    std::unique_ptr<WorkerPool> pool;
+    SpirvCache worker_spirv_cache;
+    BytecodeCache bytecode_cache;
+    if (!args.workers.empty()) {
+        pool = std::make_unique<WorkerPool>(args);
+        if (!spirv_cache) {
+            spirv_cache = &worker_spirv_cache;
+        }
+        Spirv::compile_on_workers(args, inp, *pool, *spirv_cache);
+    }
+
+    // compile source snippets to SPIRV blobs (multiple compilations is necessary
+    // because of conditional compilation by target language)
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (args.slang & Slang::bit(slang)) {
+            pip.spirv[i] = Spirv::compile_glsl_and_extract_bindings(inp, slang, args.defines, false, spirv_cache, args.cache.get());
+            if (args.debug_dump) {
+                pip.spirv[i].dump_debug(inp, args.error_format);
+            }
+            if (add_messages(pip, pip.spirv[i].errors)) {
+                pip.failed = true;
+                return pip;
+            }
+            if (args.link_varyings) {
+                const ErrMsg err = Varyings::link(inp, pip.spirv[i]);
+                if (err.valid()) {
+                    fail(pip, err);
+                    return pip;
+                }
+            }
+            if (args.save_intermediate_spirv) {
+                if (!pip.spirv[i].write_to_file(args, inp, slang)) {
+                    pip.failed = true;
+                    return pip;
+                }
+            }
+        }
+    }
+
+    // the per-source-line heatmap and the perf linter need a separate compilation pass with
+    // line debug info, so that the SPIRV which is used for the actual outputs is not affected
+    Spirv debug_spirv;
+    if (!args.heatmap_file.empty() || args.perf_lint) {
+        debug_spirv = Spirv::compile_glsl_and_extract_bindings(inp, Slang::first_valid(args.slang), args.defines, true);
+    }
+
+    // optional performance linting, warnings don't stop compilation
+    if (args.perf_lint) {
+        const PerfLint lint = PerfLint::check(inp, debug_spirv);
+        add_messages(pip, lint.warnings);
+    }
+
+    // cross-translate SPIRV to shader dialects
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (args.slang & Slang::bit(slang)) {
+            pip.spirvcross[i] = Spirvcross::translate(inp, pip.spirv[i], slang, spirvcross_cache);
+            if (args.debug_dump) {
+                pip.spirvcross[i].dump_debug(args.error_format, slang);
+            }
+            if (pip.spirvcross[i].error.valid()) {
+                fail(pip, pip.spirvcross[i].error);
+                return pip;
+            }
+        }
+    }
+    if (args.debug_dump && spirv_cache) {
+        fmt::print(stderr, "SpirvCache: {} compilations, {} cache hits\n\n", spirv_cache->items.size(), spirv_cache->num_hits);
+    }
+    if (args.debug_dump) {
+        fmt::print(stderr, "SpirvcrossCache: {} translations, {} cache hits\n\n", spirvcross_cache.items.size(), spirvcross_cache.num_hits);
+    }
+
+    // compile shader-byte code if requested (HLSL / Metal)
+    if (pool) {
+        Bytecode::compile_on_workers(args, inp, pip.spirvcross, *pool, bytecode_cache);
+        if (args.debug_dump) {
+            pool->dump_debug();
+        }
+    }
+    for (int i = 0; i < Slang::Num; i++) {
+        Slang::Enum slang = Slang::from_index(i);
+        if (args.byte_code || Slang::is_spirv(slang)) {
+            if (args.slang & Slang::bit(slang)) {
+                pip.bytecode[i] = Bytecode::compile(args, inp, pip.spirvcross[i], slang, pool ? &bytecode_cache : nullptr);
+                if (args.debug_dump) {
+                    pip.bytecode[i].dump_debug();
+                }
+                if (add_messages(pip, pip.bytecode[i].errors)) {
+                    pip.failed = true;
+                    return pip;
+                }
+            }
+        }
+    }
+
+    // build merged Reflection info
+    pip.refl = Reflection::build(args, inp, pip.spirvcross);
+    if (pip.refl.error.valid()) {
+        fail(pip, pip.refl.error);
+        return pip;
+    }
+    if (args.debug_dump) {
+        pip.refl.dump_debug(args.error_format);
+    }
+
+    // optional static shader cost analysis (also needed for budget checks)
+    if (!args.analysis_file.empty() || !args.budget_file.empty()) {
+        pip.analysis = Analysis::build(args, inp, pip.spirv, pip.spirvcross, pip.bytecode);
+        if (args.debug_dump) {
+            pip.analysis.dump_debug(inp);
+        }
+    }
+    if (!args.analysis_file.empty()) {
+        const ErrMsg err = pip.analysis.write_json(args, inp);
+        if (err.valid()) {
+            fail(pip, err);
+            return pip;
+        }
+    }
+
+    // optional shader budget check, all exceeded limits are reported before failing
+    if (!args.budget_file.empty()) {
+        const Budget budget = Budget::load(args.budget_file, *args.vfs);
+        if (budget.error.valid()) {
+            fail(pip, budget.error);
+            return pip;
+        }
+        if (args.debug_dump) {
+            budget.dump_debug();
+        }
+        const std::vector<ErrMsg> errors = budget.check(inp, pip.refl, pip.analysis, args.slang);
+        if (!errors.empty()) {
+            add_messages(pip, errors);
+            pip.failed = true;
+            return pip;
+        }
+    }
+
+    // optional per-source-line heatmap
+    if (!args.heatmap_file.empty()) {
+        pip.analysis.build_heatmap(inp, debug_spirv);
+        const ErrMsg err = pip.analysis.write_heatmap(args, inp);
+        if (err.valid()) {
+            fail(pip, err);
+            return pip;
+        }
+    }
+    return pip;
+}
+
+void Pipeline::trim_caches(SpirvcrossCache& spirvcross_cache, SpirvCache& spirv_cache) {
+    if (spirv_cache.items.size() > MaxCachedCompilations) {
+        spirv_cache.items.clear();
+    }
+    if (spirvcross_cache.items.size() > MaxCachedTranslations) {
+        spirvcross_cache.items.clear();
+    }
+}
+
+} // namespace shdc
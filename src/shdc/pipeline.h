@@ -0,0 +1,35 @@
+#pragma once
+#include <array>
+#include <vector>
+#include "args.h"
+#include "input.h"
+#include "spirv.h"
+#include "spirvcross.h"
+#include "bytecode.h"
+#include "reflection.h"
+#include "analysis.h"
+#include "types/errmsg.h"
+#include "types/slang.h"
+
+namespace shdc {
+
+// the compilation pipeline from a parsed Input to the inputs of the code generators
+// (SPIRV => SPIRVCross => bytecode => reflection, plus the optional analysis steps),
+// shared by the sokol-shdc command line tool and libshdc
+struct Pipeline {
+    std::vector<ErrMsg> messages;   // all errors and warnings in the order they were reported
+    bool failed = false;
+    std::array<Spirv,Slang::Num> spirv;
+    std::array<Spirvcross,Slang::Num> spirvcross;
+    std::array<Bytecode,Slang::Num> bytecode;
+    refl::Reflection refl;
+    Analysis analysis;
+
+    // run all compilation steps, stops at the first step with errors, the
+    // spirvcross cache and the optional SPIRV cache can be reused across runs
+    static Pipeline run(const Args& args, Input& inp, SpirvcrossCache& spirvcross_cache, SpirvCache* spirv_cache = nullptr);
+    // clear caches which are reused across many runs once they grew too big
+    static void trim_caches(SpirvcrossCache& spirvcross_cache, SpirvCache& spirv_cache);
+};
+
+} // namespace shdc
@@ -0,0 +1,105 @@
+/*
+    job timing history and list scheduling (see schedule.h)
+*/
+#include "schedule.h"
+#include "json.h"
+#include "vfs.h"
+#include "fmt/format.h"
+#include <algorithm>
+#include <filesystem>
+
+namespace shdc {
+
+// bump when job names or timing semantics change
+static const int TimingsVersion = 1;
+// weight of a new measurement, smooths out outliers from busy machines
+static const double TimingsBlend = 0.5;
+
+JobTimings JobTimings::load(const std::string& cache_dir) {
+    JobTimings res;
+    if (cache_dir.empty()) {
+        return res;
+    }
+    res.path = fmt::format("{}/timings.json", cache_dir);
+    std::string src;
+    Json json;
+    if (!Vfs::disk()->read(res.path, src) || !Json::parse(src, json) || (json["version"].as_int() != TimingsVersion)) {
+        return res;
+    }
+    for (const auto& item: json["jobs"].members) {
+        if (item.second.type == Json::Number) {
+            res.items[item.first] = item.second.number / 1000.0;
+        }
+    }
+    return res;
+}
+
+bool JobTimings::find(const std::string& name, double& out_ms) const {
+    auto it = items.find(name);
+    if (it == items.end()) {
+        return false;
+    }
+    out_ms = it->second;
+    return true;
+}
+
+void JobTimings::update(const std::string& name, double ms) {
+    auto it = items.find(name);
+    if (it == items.end()) {
+        items[name] = ms;
+    } else {
+        it->second += (ms - it->second) * TimingsBlend;
+    }
+    dirty = true;
+}
+
+void JobTimings::save() {
+    if (path.empty() || !dirty) {
+        return;
+    }
+    // stored as integer microseconds
+    Json json = Json::object();
+    json.set("version", Json::number_value(TimingsVersion));
+    Json& jobs = json.set("jobs", Json::object());
+    for (const auto& item: items) {
+        jobs.set(item.first, Json::number_value((double)(int64_t)(item.second * 1000.0)));
+    }
+    const std::string str = json.dump();
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    if (Vfs::disk()->write(path, str.data(), str.length())) {
+        dirty = false;
+    }
+}
+
+std::vector<int> Schedule::lpt_order(const std::vector<double>& costs) {
+    std::vector<int> order;
+    for (int i = 0; i < (int)costs.size(); i++) {
+        order.push_back(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [&costs](int a, int b) {
+        return costs[a] > costs[b];
+    });
+    return order;
+}
+
+std::vector<int> Schedule::assign(const std::vector<double>& costs, const std::vector<int>& order, int num_workers) {
+    std::vector<int> res(costs.size(), 0);
+    std::vector<double> loads(num_workers, 0.0);
+    for (int job_index: order) {
+        const int worker = (int)(std::min_element(loads.begin(), loads.end()) - loads.begin());
+        loads[worker] += costs[job_index];
+        res[job_index] = worker;
+    }
+    return res;
+}
+
+double Schedule::makespan(const std::vector<double>& durations, const std::vector<int>& order, int num_workers) {
+    std::vector<double> loads(num_workers, 0.0);
+    for (int job_index: order) {
+        *std::min_element(loads.begin(), loads.end()) += durations[job_index];
+    }
+    return loads.empty() ? 0.0 : *std::max_element(loads.begin(), loads.end());
+}
+
+} // namespace shdc
@@ -0,0 +1,36 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+
+namespace shdc {
+
+// historical compile times of distributed compilation jobs, stored in [cache dir]/timings.json,
+// jobs are identified by name (shader language, input file, snippet and stage) rather than
+// by content, so that the history survives source code edits
+struct JobTimings {
+    std::string path;                       // empty if there's no cache directory
+    std::map<std::string, double> items;    // job name => milliseconds
+    bool dirty = false;
+
+    static JobTimings load(const std::string& cache_dir);
+    // returns false if there's no history for a job
+    bool find(const std::string& name, double& out_ms) const;
+    // blend a new measurement into the history
+    void update(const std::string& name, double ms);
+    // NOTE: parallel sokol-shdc processes may overwrite each others updates,
+    // which is fine since the timings are only a scheduling hint
+    void save();
+};
+
+// list scheduling helpers for the worker pool and the --trace output
+struct Schedule {
+    // job indices sorted by descending cost (longest-processing-time-first), ties in job order
+    static std::vector<int> lpt_order(const std::vector<double>& costs);
+    // greedy list scheduling, assigns jobs in order to the least loaded worker, returns the worker index per job
+    static std::vector<int> assign(const std::vector<double>& costs, const std::vector<int>& order, int num_workers);
+    // the time until the last worker finishes when running jobs with list scheduling in order
+    static double makespan(const std::vector<double>& durations, const std::vector<int>& order, int num_workers);
+};
+
+} // namespace shdc
@@ -0,0 +1,167 @@
+/*
+    binary serialization of compilation results (see serialize.h)
+*/
+#include "serialize.h"
+#include <string.h>
+
+namespace shdc {
+
+// bump when the serialized layout changes
+static const uint32_t SpirvBlobTag = 0x53505631;     // 'SPV1'
+static const uint32_t BytecodeBlobTag = 0x42435631;  // 'BCV1'
+
+void Serializer::u32(uint32_t val) {
+    for (int i = 0; i < 4; i++) {
+        data += (char)((val >> (i * 8)) & 0xFF);
+    }
+}
+
+void Serializer::i32(int val) {
+    u32((uint32_t)val);
+}
+
+void Serializer::str(const std::string& val) {
+    bytes(val.data(), val.length());
+}
+
+void Serializer::bytes(const void* ptr, size_t num_bytes) {
+    u32((uint32_t)num_bytes);
+    data.append((const char*)ptr, num_bytes);
+}
+
+void Serializer::bindslot(const BindSlot& val) {
+    i32(val.binding);
+    str(val.name);
+    i32((int)val.type);
+    i32(val.qualifiers);
+    i32(val.glsl.binding_n);
+    i32(val.hlsl.register_b_n);
+    i32(val.hlsl.register_t_n);
+    i32(val.hlsl.register_u_n);
+    i32(val.hlsl.register_s_n);
+    i32(val.msl.buffer_n);
+    i32(val.msl.texture_n);
+    i32(val.msl.sampler_n);
+    i32(val.wgsl.group0_binding_n);
+    i32(val.wgsl.group1_binding_n);
+    i32(val.spirv.set0_binding_n);
+    i32(val.spirv.set1_binding_n);
+}
+
+void Serializer::spirv_blob(const SpirvBlob& val) {
+    u32(SpirvBlobTag);
+    str(val.source);
+    i32(val.linenr_offset);
+    bytes(val.bytecode.data(), val.bytecode.size() * sizeof(uint32_t));
+    for (const BindSlot& slot: val.bindings.uniform_blocks) {
+        bindslot(slot);
+    }
+    for (const BindSlot& slot: val.bindings.views) {
+        bindslot(slot);
+    }
+    for (const BindSlot& slot: val.bindings.samplers) {
+        bindslot(slot);
+    }
+}
+
+void Serializer::bytecode_blob(const BytecodeBlob& val) {
+    u32(BytecodeBlobTag);
+    i32(val.valid ? 1 : 0);
+    bytes(val.data.data(), val.data.size());
+}
+
+uint32_t Deserializer::u32() {
+    if (!ok || ((pos + 4) > data.length())) {
+        ok = false;
+        return 0;
+    }
+    uint32_t val = 0;
+    for (int i = 0; i < 4; i++) {
+        val |= ((uint32_t)(uint8_t)data[pos++]) << (i * 8);
+    }
+    return val;
+}
+
+int Deserializer::i32() {
+    return (int)u32();
+}
+
+std::string Deserializer::str() {
+    return bytes();
+}
+
+std::string Deserializer::bytes() {
+    const uint32_t num_bytes = u32();
+    if (!ok || ((pos + num_bytes) > data.length())) {
+        ok = false;
+        return "";
+    }
+    std::string res = data.substr(pos, num_bytes);
+    pos += num_bytes;
+    return res;
+}
+
+BindSlot Deserializer::bindslot() {
+    BindSlot val;
+    val.binding = i32();
+    val.name = str();
+    val.type = (BindSlot::Type)i32();
+    val.qualifiers = i32();
+    val.glsl.binding_n = i32();
+    val.hlsl.register_b_n = i32();
+    val.hlsl.register_t_n = i32();
+    val.hlsl.register_u_n = i32();
+    val.hlsl.register_s_n = i32();
+    val.msl.buffer_n = i32();
+    val.msl.texture_n = i32();
+    val.msl.sampler_n = i32();
+    val.wgsl.group0_binding_n = i32();
+    val.wgsl.group1_binding_n = i32();
+    val.spirv.set0_binding_n = i32();
+    val.spirv.set1_binding_n = i32();
+    return val;
+}
+
+SpirvBlob Deserializer::spirv_blob(int snippet_index) {
+    SpirvBlob val(snippet_index);
+    if (u32() != SpirvBlobTag) {
+        ok = false;
+        return val;
+    }
+    val.source = str();
+    val.linenr_offset = i32();
+    const std::string bytecode = bytes();
+    if ((bytecode.length() % sizeof(uint32_t)) != 0) {
+        ok = false;
+        return val;
+    }
+    val.bytecode.resize(bytecode.length() / sizeof(uint32_t));
+    if (!bytecode.empty()) {
+        memcpy(val.bytecode.data(), bytecode.data(), bytecode.length());
+    }
+    for (BindSlot& slot: val.bindings.uniform_blocks) {
+        slot = bindslot();
+    }
+    for (BindSlot& slot: val.bindings.views) {
+        slot = bindslot();
+    }
+    for (BindSlot& slot: val.bindings.samplers) {
+        slot = bindslot();
+    }
+    return val;
+}
+
+BytecodeBlob Deserializer::bytecode_blob(int snippet_index) {
+    BytecodeBlob val;
+    val.snippet_index = snippet_index;
+    if (u32() != BytecodeBlobTag) {
+        ok = false;
+        return val;
+    }
+    val.valid = i32() != 0;
+    const std::string bytes_str = bytes();
+    val.data.assign(bytes_str.begin(), bytes_str.end());
+    return val;
+}
+
+} // namespace shdc
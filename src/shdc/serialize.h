@@ -0,0 +1,43 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "types/spirv_blob.h"
+#include "types/bytecode_blob.h"
+#include "types/bindslot.h"
+
+namespace shdc {
+
+// little-endian binary serialization of compilation results, used to store them
+// in the artifact cache, blobs are serialized without their snippet index
+struct Serializer {
+    std::string data;
+
+    void u32(uint32_t val);
+    void i32(int val);
+    void str(const std::string& val);
+    void bytes(const void* ptr, size_t num_bytes);
+    void bindslot(const BindSlot& val);
+    void spirv_blob(const SpirvBlob& val);
+    void bytecode_blob(const BytecodeBlob& val);
+};
+
+// reading past the end or a format mismatch sets ok to false
+struct Deserializer {
+    const std::string& data;
+    size_t pos = 0;
+    bool ok = true;
+
+    Deserializer(const std::string& d): data(d) { };
+    uint32_t u32();
+    int i32();
+    std::string str();
+    std::string bytes();
+    BindSlot bindslot();
+    SpirvBlob spirv_blob(int snippet_index);
+    BytecodeBlob bytecode_blob(int snippet_index);
+    // true if all data was read without errors
+    bool done() const { return ok && (pos == data.length()); };
+};
+
+} // namespace shdc
@@ -0,0 +1,209 @@
+/*
+    minimal blocking TCP sockets (see socket.h)
+*/
+#include "socket.h"
+#include "fmt/format.h"
+#include <string.h>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#if defined(_MSC_VER)
+#pragma comment(lib, "ws2_32.lib")
+#endif
+typedef SOCKET socket_t;
+static const socket_t InvalidSocket = INVALID_SOCKET;
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+typedef int socket_t;
+static const socket_t InvalidSocket = -1;
+#endif
+
+namespace shdc {
+
+static void init_sockets() {
+    #if defined(_WIN32)
+    static bool wsa_initialized = false;
+    if (!wsa_initialized) {
+        WSADATA wsa_data;
+        WSAStartup(MAKEWORD(2, 2), &wsa_data);
+        wsa_initialized = true;
+    }
+    #endif
+}
+
+static void close_socket(socket_t sock) {
+    #if defined(_WIN32)
+    closesocket(sock);
+    #else
+    close(sock);
+    #endif
+}
+
+static void set_nonblocking(socket_t sock, bool nonblocking) {
+    #if defined(_WIN32)
+    u_long mode = nonblocking ? 1 : 0;
+    ioctlsocket(sock, FIONBIO, &mode);
+    #else
+    const int flags = fcntl(sock, F_GETFL, 0);
+    fcntl(sock, F_SETFL, nonblocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK));
+    #endif
+}
+
+static void set_no_sigpipe(socket_t sock) {
+    #if defined(SO_NOSIGPIPE)
+    // don't get killed by SIGPIPE when the peer closes the connection early
+    const int no_sigpipe = 1;
+    setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, (const char*)&no_sigpipe, sizeof(no_sigpipe));
+    #else
+    (void)sock;
+    #endif
+}
+
+Socket::Socket(uintptr_t h): handle(h) { };
+
+Socket::~Socket() {
+    close_socket((socket_t)handle);
+}
+
+std::unique_ptr<Socket> Socket::connect(const std::string& host, int port, int timeout_ms, std::string& out_error) {
+    init_sockets();
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* addrs = nullptr;
+    if (0 != getaddrinfo(host.c_str(), fmt::format("{}", port).c_str(), &hints, &addrs)) {
+        out_error = fmt::format("failed to resolve host '{}'", host);
+        return nullptr;
+    }
+    socket_t sock = InvalidSocket;
+    out_error = fmt::format("failed to connect to {}:{}", host, port);
+    for (struct addrinfo* addr = addrs; addr; addr = addr->ai_next) {
+        sock = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+        if (sock == InvalidSocket) {
+            continue;
+        }
+        set_nonblocking(sock, true);
+        bool connected = (0 == ::connect(sock, addr->ai_addr, (int)addr->ai_addrlen));
+        if (!connected) {
+            fd_set write_fds;
+            FD_ZERO(&write_fds);
+            FD_SET(sock, &write_fds);
+            struct timeval tv;
+            tv.tv_sec = timeout_ms / 1000;
+            tv.tv_usec = (timeout_ms % 1000) * 1000;
+            if (select((int)sock + 1, nullptr, &write_fds, nullptr, &tv) > 0) {
+                int so_error = 0;
+                socklen_t len = sizeof(so_error);
+                getsockopt(sock, SOL_SOCKET, SO_ERROR, (char*)&so_error, &len);
+                connected = (so_error == 0);
+            } else {
+                out_error = fmt::format("timeout connecting to {}:{}", host, port);
+            }
+        }
+        if (connected) {
+            set_nonblocking(sock, false);
+            break;
+        }
+        close_socket(sock);
+        sock = InvalidSocket;
+    }
+    freeaddrinfo(addrs);
+    if (sock == InvalidSocket) {
+        return nullptr;
+    }
+    out_error.clear();
+    std::unique_ptr<Socket> res(new Socket((uintptr_t)sock));
+    set_no_sigpipe(sock);
+    res->set_timeout(timeout_ms);
+    return res;
+}
+
+std::unique_ptr<Socket> Socket::listen(int port, std::string& out_error) {
+    init_sockets();
+    socket_t sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock == InvalidSocket) {
+        out_error = "failed to create socket";
+        return nullptr;
+    }
+    // allow restarting a worker right away on the same port
+    const int reuse = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)port);
+    if ((0 != bind(sock, (const struct sockaddr*)&addr, sizeof(addr))) || (0 != ::listen(sock, 16))) {
+        close_socket(sock);
+        out_error = fmt::format("failed to listen on port {}", port);
+        return nullptr;
+    }
+    return std::unique_ptr<Socket>(new Socket((uintptr_t)sock));
+}
+
+std::unique_ptr<Socket> Socket::accept() {
+    socket_t sock = ::accept((socket_t)handle, nullptr, nullptr);
+    if (sock == InvalidSocket) {
+        return nullptr;
+    }
+    set_no_sigpipe(sock);
+    return std::unique_ptr<Socket>(new Socket((uintptr_t)sock));
+}
+
+void Socket::set_timeout(int timeout_ms) {
+    #if defined(_WIN32)
+    DWORD tv = (DWORD)timeout_ms;
+    #else
+    struct timeval tv;
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    #endif
+    setsockopt((socket_t)handle, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof(tv));
+    setsockopt((socket_t)handle, SOL_SOCKET, SO_SNDTIMEO, (const char*)&tv, sizeof(tv));
+}
+
+bool Socket::send_all(const std::string& data) {
+    #if defined(MSG_NOSIGNAL)
+    const int flags = MSG_NOSIGNAL;
+    #else
+    const int flags = 0;
+    #endif
+    size_t pos = 0;
+    while (pos < data.length()) {
+        const int num = (int)::send((socket_t)handle, data.data() + pos, (int)(data.length() - pos), flags);
+        if (num <= 0) {
+            return false;
+        }
+        pos += (size_t)num;
+    }
+    return true;
+}
+
+int Socket::recv(void* buf, int num_bytes) {
+    const int num = (int)::recv((socket_t)handle, (char*)buf, num_bytes, 0);
+    return (num < 0) ? -1 : num;
+}
+
+bool Socket::recv_all(void* buf, size_t num_bytes) {
+    size_t pos = 0;
+    while (pos < num_bytes) {
+        const int num = recv((uint8_t*)buf + pos, (int)(num_bytes - pos));
+        if (num <= 0) {
+            return false;
+        }
+        pos += (size_t)num;
+    }
+    return true;
+}
+
+} // namespace shdc
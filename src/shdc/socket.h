@@ -0,0 +1,30 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <memory>
+
+namespace shdc {
+
+// minimal blocking TCP socket shared by the HTTP client and the --worker protocol,
+// all functions fail on errors and timeouts instead of blocking forever
+class Socket {
+public:
+    ~Socket();
+    // connect with a timeout, which is also used for sending and receiving
+    static std::unique_ptr<Socket> connect(const std::string& host, int port, int timeout_ms, std::string& out_error);
+    // listen for connections on all network interfaces
+    static std::unique_ptr<Socket> listen(int port, std::string& out_error);
+    // wait for the next connection on a listening socket, nullptr on error
+    std::unique_ptr<Socket> accept();
+    void set_timeout(int timeout_ms);
+    bool send_all(const std::string& data);
+    // returns number of received bytes, 0 if the peer closed the connection, -1 on error or timeout
+    int recv(void* buf, int num_bytes);
+    // receive exactly num_bytes
+    bool recv_all(void* buf, size_t num_bytes);
+private:
+    Socket(uintptr_t handle);
+    uintptr_t handle;
+};
+
+} // namespace shdc
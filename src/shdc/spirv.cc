@@ -12,6 +12,9 @@
 #include "spirv-tools/libspirv.hpp"
 #include "spirv-tools/optimizer.hpp"
 #include "util.h"
+#include "cache.h"
+#include "serialize.h"
+#include <set>
 
 namespace shdc {
 
@@ -115,7 +118,7 @@ static void spirv_optimize(Slang::Enum slang, std::vector<uint32_t>& spirv) {
 }
 
 // compile a shader to SPIRV
-static bool compile(Input& inp, EShLanguage stage, Slang::Enum slang, const MergedSource& source, int snippet_index, Spirv& out_spirv) {
+static bool compile(Input& inp, EShLanguage stage, Slang::Enum slang, const MergedSource& source, int snippet_index, bool debug_info, Spirv& out_spirv) {
     const char* sources[1] = { source.src.c_str() };
     const int sourcesLen[1] = { (int) source.src.length() };
     const char* sourcesNames[1] = { inp.base_path.c_str() };
@@ -204,7 +207,8 @@ static bool compile(Input& inp, EShLanguage stage, Slang::Enum slang, const Merg
     spv::SpvBuildLogger spv_logger;
     glslang::SpvOptions spv_options;
     // disable the optimizer passes, we'll run our own after the translation
-    spv_options.generateDebugInfo = false;
+    // NOTE: line debug info is only generated for the separate --heatmap compilation pass
+    spv_options.generateDebugInfo = debug_info;
     spv_options.stripDebugInfo = false; // NOTE: don't set this to true as the info is needed for reflection!
     spv_options.disableOptimizer = true;
     spv_options.optimizeSize = true;
@@ -213,6 +217,7 @@ static bool compile(Input& inp, EShLanguage stage, Slang::Enum slang, const Merg
     spv_options.emitNonSemanticShaderDebugInfo = false;
     spv_options.emitNonSemanticShaderDebugSource = false;
     spirv_blob.source = source.src;
+    spirv_blob.linenr_offset = linenr_offset;
     glslang::GlslangToSpv(*im, spirv_blob.bytecode, &spv_logger, &spv_options);
     std::string spirv_log = spv_logger.getAllMessages();
     if (!spirv_log.empty()) {
@@ -228,8 +233,70 @@ static bool compile(Input& inp, EShLanguage stage, Slang::Enum slang, const Merg
     return true;
 }
 
+// key of the in-memory SPIRV cache, also the input of the artifact cache key
+static std::string spirv_cache_key(EShLanguage stage, Slang::Enum slang, bool debug_info, const std::string& src) {
+    return fmt::format("{}:{}:{}:{}", (int)stage, (int)slang, debug_info ? 1 : 0, src);
+}
+
+static EShLanguage snippet_stage(int snippet_type) {
+    switch (snippet_type) {
+        case Snippet::VS: return EShLangVertex;
+        case Snippet::FS: return EShLangFragment;
+        default: return EShLangCompute;
+    }
+}
+
+// compile a shader to SPIRV through the optional in-memory SPIRV cache and the optional
+// persistent artifact cache (not for debug info compilations since those contain the file path)
+static bool cached_compile(Input& inp, EShLanguage stage, Slang::Enum slang, const MergedSource& source, int snippet_index, bool debug_info, SpirvCache* cache, ArtifactCache* store, Spirv& out_spirv) {
+    if (debug_info) {
+        store = nullptr;
+    }
+    if (!cache && !store) {
+        return compile(inp, stage, slang, source, snippet_index, debug_info, out_spirv);
+    }
+    const std::string key = spirv_cache_key(stage, slang, debug_info, source.src);
+    if (cache) {
+        auto it = cache->items.find(key);
+        if (it != cache->items.end()) {
+            cache->num_hits++;
+            out_spirv.blobs.push_back(it->second);
+            out_spirv.blobs.back().snippet_index = snippet_index;
+            return true;
+        }
+    }
+    const std::string store_key = store ? ArtifactCache::key("spirv", key) : "";
+    std::string data;
+    if (store && store->get(store_key, data)) {
+        Deserializer reader(data);
+        SpirvBlob blob = reader.spirv_blob(snippet_index);
+        if (reader.done()) {
+            if (cache) {
+                cache->items.emplace(key, blob);
+            }
+            out_spirv.blobs.push_back(std::move(blob));
+            return true;
+        }
+    }
+    const size_t num_errors = out_spirv.errors.size();
+    if (!compile(inp, stage, slang, source, snippet_index, debug_info, out_spirv)) {
+        return false;
+    }
+    if (out_spirv.errors.size() == num_errors) {
+        if (cache) {
+            cache->items.emplace(key, out_spirv.blobs.back());
+        }
+        if (store) {
+            Serializer writer;
+            writer.spirv_blob(out_spirv.blobs.back());
+            store->put(store_key, writer.data);
+        }
+    }
+    return true;
+}
+
 // compile all shader-snippets into SPIRV bytecode
-Spirv Spirv::compile_glsl_and_extract_bindings(Input& inp, Slang::Enum slang, const std::vector<std::string>& defines) {
+Spirv Spirv::compile_glsl_and_extract_bindings(Input& inp, Slang::Enum slang, const std::vector<std::string>& defines, bool debug_info, SpirvCache* cache, ArtifactCache* store) {
     Spirv out_spirv;
 
     // compile shader-snippets
@@ -239,17 +306,17 @@ Spirv Spirv::compile_glsl_and_extract_bindings(Input& inp, Slang::Enum slang, co
         // NOTE: if compilation fails, out_spirv contains error list
         switch (snippet.type) {
             case Snippet::VS:
-                if (!compile(inp, EShLangVertex, slang, src, snippet_index, out_spirv)) {
+                if (!cached_compile(inp, EShLangVertex, slang, src, snippet_index, debug_info, cache, store, out_spirv)) {
                     return out_spirv;
                 }
                 break;
             case Snippet::FS:
-                if (!compile(inp, EShLangFragment, slang, src, snippet_index, out_spirv)) {
+                if (!cached_compile(inp, EShLangFragment, slang, src, snippet_index, debug_info, cache, store, out_spirv)) {
                     return out_spirv;
                 }
                 break;
             case Snippet::CS:
-                if (!compile(inp, EShLangCompute, slang, src, snippet_index, out_spirv)) {
+                if (!cached_compile(inp, EShLangCompute, slang, src, snippet_index, debug_info, cache, store, out_spirv)) {
                     return out_spirv;
                 }
                 break;
@@ -264,6 +331,83 @@ Spirv Spirv::compile_glsl_and_extract_bindings(Input& inp, Slang::Enum slang, co
     return out_spirv;
 }
 
+// results of the workers end up in the SPIRV cache (and the artifact cache), so that
+// compile_glsl_and_extract_bindings() only needs to compile what the workers couldn't,
+// snippets are only compiled once even if they are used by several programs
+void Spirv::compile_on_workers(const Args& args, const Input& inp, WorkerPool& pool, SpirvCache& cache) {
+    std::vector<WorkerJob> jobs;
+    std::vector<std::string> keys;
+    std::vector<int> snippet_indices;
+    std::set<std::string> job_keys;
+    for (int i = 0; i < Slang::Num; i++) {
+        const Slang::Enum slang = Slang::from_index(i);
+        if (0 == (args.slang & Slang::bit(slang))) {
+            continue;
+        }
+        for (int snippet_index = 0; snippet_index < (int)inp.snippets.size(); snippet_index++) {
+            const Snippet& snippet = inp.snippets[snippet_index];
+            if (!Snippet::is_vs(snippet.type) && !Snippet::is_fs(snippet.type) && !Snippet::is_cs(snippet.type)) {
+                continue;
+            }
+            const MergedSource src = merge_source(inp, snippet, slang, args.defines);
+            const std::string key = spirv_cache_key(snippet_stage(snippet.type), slang, false, src.src);
+            if ((cache.items.count(key) > 0) || !job_keys.insert(key).second) {
+                continue;
+            }
+            std::string data;
+            if (args.cache && args.cache->get(ArtifactCache::key("spirv", key), data)) {
+                Deserializer reader(data);
+                SpirvBlob blob = reader.spirv_blob(snippet_index);
+                if (reader.done()) {
+                    cache.items.emplace(key, std::move(blob));
+                    continue;
+                }
+            }
+            WorkerJob job;
+            job.type = WorkerJob::SPIRV;
+            job.slang = slang;
+            job.snippet_type = snippet.type;
+            job.source = src.src;
+            job.linenr_offset = src.linenr_offset;
+            job.name = fmt::format("spirv:{}:{}:{}:{}", Slang::to_str(slang), inp.base_path, snippet.name, Snippet::type_to_str(snippet.type));
+            jobs.push_back(std::move(job));
+            keys.push_back(key);
+            snippet_indices.push_back(snippet_index);
+        }
+    }
+    const std::vector<WorkerResult> results = pool.run(jobs);
+    for (size_t i = 0; i < results.size(); i++) {
+        if (!results[i].valid) {
+            continue;
+        }
+        Deserializer reader(results[i].data);
+        SpirvBlob blob = reader.spirv_blob(snippet_indices[i]);
+        if (reader.done()) {
+            cache.items.emplace(keys[i], std::move(blob));
+            if (args.cache) {
+                args.cache->put(ArtifactCache::key("spirv", keys[i]), results[i].data);
+            }
+        }
+    }
+}
+
+// there's no Input on a worker, any errors or warnings just fail the job and the
+// coordinator compiles the snippet itself to get messages with source locations
+bool Spirv::compile_job(const WorkerJob& job, SpirvBlob& out_blob) {
+    Input inp;
+    inp.base_path = "worker";
+    inp.snippets.push_back(Snippet((Snippet::Type)job.snippet_type, "worker"));
+    MergedSource src;
+    src.src = job.source;
+    src.linenr_offset = job.linenr_offset;
+    Spirv spirv;
+    if (!compile(inp, snippet_stage(job.snippet_type), job.slang, src, 0, false, spirv) || !spirv.errors.empty()) {
+        return false;
+    }
+    out_blob = std::move(spirv.blobs.back());
+    return true;
+}
+
 bool Spirv::write_to_file(const Args& args, const Input& inp, Slang::Enum slang) {
     std::string base_dir;
     std::string base_filename;
@@ -273,22 +417,14 @@ bool Spirv::write_to_file(const Args& args, const Input& inp, Slang::Enum slang)
         const Snippet& snippet = inp.snippets[blob.snippet_index];
         {
             const std::string path = fmt::format("{}{}.spv", base_path, snippet.name);
-            FILE* fp = fopen(path.c_str(), "wb");
-            if (fp) {
-                fwrite(blob.bytecode.data(), sizeof(uint32_t), blob.bytecode.size(), fp);
-                fclose(fp);
-            } else {
+            if (!args.vfs->write(path, blob.bytecode.data(), blob.bytecode.size() * sizeof(uint32_t))) {
                 fmt::print("Failed to open '{}' for writing!\n", path);
                 return false;
             }
         }
         {
             const std::string path = fmt::format("{}{}.glsl", base_path, snippet.name);
-            FILE* fp = fopen(path.c_str(), "w");
-            if (fp) {
-                fwrite(blob.source.c_str(), 1, blob.source.length(), fp);
-                fclose(fp);
-            } else {
+            if (!args.vfs->write(path, blob.source.data(), blob.source.length())) {
                 fmt::print("Failed to open '{}' for writing!\n", path);
                 return false;
             }
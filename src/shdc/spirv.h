@@ -1,14 +1,26 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <map>
 #include "args.h"
 #include "input.h"
 #include "types/errmsg.h"
 #include "types/spirv_blob.h"
 #include "types/slang.h"
+#include "worker.h"
 
 namespace shdc {
 
+// optional cache of SPIRV compilation results keyed by the merged snippet source (which
+// includes the shader language and user defines), used by long-running modes to only
+// recompile the snippets which have actually changed, only compilations without any
+// errors or warnings are cached since messages refer to source line positions (the
+// same rules apply to the persistent ArtifactCache)
+struct SpirvCache {
+    std::map<std::string, SpirvBlob> items;     // stage + slang + debug info flag + merged source => result
+    int num_hits = 0;
+};
+
 // glslang SPIRV output of all shader source snippets for one shading language
 struct Spirv {
     std::vector<ErrMsg> errors;
@@ -16,7 +28,11 @@ struct Spirv {
 
     static void initialize_spirv_tools();
     static void finalize_spirv_tools();
-    static Spirv compile_glsl_and_extract_bindings(Input& inp, Slang::Enum slang, const std::vector<std::string>& defines);
+    static Spirv compile_glsl_and_extract_bindings(Input& inp, Slang::Enum slang, const std::vector<std::string>& defines, bool debug_info = false, SpirvCache* cache = nullptr, ArtifactCache* store = nullptr);
+    // compile all snippets of all requested shader languages on --workers processes into the SPIRV cache
+    static void compile_on_workers(const Args& args, const Input& inp, WorkerPool& pool, SpirvCache& cache);
+    // run a job from a coordinator on a --worker process, false if it had any errors or warnings
+    static bool compile_job(const WorkerJob& job, SpirvBlob& out_blob);
     bool write_to_file(const Args& args, const Input& inp, Slang::Enum slang);
     void dump_debug(const Input& inp, ErrMsg::Format err_fmt) const;
 };
@@ -510,6 +510,44 @@ static SpirvcrossSource to_wgsl(const Input& inp, const SpirvBlob& blob, Slang::
     return res;
 }
 
+// a normalized key of everything which affects a translation result: the SPIRV content, the
+// snippet (for reflection), the backend compiler options, the snippet options and the resolved
+// bind slots; shader languages with identical keys produce identical results
+static std::string translation_key(const SpirvBlob& blob, Slang::Enum slang, uint32_t opt_mask) {
+    std::string dialect;
+    switch (slang) {
+        case Slang::GLSL410:        dialect = "glsl410"; break;
+        case Slang::GLSL430:        dialect = "glsl430"; break;
+        case Slang::GLSL300ES:      dialect = "glsl300es"; break;
+        case Slang::GLSL310ES:      dialect = "glsl310es"; break;
+        case Slang::SPIRV_VK:       dialect = "spirv_vk"; break;
+        case Slang::HLSL4:          dialect = "hlsl_sm40"; break;
+        case Slang::HLSL5:          dialect = "hlsl_sm50"; break;
+        case Slang::METAL_MACOS:    dialect = "msl_macos"; break;
+        case Slang::METAL_IOS:
+        case Slang::METAL_SIM:      dialect = "msl_ios"; break;
+        case Slang::WGSL:           dialect = "wgsl"; break;
+        default:                    dialect = Slang::to_str(slang); break;
+    }
+    std::string key = fmt::format("{:016x}:{}:{}:{}:{}",
+        util::hash64(blob.bytecode.data(), blob.bytecode.size() * sizeof(uint32_t)),
+        blob.bytecode.size(),
+        blob.snippet_index,
+        dialect,
+        opt_mask);
+    const auto add_bindslots = [&key, slang](const auto& bindslots) {
+        for (const BindSlot& bs: bindslots) {
+            if (!bs.empty()) {
+                key += fmt::format(":{}={}", bs.name, bs.get_slot_by_slang(slang));
+            }
+        }
+    };
+    add_bindslots(blob.bindings.uniform_blocks);
+    add_bindslots(blob.bindings.views);
+    add_bindslots(blob.bindings.samplers);
+    return key;
+}
+
 struct SnippetRefls {
     const Snippet& vs_snippet;
     const Snippet& fs_snippet;
@@ -517,7 +555,7 @@ struct SnippetRefls {
     const StageReflection fs_refl;
 };
 
-Spirvcross Spirvcross::translate(const Input& inp, const Spirv& spirv, Slang::Enum slang) {
+Spirvcross Spirvcross::translate(const Input& inp, const Spirv& spirv, Slang::Enum slang, SpirvcrossCache& cache) {
     Spirvcross spv_cross;
     try {
         for (const auto& blob: spirv.blobs) {
@@ -529,6 +567,13 @@ Spirvcross Spirvcross::translate(const Input& inp, const Spirv& spirv, Slang::En
             if (spv_cross.error.valid()) {
                 return spv_cross;
             }
+            const std::string key = translation_key(blob, slang, opt_mask);
+            const auto cache_it = cache.items.find(key);
+            if ((cache_it != cache.items.end()) && (cache_it->second.bytecode == blob.bytecode)) {
+                cache.num_hits++;
+                spv_cross.sources.push_back(cache_it->second.source);
+                continue;
+            }
             if (Slang::is_glsl(slang) || Slang::is_spirv(slang)) {
                 src = to_glsl(inp, blob, slang, opt_mask, snippet);
             } else if (Slang::is_hlsl(slang)) {
@@ -540,6 +585,7 @@ Spirvcross Spirvcross::translate(const Input& inp, const Spirv& spirv, Slang::En
             }
             if (src.valid) {
                 assert(src.snippet_index == blob.snippet_index);
+                cache.items[key] = { blob.bytecode, src };
                 spv_cross.sources.push_back(std::move(src));
             } else {
                 const int line_index = util::first_snippet_line_index_skipping_include_blocks(inp, snippet);
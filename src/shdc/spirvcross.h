@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include <map>
 #include "spirv_cross.hpp"
 #include "input.h"
 #include "spirv.h"
@@ -10,12 +11,23 @@
 
 namespace shdc {
 
+// memoized SPIRVCross translation results across target languages, shader languages
+// which translate with identical options (e.g. METAL_IOS and METAL_SIM) are only translated once
+struct SpirvcrossCache {
+    struct Item {
+        std::vector<uint32_t> bytecode; // to guard against hash collisions
+        SpirvcrossSource source;
+    };
+    std::map<std::string, Item> items;  // normalized translation key => translation result
+    int num_hits = 0;
+};
+
 // SPIRVCross output for all shader snippets of one target language
 struct Spirvcross {
     ErrMsg error;
     std::vector<SpirvcrossSource> sources;
 
-    static Spirvcross translate(const Input& inp, const Spirv& spirv, Slang::Enum slang);
+    static Spirvcross translate(const Input& inp, const Spirv& spirv, Slang::Enum slang, SpirvcrossCache& cache);
     static bool can_flatten_uniform_block(const spirv_cross::Compiler& compiler, const spirv_cross::Resource& ub_res);
     const SpirvcrossSource* find_source_by_snippet_index(int snippet_index) const;
     void dump_debug(ErrMsg::Format err_fmt, Slang::Enum slang) const;
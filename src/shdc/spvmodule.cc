@@ -0,0 +1,257 @@
+/*
+    minimal SPIRV instruction stream decoder/encoder
+*/
+#include <algorithm>
+#include "spvmodule.h"
+
+namespace shdc {
+
+// number of words occupied by a nul-terminated literal string starting at words[start]
+static size_t string_word_count(const std::vector<uint32_t>& words, size_t start) {
+    for (size_t i = start; i < words.size(); i++) {
+        const uint32_t w = words[i];
+        if (((w & 0xFF) == 0) || ((w & 0xFF00) == 0) || ((w & 0xFF0000) == 0) || ((w & 0xFF000000) == 0)) {
+            return i - start + 1;
+        }
+    }
+    return words.size() - start;
+}
+
+std::string SpvInst::string_operand(size_t i) const {
+    std::string str;
+    for (size_t wi = i + 1; wi < words.size(); wi++) {
+        const uint32_t w = words[wi];
+        for (int b = 0; b < 4; b++) {
+            const char c = (char)((w >> (b * 8)) & 0xFF);
+            if (c == 0) {
+                return str;
+            }
+            str.push_back(c);
+        }
+    }
+    return str;
+}
+
+std::vector<uint32_t> SpvInst::encode_string(const std::string& str) {
+    std::vector<uint32_t> res((str.size() / 4) + 1, 0);
+    for (size_t i = 0; i < str.size(); i++) {
+        res[i / 4] |= ((uint32_t)(uint8_t)str[i]) << ((i & 3) * 8);
+    }
+    return res;
+}
+
+// true for instructions with a result type and result id as first two operands
+bool SpvInst::has_type_and_result() const {
+    switch (op) {
+        case spv::OpUndef:
+        case spv::OpExtInst:
+        case spv::OpFunctionParameter:
+        case spv::OpFunctionCall:
+        case spv::OpLoad:
+        case spv::OpAccessChain:
+        case spv::OpInBoundsAccessChain:
+        case spv::OpPhi:
+            return true;
+        case spv::OpImageWrite:
+        case spv::OpAtomicStore:
+            return false;
+        default:
+            return ((op >= spv::OpVectorExtractDynamic) && (op <= spv::OpTranspose)) ||
+                   ((op >= spv::OpSampledImage) && (op <= spv::OpImageQuerySamples)) ||
+                   ((op >= spv::OpConvertFToU) && (op <= spv::OpBitcast)) ||
+                   ((op >= spv::OpSNegate) && (op <= spv::OpBitCount)) ||
+                   ((op >= spv::OpDPdx) && (op <= spv::OpFwidthCoarse)) ||
+                   ((op >= spv::OpAtomicLoad) && (op <= spv::OpAtomicXor));
+    }
+}
+
+SpvModule SpvModule::parse(const std::vector<uint32_t>& bytecode) {
+    SpvModule mod;
+    if ((bytecode.size() < 5) || (bytecode[0] != spv::MagicNumber)) {
+        return mod;
+    }
+    for (int i = 0; i < 5; i++) {
+        mod.header[i] = bytecode[i];
+    }
+    size_t pos = 5;
+    while (pos < bytecode.size()) {
+        const uint32_t word_count = bytecode[pos] >> 16;
+        if ((word_count == 0) || ((pos + word_count) > bytecode.size())) {
+            return mod;
+        }
+        SpvInst inst;
+        inst.op = (spv::Op)(bytecode[pos] & 0xFFFF);
+        inst.words.assign(bytecode.begin() + pos, bytecode.begin() + pos + word_count);
+        mod.insts.push_back(std::move(inst));
+        pos += word_count;
+    }
+    mod.valid = true;
+    return mod;
+}
+
+std::vector<uint32_t> SpvModule::to_bytecode() const {
+    std::vector<uint32_t> res(header, header + 5);
+    for (const SpvInst& inst: insts) {
+        res.insert(res.end(), inst.words.begin(), inst.words.end());
+    }
+    return res;
+}
+
+uint32_t SpvModule::alloc_id() {
+    return header[3]++;
+}
+
+static bool is_type_decl(spv::Op op) {
+    return (op >= spv::OpTypeVoid) && (op <= spv::OpTypeFunction);
+}
+
+int SpvModule::find_type(uint32_t type_id) const {
+    for (int i = 0; i < (int)insts.size(); i++) {
+        const SpvInst& inst = insts[i];
+        if (is_type_decl(inst.op) && (inst.operand(0) == type_id)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int SpvModule::find_variable(uint32_t var_id) const {
+    for (int i = 0; i < (int)insts.size(); i++) {
+        const SpvInst& inst = insts[i];
+        if ((inst.op == spv::OpVariable) && (inst.operand(1) == var_id)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int SpvModule::find_name(uint32_t id) const {
+    for (int i = 0; i < (int)insts.size(); i++) {
+        const SpvInst& inst = insts[i];
+        if ((inst.op == spv::OpName) && (inst.operand(0) == id)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int SpvModule::first_function() const {
+    for (int i = 0; i < (int)insts.size(); i++) {
+        if (insts[i].op == spv::OpFunction) {
+            return i;
+        }
+    }
+    return (int)insts.size();
+}
+
+uint32_t SpvModule::find_or_add_type(spv::Op op, const std::vector<uint32_t>& operands) {
+    for (const SpvInst& inst: insts) {
+        if ((inst.op == op) && (inst.num_operands() == (operands.size() + 1))) {
+            if (std::equal(operands.begin(), operands.end(), inst.words.begin() + 2)) {
+                return inst.operand(0);
+            }
+        }
+    }
+    const uint32_t type_id = alloc_id();
+    std::vector<uint32_t> type_operands = { type_id };
+    type_operands.insert(type_operands.end(), operands.begin(), operands.end());
+    insts.insert(insts.begin() + first_function(), SpvInst::make(op, type_operands));
+    return type_id;
+}
+
+bool SpvModule::has_decoration(uint32_t id, spv::Decoration deco) const {
+    for (const SpvInst& inst: insts) {
+        if ((inst.op == spv::OpDecorate) && (inst.operand(0) == id) && (inst.operand(1) == (uint32_t)deco)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SpvModule::find_decoration(uint32_t id, spv::Decoration deco, uint32_t& out_value) const {
+    for (const SpvInst& inst: insts) {
+        if ((inst.op == spv::OpDecorate) && (inst.operand(0) == id) && (inst.operand(1) == (uint32_t)deco)) {
+            out_value = (inst.num_operands() > 2) ? inst.operand(2) : 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+void SpvModule::set_decoration(uint32_t id, spv::Decoration deco, uint32_t value) {
+    int last_annotation = -1;
+    for (int i = 0; i < (int)insts.size(); i++) {
+        SpvInst& inst = insts[i];
+        if ((inst.op == spv::OpDecorate) || (inst.op == spv::OpMemberDecorate)) {
+            if ((inst.op == spv::OpDecorate) && (inst.operand(0) == id) && (inst.operand(1) == (uint32_t)deco)) {
+                inst = SpvInst::make(spv::OpDecorate, { id, (uint32_t)deco, value });
+                return;
+            }
+            last_annotation = i;
+        } else if (is_type_decl(inst.op) && (last_annotation == -1)) {
+            last_annotation = i - 1;
+            break;
+        }
+    }
+    insts.insert(insts.begin() + last_annotation + 1, SpvInst::make(spv::OpDecorate, { id, (uint32_t)deco, value }));
+}
+
+void SpvModule::set_name(uint32_t id, const std::string& name) {
+    std::vector<uint32_t> operands = { id };
+    const std::vector<uint32_t> str = SpvInst::encode_string(name);
+    operands.insert(operands.end(), str.begin(), str.end());
+    // names go after the last existing name, or before the module-processed,
+    // annotation and type declaration sections
+    int insert_pos = -1;
+    int first_after_debug = (int)insts.size();
+    for (int i = 0; i < (int)insts.size(); i++) {
+        SpvInst& inst = insts[i];
+        if ((inst.op == spv::OpName) && (inst.operand(0) == id)) {
+            inst = SpvInst::make(spv::OpName, operands);
+            return;
+        }
+        if ((inst.op == spv::OpName) || (inst.op == spv::OpMemberName)) {
+            insert_pos = i + 1;
+        } else if ((inst.op == spv::OpModuleProcessed) || (inst.op == spv::OpDecorate) || (inst.op == spv::OpMemberDecorate) || is_type_decl(inst.op)) {
+            first_after_debug = std::min(first_after_debug, i);
+        }
+    }
+    if (insert_pos == -1) {
+        insert_pos = first_after_debug;
+    }
+    insts.insert(insts.begin() + insert_pos, SpvInst::make(spv::OpName, operands));
+}
+
+void SpvModule::add_interface(uint32_t var_id) {
+    for (SpvInst& inst: insts) {
+        if (inst.op == spv::OpEntryPoint) {
+            inst.words.push_back(var_id);
+            inst.words[0] = (uint32_t)(inst.words.size() << 16) | (uint32_t)inst.op;
+        }
+    }
+}
+
+void SpvModule::remove_id_references(uint32_t id) {
+    for (auto it = insts.begin(); it != insts.end();) {
+        const spv::Op op = it->op;
+        if (((op == spv::OpName) || (op == spv::OpMemberName) || (op == spv::OpDecorate) || (op == spv::OpMemberDecorate)) && (it->operand(0) == id)) {
+            it = insts.erase(it);
+            continue;
+        }
+        if (op == spv::OpEntryPoint) {
+            // interface ids follow the execution model, function id and name string
+            const size_t first_iface = 3 + string_word_count(it->words, 3);
+            for (size_t i = first_iface; i < it->words.size();) {
+                if (it->words[i] == id) {
+                    it->words.erase(it->words.begin() + i);
+                } else {
+                    i++;
+                }
+            }
+            it->words[0] = (uint32_t)(it->words.size() << 16) | (uint32_t)op;
+        }
+        ++it;
+    }
+}
+
+} // namespace shdc
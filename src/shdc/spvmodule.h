@@ -0,0 +1,79 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "spirv.hpp"
+
+namespace shdc {
+
+// a single decoded SPIRV instruction
+struct SpvInst {
+    spv::Op op = spv::OpNop;
+    std::vector<uint32_t> words;    // complete instruction, including the leading opcode/wordcount word
+
+    static SpvInst make(spv::Op op, const std::vector<uint32_t>& operands);
+    size_t num_operands() const;
+    uint32_t operand(size_t i) const;
+    bool uses_id(uint32_t id, size_t first_operand = 0) const;
+    // true for instructions with a result type and result id as first two operands
+    bool has_type_and_result() const;
+    std::string string_operand(size_t i) const;
+    static std::vector<uint32_t> encode_string(const std::string& str);
+};
+
+// a minimal instruction-level view of a SPIRV module for simple analysis and rewrite passes
+struct SpvModule {
+    bool valid = false;
+    uint32_t header[5] = { };
+    std::vector<SpvInst> insts;
+
+    static SpvModule parse(const std::vector<uint32_t>& bytecode);
+    std::vector<uint32_t> to_bytecode() const;
+    uint32_t alloc_id();
+    // return index into insts or -1 if not found
+    int find_type(uint32_t type_id) const;
+    int find_variable(uint32_t var_id) const;
+    int find_name(uint32_t id) const;
+    int first_function() const;
+    // find an existing type declaration or append a new one before the first function
+    uint32_t find_or_add_type(spv::Op op, const std::vector<uint32_t>& operands);
+    bool has_decoration(uint32_t id, spv::Decoration deco) const;
+    bool find_decoration(uint32_t id, spv::Decoration deco, uint32_t& out_value) const;
+    void set_decoration(uint32_t id, spv::Decoration deco, uint32_t value);
+    void set_name(uint32_t id, const std::string& name);
+    // add a variable to the interface of all entry points
+    void add_interface(uint32_t var_id);
+    // remove all debug names, decorations and entry point interface references of an id
+    void remove_id_references(uint32_t id);
+};
+
+inline SpvInst SpvInst::make(spv::Op op, const std::vector<uint32_t>& operands) {
+    SpvInst inst;
+    inst.op = op;
+    inst.words.reserve(operands.size() + 1);
+    inst.words.push_back((uint32_t)((operands.size() + 1) << 16) | (uint32_t)op);
+    inst.words.insert(inst.words.end(), operands.begin(), operands.end());
+    return inst;
+}
+
+inline size_t SpvInst::num_operands() const {
+    return words.size() - 1;
+}
+
+inline uint32_t SpvInst::operand(size_t i) const {
+    return words[i + 1];
+}
+
+// NOTE: this doesn't know which operands are ids and which are literals, so a literal
+// which happens to have the same value as the id is also reported as 'use', that's
+// ok as long as callers only use the result for conservative decisions
+inline bool SpvInst::uses_id(uint32_t id, size_t first_operand) const {
+    for (size_t i = first_operand + 1; i < words.size(); i++) {
+        if (words[i] == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace shdc
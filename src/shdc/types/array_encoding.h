@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+
+namespace shdc {
+
+// how embedded shader source and bytecode arrays are written to generated code
+struct ArrayEncoding {
+    enum Enum {
+        HEX = 0,    // comma-separated hex numbers (all output formats)
+        STRING,     // escaped string literals (C only)
+        EMBED,      // sidecar binary file pulled in with the language's embed facility
+        NUM,
+        INVALID,
+    };
+
+    static const char* to_str(Enum e);
+    static Enum from_str(const std::string& str);
+};
+
+inline const char* ArrayEncoding::to_str(Enum e) {
+    switch (e) {
+        case HEX:       return "hex";
+        case STRING:    return "string";
+        case EMBED:     return "embed";
+        default:        return "<invalid>";
+    }
+}
+
+inline ArrayEncoding::Enum ArrayEncoding::from_str(const std::string& str) {
+    if (str == "hex") {
+        return HEX;
+    } else if (str == "string") {
+        return STRING;
+    } else if (str == "embed") {
+        return EMBED;
+    } else {
+        return INVALID;
+    }
+}
+
+} // namespace shdc
@@ -18,12 +18,15 @@ struct Format	{
         SOKOL_C3,
         BARE,
         BARE_YAML,
+        SOKOL_PACK,
         NUM,
         INVALID,
     };
 
     static const char* to_str(Enum f);
     static Enum from_str(const std::string& str);
+    // the file extension of the generated file, empty for the bare formats which write several files next to the output path
+    static const char* extension(Enum f);
 };
 
 inline const char* Format::to_str(Enum f) {
@@ -40,10 +43,28 @@ inline const char* Format::to_str(Enum f) {
         case SOKOL_C3:      return "sokol_c3";
         case BARE:          return "bare";
         case BARE_YAML:     return "bare_yaml";
+        case SOKOL_PACK:    return "sokol_pack";
         default:            return "<invalid>";
     }
 }
 
+inline const char* Format::extension(Enum f) {
+    switch (f) {
+        case SOKOL:         return ".h";
+        case SOKOL_IMPL:    return ".h";
+        case SOKOL_ZIG:     return ".zig";
+        case SOKOL_NIM:     return ".nim";
+        case SOKOL_ODIN:    return ".odin";
+        case SOKOL_RUST:    return ".rs";
+        case SOKOL_D:       return ".d";
+        case SOKOL_JAI:     return ".jai";
+        case SOKOL_C2:      return ".c2";
+        case SOKOL_C3:      return ".c3";
+        case SOKOL_PACK:    return ".pack";
+        default:            return "";
+    }
+}
+
 inline Format::Enum Format::from_str(const std::string& str) {
     if (str == "sokol") {
         return SOKOL;
@@ -69,6 +90,8 @@ inline Format::Enum Format::from_str(const std::string& str) {
         return BARE;
     } else if (str == "bare_yaml") {
         return BARE_YAML;
+    } else if (str == "sokol_pack") {
+        return SOKOL_PACK;
     } else {
         return INVALID;
     }
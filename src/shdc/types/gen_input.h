@@ -4,6 +4,7 @@
 #include "spirvcross.h"
 #include "bytecode.h"
 #include "reflection.h"
+#include "analysis.h"
 
 namespace shdc::gen {
 
@@ -13,12 +14,14 @@ struct GenInput {
     const std::array<Spirvcross,Slang::Num>& spirvcross;
     const std::array<Bytecode,Slang::Num>& bytecode;
     const refl::Reflection& refl;
+    const Analysis& analysis;
 
     GenInput(const Args& args,
              const Input& inp,
              const std::array<Spirvcross,Slang::Num>& spirvcross,
              const std::array<Bytecode,Slang::Num>& bytecode,
-             const refl::Reflection& refl);
+             const refl::Reflection& refl,
+             const Analysis& analysis);
 };
 
 inline GenInput::GenInput(
@@ -26,12 +29,14 @@ inline GenInput::GenInput(
     const Input& _inp,
     const std::array<Spirvcross,Slang::Num>& _spirvcross,
     const std::array<Bytecode,Slang::Num>& _bytecode,
-    const refl::Reflection& _refl):
+    const refl::Reflection& _refl,
+    const Analysis& _analysis):
 args(_args),
 inp(_inp),
 spirvcross(_spirvcross),
 bytecode(_bytecode),
-refl(_refl)
+refl(_refl),
+analysis(_analysis)
 { };
 
 } // namespace
@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace shdc {
+
+// a '@lint_ignore [rules...]' tag, inside a snippet it applies to the next
+// source line, outside of snippets to the entire input
+struct LintIgnoreTag {
+    std::vector<std::string> rules;     // empty for all rules
+    int line_index = 0;
+    bool in_snippet = false;
+    LintIgnoreTag();
+    LintIgnoreTag(const std::vector<std::string>& r, int l, bool s);
+    bool ignores(const std::string& rule, int line_idx) const;
+};
+
+inline LintIgnoreTag::LintIgnoreTag() { };
+
+inline LintIgnoreTag::LintIgnoreTag(const std::vector<std::string>& r, int l, bool s):
+    rules(r),
+    line_index(l),
+    in_snippet(s)
+{ };
+
+inline bool LintIgnoreTag::ignores(const std::string& rule, int line_idx) const {
+    if (in_snippet && (line_idx != (line_index + 1))) {
+        return false;
+    }
+    if (rules.empty()) {
+        return true;
+    }
+    for (const std::string& r: rules) {
+        if (r == rule) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace shdc
@@ -0,0 +1,36 @@
+#pragma once
+#include <array>
+#include "slang.h"
+
+namespace shdc {
+
+// static cost estimate of a single shader snippet, derived from its optimized SPIRV
+struct ShaderCost {
+    struct SlangSize {
+        int source_bytes = 0;       // size of cross-compiled source code
+        int bytecode_bytes = 0;     // size of compiled bytecode (0 if no bytecode)
+    };
+    int snippet_index = -1;         // index into Input.snippets
+    int spirv_bytes = 0;            // size of the optimized SPIRV blob
+    int instructions = 0;           // all SPIRV instructions in function bodies
+    int alu_ops = 0;                // arithmetic, logical, conversion and derivative instructions
+    int transcendental_ops = 0;     // sin, cos, pow, exp, log, sqrt, ...
+    int texture_samples = 0;        // texture sample, gather and fetch instructions
+    int dependent_texture_reads = 0;    // texture accesses with coordinates computed from other texture accesses
+    int loops = 0;
+    int branches = 0;               // conditional branches and switches
+    int discards = 0;
+    int storage_loads = 0;          // storage buffer and storage image reads
+    int storage_stores = 0;         // storage buffer and storage image writes (including atomics)
+    int shared_memory_bytes = 0;    // compute shader workgroup-shared memory
+    int live_values = 0;            // estimated peak number of live scalar values
+    std::array<SlangSize, Slang::Num> slang_sizes;
+};
+
+// static cost estimate attributed to a single line of the input source
+struct LineCost {
+    int line_index = -1;            // index into Input.lines
+    ShaderCost cost;
+};
+
+} // namespace shdc
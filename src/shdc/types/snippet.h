@@ -6,6 +6,7 @@
 #include "slang.h"
 #include "image_sample_type_tag.h"
 #include "sampler_type_tag.h"
+#include "lint_ignore_tag.h"
 
 namespace shdc {
 
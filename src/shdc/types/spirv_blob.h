@@ -9,6 +9,7 @@ namespace shdc {
 struct SpirvBlob {
     int snippet_index = -1;         // index into Input.snippets
     std::string source;             // source code this blob was compiled from
+    int linenr_offset = 0;          // number of injected lines in front of the snippet source
     std::vector<uint32_t> bytecode; // the resulting SPIRV blob
     BindSlotMap bindings;           // extracted bindings
 
@@ -1,25 +1,47 @@
 #include "util.h"
 #include "pystring.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
 
 namespace shdc::util {
 
-ErrMsg write_dep_file(const Args& args, const Input& inp) {
+// the targets are all files written by the code generator (for instance one file per
+// program, stage and shader language for the bare output formats)
+ErrMsg write_dep_file(const Args& args, const Input& inp, const std::vector<std::string>& output_files) {
     std::string content;
-    content.append(fmt::format("{}: {}", args.output, inp.filenames[0]));
+    content.append(output_files.empty() ? args.output : pystring::join(" ", output_files));
+    content.append(fmt::format(": {}", inp.filenames[0]));
     for (size_t i = 1; i < inp.filenames.size(); i++) {
         const std::string& fn = inp.filenames[i];
         content.append(fmt::format(" \\\n  {}", fn));
     }
     content.append("\n");
-    FILE* f = fopen(args.dependency_file.c_str(), "w");
-    if (!f) {
-        return ErrMsg::error(inp.base_path, 0, fmt::format("failed to open dependency output file '{}'", args.dependency_file));
+    if (!write_file_if_changed(*args.vfs, args.dependency_file, content.data(), content.length(), true)) {
+        return ErrMsg::error(inp.base_path, 0, fmt::format("failed to write dependency output file '{}'", args.dependency_file));
     }
-    fwrite(content.c_str(), content.length(), 1, f);
-    fclose(f);
     return ErrMsg();
 }
 
+bool write_file_if_changed(Vfs& vfs, const std::string& path, const void* data, size_t num_bytes, bool is_text) {
+    #if defined(_WIN32)
+    // same result as writing in text mode
+    std::string crlf;
+    if (is_text) {
+        crlf = pystring::replace(std::string((const char*)data, num_bytes), "\n", "\r\n");
+        data = crlf.data();
+        num_bytes = crlf.length();
+    }
+    #else
+    (void)is_text;
+    #endif
+    std::string existing;
+    if (vfs.read(path, existing) && (existing.length() == num_bytes) && (0 == memcmp(existing.data(), data, num_bytes))) {
+        return true;
+    }
+    return vfs.write(path, data, num_bytes);
+}
+
 // this returns the first line index of a snippet which actually belong to the snippet,
 // skipping any included blocks - used for error messages which should be positioned
 // at the start of a snippet (if the snippet started with an @include_block that first
@@ -35,6 +57,42 @@ int first_snippet_line_index_skipping_include_blocks(const Input& inp, const Sni
     return snippet.lines[0];
 }
 
+// quote and escape a string for use in a JSON file
+std::string json_string(const std::string& str) {
+    std::string res = "\"";
+    for (const char c: str) {
+        switch (c) {
+            case '"':  res += "\\\""; break;
+            case '\\': res += "\\\\"; break;
+            case '\n': res += "\\n"; break;
+            case '\r': res += "\\r"; break;
+            case '\t': res += "\\t"; break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    res += fmt::format("\\u{:04x}", (int)(unsigned char)c);
+                } else {
+                    res += c;
+                }
+                break;
+        }
+    }
+    res += "\"";
+    return res;
+}
+
+// match a string against a simple glob pattern ('*' matches any sequence, '?' any single character)
+bool glob_match(const char* pattern, const char* str) {
+    if (*pattern == 0) {
+        return *str == 0;
+    } else if (*pattern == '*') {
+        return glob_match(pattern + 1, str) || ((*str != 0) && glob_match(pattern, str + 1));
+    } else if ((*str != 0) && ((*pattern == '?') || (*pattern == *str))) {
+        return glob_match(pattern + 1, str + 1);
+    } else {
+        return false;
+    }
+}
+
 // convert a glslang info-log string to ErrMsg's and append to out_errors
 void infolog_to_errors(const std::string& log, const Input& inp, int snippet_index, int linenr_offset, std::vector<ErrMsg>& out_errors) {
     /*
@@ -104,4 +162,142 @@ void infolog_to_errors(const std::string& log, const Input& inp, int snippet_ind
     }
 }
 
+// 64-bit FNV-1a content hash (stable across platforms and runs)
+uint64_t hash64(const void* data, size_t num_bytes, uint64_t seed) {
+    const uint8_t* ptr = (const uint8_t*)data;
+    uint64_t hash = seed;
+    for (size_t i = 0; i < num_bytes; i++) {
+        hash ^= ptr[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// plain FIPS 180-4 implementation, only used for cache keys so it doesn't need to be fast
+std::string sha256_hex(const void* data, size_t num_bytes) {
+    static const uint32_t k[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+    };
+    uint32_t h[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+    auto rotr = [](uint32_t x, int n) { return (x >> n) | (x << (32 - n)); };
+
+    // message with padding and big-endian bit length
+    std::string msg((const char*)data, num_bytes);
+    msg += (char)0x80;
+    while ((msg.length() % 64) != 56) {
+        msg += (char)0;
+    }
+    const uint64_t num_bits = (uint64_t)num_bytes * 8;
+    for (int i = 7; i >= 0; i--) {
+        msg += (char)((num_bits >> (i * 8)) & 0xFF);
+    }
+
+    const uint8_t* ptr = (const uint8_t*)msg.data();
+    for (size_t chunk = 0; chunk < msg.length(); chunk += 64) {
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++) {
+            const uint8_t* p = ptr + chunk + i * 4;
+            w[i] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+        }
+        for (int i = 16; i < 64; i++) {
+            const uint32_t s0 = rotr(w[i-15], 7) ^ rotr(w[i-15], 18) ^ (w[i-15] >> 3);
+            const uint32_t s1 = rotr(w[i-2], 17) ^ rotr(w[i-2], 19) ^ (w[i-2] >> 10);
+            w[i] = w[i-16] + s0 + w[i-7] + s1;
+        }
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+        for (int i = 0; i < 64; i++) {
+            const uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+            const uint32_t ch = (e & f) ^ (~e & g);
+            const uint32_t t1 = hh + s1 + ch + k[i] + w[i];
+            const uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+            const uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            const uint32_t t2 = s0 + maj;
+            hh = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+        h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+    }
+    std::string res;
+    for (int i = 0; i < 8; i++) {
+        res += fmt::format("{:08x}", h[i]);
+    }
+    return res;
+}
+
+uint32_t phash_str(uint32_t h, const std::string& str) {
+    for (const char c: str) {
+        h = (h ^ (uint8_t)c) * 0x01000193;
+    }
+    return h;
+}
+
+uint32_t phash_mix(uint32_t h) {
+    h ^= h >> 16;
+    h *= 0x85EBCA6B;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35;
+    h ^= h >> 16;
+    return h;
+}
+
+// Keys are distributed into one bucket per key by phash_mix(h) % n, then for each
+// bucket (largest first) a seed is searched which moves all keys of the bucket
+// into free table slots via phash_mix(h ^ seed) % n. Returns false if no seed
+// could be found (e.g. identical key hashes), callers must fall back to a
+// linear lookup in that case.
+bool perfect_hash(const std::vector<uint32_t>& key_hashes, std::vector<uint32_t>& out_seeds, std::vector<int>& out_slots) {
+    const uint32_t n = (uint32_t)key_hashes.size();
+    out_seeds.assign(n, 0);
+    out_slots.assign(n, -1);
+    std::vector<std::vector<int>> buckets(n);
+    for (uint32_t key_index = 0; key_index < n; key_index++) {
+        buckets[phash_mix(key_hashes[key_index]) % n].push_back(key_index);
+    }
+    std::vector<uint32_t> order(n);
+    for (uint32_t i = 0; i < n; i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&buckets](uint32_t a, uint32_t b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+    std::vector<bool> occupied(n, false);
+    for (const uint32_t bucket_index: order) {
+        const std::vector<int>& bucket = buckets[bucket_index];
+        if (bucket.empty()) {
+            break;
+        }
+        bool found = false;
+        for (uint32_t seed = 1; !found && (seed < (1 << 20)); seed++) {
+            std::vector<int> slots;
+            for (const int key_index: bucket) {
+                const int slot = (int)(phash_mix(key_hashes[key_index] ^ seed) % n);
+                if (occupied[slot] || (std::find(slots.begin(), slots.end(), slot) != slots.end())) {
+                    break;
+                }
+                slots.push_back(slot);
+            }
+            if (slots.size() == bucket.size()) {
+                for (size_t i = 0; i < bucket.size(); i++) {
+                    occupied[slots[i]] = true;
+                    out_slots[bucket[i]] = slots[i];
+                }
+                out_seeds[bucket_index] = seed;
+                found = true;
+            }
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
 } // namespace shdc::util
@@ -5,8 +5,22 @@
 
 namespace shdc::util {
 
-ErrMsg write_dep_file(const Args& args, const Input& inp);
+ErrMsg write_dep_file(const Args& args, const Input& inp, const std::vector<std::string>& output_files);
+// only writes the file if the content differs from the existing file, so that unchanged
+// outputs keep their timestamp, text files get CRLF line endings on Windows
+bool write_file_if_changed(Vfs& vfs, const std::string& path, const void* data, size_t num_bytes, bool is_text);
 int first_snippet_line_index_skipping_include_blocks(const Input& inp, const Snippet& snippet);
+std::string json_string(const std::string& str);
+bool glob_match(const char* pattern, const char* str);
+// FNV-1a, pass the result of a previous call as seed to hash several ranges
+uint64_t hash64(const void* data, size_t num_bytes, uint64_t seed = 0xcbf29ce484222325ULL);
+// SHA-256 as lower-case hex string, used for remote cache keys
+std::string sha256_hex(const void* data, size_t num_bytes);
+// string hashing and minimal perfect hashing (hash-and-displace) for generated
+// name lookups, generated code must implement the same phash_str() and phash_mix()
+uint32_t phash_str(uint32_t h, const std::string& str);
+uint32_t phash_mix(uint32_t h);
+bool perfect_hash(const std::vector<uint32_t>& key_hashes, std::vector<uint32_t>& out_seeds, std::vector<int>& out_slots);
 void infolog_to_errors(const std::string& log, const Input& inp, int snippet_index, int linenr_offset, std::vector<ErrMsg>& out_errors);
 
 } // namespace shdc::util
@@ -0,0 +1,428 @@
+/*
+    cross-stage varying elimination and packing (--link-varyings)
+*/
+#include <algorithm>
+#include "varyings.h"
+#include "spvmodule.h"
+#include "fmt/format.h"
+#include "spirv-tools/optimizer.hpp"
+
+namespace shdc {
+
+// a vertex shader output or fragment shader input variable
+struct Varying {
+    uint32_t var_id = 0;
+    uint32_t type_id = 0;           // the variable's value type
+    uint32_t location = 0;
+    int num_components = 0;         // 1..4 for 32-bit float scalars and vectors, 0 otherwise
+    bool single_location = false;   // 32-bit scalar or vector type which occupies exactly one location
+    bool plain = true;              // no decorations except Location
+    bool used = false;              // referenced by any instruction in a function body
+    bool whole_access = true;       // only whole-variable loads (inputs) or stores (outputs)
+};
+
+static bool is_exclusive(const Input& inp, const Program& prog) {
+    for (const auto& item: inp.programs) {
+        const Program& other = item.second;
+        if ((other.name != prog.name) && ((other.vs_name == prog.vs_name) || (other.fs_name == prog.fs_name))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static SpirvBlob* find_blob(Spirv& spirv, int snippet_index) {
+    for (SpirvBlob& blob: spirv.blobs) {
+        if (blob.snippet_index == snippet_index) {
+            return &blob;
+        }
+    }
+    return nullptr;
+}
+
+static bool is_single_location(const SpvModule& mod, uint32_t type_id) {
+    const int type_index = mod.find_type(type_id);
+    if (type_index < 0) {
+        return false;
+    }
+    const SpvInst& type = mod.insts[type_index];
+    if ((type.op == spv::OpTypeFloat) || (type.op == spv::OpTypeInt)) {
+        return type.operand(1) == 32;
+    } else if (type.op == spv::OpTypeVector) {
+        return is_single_location(mod, type.operand(1));
+    }
+    return false;
+}
+
+static int float_num_components(const SpvModule& mod, uint32_t type_id) {
+    const int type_index = mod.find_type(type_id);
+    if (type_index < 0) {
+        return 0;
+    }
+    const SpvInst& type = mod.insts[type_index];
+    if (type.op == spv::OpTypeFloat) {
+        return (type.operand(1) == 32) ? 1 : 0;
+    } else if (type.op == spv::OpTypeVector) {
+        return (float_num_components(mod, type.operand(1)) == 1) ? (int)type.operand(2) : 0;
+    }
+    return 0;
+}
+
+// gather all user-defined (not builtin) variables of a storage class with a Location decoration
+static std::vector<Varying> gather_varyings(const SpvModule& mod, spv::StorageClass storage_class) {
+    std::vector<Varying> res;
+    const int first_func = mod.first_function();
+    for (int i = 0; i < first_func; i++) {
+        const SpvInst& inst = mod.insts[i];
+        if ((inst.op != spv::OpVariable) || (inst.operand(2) != (uint32_t)storage_class)) {
+            continue;
+        }
+        Varying v;
+        v.var_id = inst.operand(1);
+        if (!mod.find_decoration(v.var_id, spv::DecorationLocation, v.location)) {
+            continue;
+        }
+        const int ptr_index = mod.find_type(inst.operand(0));
+        if (ptr_index < 0) {
+            continue;
+        }
+        v.type_id = mod.insts[ptr_index].operand(2);
+        v.num_components = float_num_components(mod, v.type_id);
+        v.single_location = is_single_location(mod, v.type_id);
+        for (int di = 0; di < first_func; di++) {
+            const SpvInst& deco = mod.insts[di];
+            if ((deco.op == spv::OpDecorate) && (deco.operand(0) == v.var_id) && (deco.operand(1) != spv::DecorationLocation)) {
+                v.plain = false;
+            }
+        }
+        for (int fi = first_func; fi < (int)mod.insts.size(); fi++) {
+            const SpvInst& use = mod.insts[fi];
+            if (!use.uses_id(v.var_id)) {
+                continue;
+            }
+            v.used = true;
+            if (storage_class == spv::StorageClassInput) {
+                const bool whole_load = (use.op == spv::OpLoad) && (use.operand(2) == v.var_id) && !use.uses_id(v.var_id, 3);
+                v.whole_access &= whole_load;
+            } else {
+                const bool whole_store = (use.op == spv::OpStore) && (use.operand(0) == v.var_id) && !use.uses_id(v.var_id, 1);
+                v.whole_access &= whole_store;
+            }
+        }
+        res.push_back(v);
+    }
+    return res;
+}
+
+static const Varying* find_by_location(const std::vector<Varying>& varyings, uint32_t location) {
+    for (const Varying& v: varyings) {
+        if (v.location == location) {
+            return &v;
+        }
+    }
+    return nullptr;
+}
+
+static void remove_variable(SpvModule& mod, uint32_t var_id) {
+    const int var_index = mod.find_variable(var_id);
+    if (var_index >= 0) {
+        mod.insts.erase(mod.insts.begin() + var_index);
+    }
+    mod.remove_id_references(var_id);
+}
+
+// remove all stores into an output variable (directly or through access chains), returns
+// false and leaves the module untouched if the variable is used in any other way
+static bool remove_output_stores(SpvModule& mod, uint32_t var_id) {
+    const int first_func = mod.first_function();
+    std::vector<uint32_t> ptr_ids = { var_id };
+    for (int i = first_func; i < (int)mod.insts.size(); i++) {
+        const SpvInst& inst = mod.insts[i];
+        if (((inst.op == spv::OpAccessChain) || (inst.op == spv::OpInBoundsAccessChain)) && (inst.operand(2) == var_id)) {
+            ptr_ids.push_back(inst.operand(1));
+        }
+    }
+    const auto is_ptr = [&ptr_ids](uint32_t id) {
+        return std::find(ptr_ids.begin(), ptr_ids.end(), id) != ptr_ids.end();
+    };
+    std::vector<int> removable;
+    for (int i = first_func; i < (int)mod.insts.size(); i++) {
+        const SpvInst& inst = mod.insts[i];
+        bool uses_ptr = false;
+        for (uint32_t id: ptr_ids) {
+            uses_ptr |= inst.uses_id(id);
+        }
+        if (!uses_ptr) {
+            continue;
+        }
+        const bool is_chain = ((inst.op == spv::OpAccessChain) || (inst.op == spv::OpInBoundsAccessChain)) && (inst.operand(2) == var_id);
+        const bool is_store = (inst.op == spv::OpStore) && is_ptr(inst.operand(0)) && !is_ptr(inst.operand(1));
+        if (!(is_chain || is_store)) {
+            return false;
+        }
+        removable.push_back(i);
+    }
+    for (auto it = removable.rbegin(); it != removable.rend(); ++it) {
+        mod.insts.erase(mod.insts.begin() + *it);
+    }
+    return true;
+}
+
+// a vec4 slot shared by several varyings
+struct PackedSlot {
+    struct Member {
+        uint32_t location = 0;
+        int component = 0;
+        int num_components = 0;
+    };
+    std::vector<Member> members;
+    int num_components = 0;
+    uint32_t min_location() const {
+        uint32_t loc = members[0].location;
+        for (const Member& m: members) {
+            loc = std::min(loc, m.location);
+        }
+        return loc;
+    }
+};
+
+static uint32_t add_packed_variable(SpvModule& mod, spv::StorageClass storage_class, uint32_t location) {
+    const uint32_t float_type = mod.find_or_add_type(spv::OpTypeFloat, { 32 });
+    const uint32_t vec4_type = mod.find_or_add_type(spv::OpTypeVector, { float_type, 4 });
+    const uint32_t ptr_type = mod.find_or_add_type(spv::OpTypePointer, { (uint32_t)storage_class, vec4_type });
+    const uint32_t var_id = mod.alloc_id();
+    mod.insts.insert(mod.insts.begin() + mod.first_function(), SpvInst::make(spv::OpVariable, { ptr_type, var_id, (uint32_t)storage_class }));
+    mod.set_decoration(var_id, spv::DecorationLocation, location);
+    mod.set_name(var_id, fmt::format("packed_varying_{}", location));
+    mod.add_interface(var_id);
+    return var_id;
+}
+
+// replace whole-variable stores into a vertex shader output with a read-modify-write of the packed output
+static void pack_output(SpvModule& mod, const Varying& v, uint32_t packed_var, int component) {
+    const uint32_t float_type = mod.find_or_add_type(spv::OpTypeFloat, { 32 });
+    const uint32_t vec4_type = mod.find_or_add_type(spv::OpTypeVector, { float_type, 4 });
+    for (size_t i = mod.first_function(); i < mod.insts.size(); i++) {
+        const SpvInst inst = mod.insts[i];
+        if ((inst.op != spv::OpStore) || (inst.operand(0) != v.var_id)) {
+            continue;
+        }
+        const uint32_t value = inst.operand(1);
+        const uint32_t old_id = mod.alloc_id();
+        const uint32_t new_id = mod.alloc_id();
+        std::vector<SpvInst> repl;
+        repl.push_back(SpvInst::make(spv::OpLoad, { vec4_type, old_id, packed_var }));
+        if (v.num_components == 1) {
+            repl.push_back(SpvInst::make(spv::OpCompositeInsert, { vec4_type, new_id, value, old_id, (uint32_t)component }));
+        } else {
+            std::vector<uint32_t> operands = { vec4_type, new_id, old_id, value };
+            for (int c = 0; c < 4; c++) {
+                if ((c >= component) && (c < (component + v.num_components))) {
+                    operands.push_back((uint32_t)(4 + c - component));
+                } else {
+                    operands.push_back((uint32_t)c);
+                }
+            }
+            repl.push_back(SpvInst::make(spv::OpVectorShuffle, operands));
+        }
+        repl.push_back(SpvInst::make(spv::OpStore, { packed_var, new_id }));
+        mod.insts.erase(mod.insts.begin() + i);
+        mod.insts.insert(mod.insts.begin() + i, repl.begin(), repl.end());
+        i += repl.size() - 1;
+    }
+    remove_variable(mod, v.var_id);
+}
+
+// replace whole-variable loads from a fragment shader input with an extract from the packed input
+static void pack_input(SpvModule& mod, const Varying& v, uint32_t packed_var, int component) {
+    const uint32_t float_type = mod.find_or_add_type(spv::OpTypeFloat, { 32 });
+    const uint32_t vec4_type = mod.find_or_add_type(spv::OpTypeVector, { float_type, 4 });
+    for (size_t i = mod.first_function(); i < mod.insts.size(); i++) {
+        const SpvInst inst = mod.insts[i];
+        if ((inst.op != spv::OpLoad) || (inst.operand(2) != v.var_id)) {
+            continue;
+        }
+        const uint32_t result_type = inst.operand(0);
+        const uint32_t result_id = inst.operand(1);
+        const uint32_t packed_id = mod.alloc_id();
+        std::vector<SpvInst> repl;
+        repl.push_back(SpvInst::make(spv::OpLoad, { vec4_type, packed_id, packed_var }));
+        if (v.num_components == 1) {
+            repl.push_back(SpvInst::make(spv::OpCompositeExtract, { result_type, result_id, packed_id, (uint32_t)component }));
+        } else {
+            std::vector<uint32_t> operands = { result_type, result_id, packed_id, packed_id };
+            for (int c = 0; c < v.num_components; c++) {
+                operands.push_back((uint32_t)(component + c));
+            }
+            repl.push_back(SpvInst::make(spv::OpVectorShuffle, operands));
+        }
+        mod.insts.erase(mod.insts.begin() + i);
+        mod.insts.insert(mod.insts.begin() + i, repl.begin(), repl.end());
+        i += repl.size() - 1;
+    }
+    remove_variable(mod, v.var_id);
+}
+
+// remove the code which computed eliminated outputs, and merge the read-modify-write sequences of packed outputs
+static void optimize(std::vector<uint32_t>& bytecode) {
+    spvtools::Optimizer optimizer(SPV_ENV_UNIVERSAL_1_2);
+    optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass(true));
+    optimizer.RegisterPass(spvtools::CreateVectorDCEPass());
+    optimizer.RegisterPass(spvtools::CreateDeadInsertElimPass());
+    optimizer.RegisterPass(spvtools::CreateRedundancyEliminationPass());
+    optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass(true));
+    spvtools::OptimizerOptions options;
+    options.set_run_validator(false);
+    std::vector<uint32_t> result;
+    if (optimizer.Run(bytecode.data(), bytecode.size(), &result, options)) {
+        bytecode = std::move(result);
+    }
+}
+
+static ErrMsg link_program(const Input& inp, const Program& prog, SpirvBlob& vs_blob, SpirvBlob& fs_blob) {
+    SpvModule vs = SpvModule::parse(vs_blob.bytecode);
+    SpvModule fs = SpvModule::parse(fs_blob.bytecode);
+    if (!vs.valid || !fs.valid) {
+        return inp.error(prog.line_index, fmt::format("failed to parse SPIRV of program '{}' for varying linking\n", prog.name));
+    }
+    std::vector<Varying> vs_outputs = gather_varyings(vs, spv::StorageClassOutput);
+    std::vector<Varying> fs_inputs = gather_varyings(fs, spv::StorageClassInput);
+
+    // leave mismatching interfaces alone, those are reported by the reflection linking check
+    if (vs_outputs.size() != fs_inputs.size()) {
+        return ErrMsg();
+    }
+    for (const Varying& out: vs_outputs) {
+        if (nullptr == find_by_location(fs_inputs, out.location)) {
+            return ErrMsg();
+        }
+    }
+
+    // eliminate varyings which are not read by the fragment shader
+    bool vs_modified = false;
+    bool fs_modified = false;
+    std::vector<uint32_t> live_locations;
+    for (const Varying& inp_var: fs_inputs) {
+        const Varying* out_var = find_by_location(vs_outputs, inp_var.location);
+        if (!inp_var.used && remove_output_stores(vs, out_var->var_id)) {
+            remove_variable(vs, out_var->var_id);
+            remove_variable(fs, inp_var.var_id);
+            vs_modified = fs_modified = true;
+        } else {
+            live_locations.push_back(inp_var.location);
+        }
+    }
+
+    // pack compatible live varyings into vec4 slots (first-fit, largest first),
+    // varyings spanning multiple locations (arrays, matrices, structs) disable
+    // packing since location reassignment would need to know their size
+    std::vector<const Varying*> candidates;
+    bool can_relocate = true;
+    for (uint32_t loc: live_locations) {
+        const Varying* out_var = find_by_location(vs_outputs, loc);
+        const Varying* inp_var = find_by_location(fs_inputs, loc);
+        if (!out_var->single_location || !inp_var->single_location) {
+            can_relocate = false;
+        } else if ((out_var->num_components > 0) && (out_var->num_components < 4) && out_var->plain && inp_var->plain && out_var->whole_access && inp_var->whole_access) {
+            candidates.push_back(out_var);
+        }
+    }
+    if (can_relocate && (candidates.size() > 1)) {
+        std::stable_sort(candidates.begin(), candidates.end(), [](const Varying* a, const Varying* b) {
+            return a->num_components > b->num_components;
+        });
+        std::vector<PackedSlot> slots;
+        for (const Varying* v: candidates) {
+            PackedSlot* slot = nullptr;
+            for (PackedSlot& s: slots) {
+                if ((s.num_components + v->num_components) <= 4) {
+                    slot = &s;
+                    break;
+                }
+            }
+            if (nullptr == slot) {
+                slots.push_back(PackedSlot());
+                slot = &slots.back();
+            }
+            PackedSlot::Member member;
+            member.location = v->location;
+            member.component = slot->num_components;
+            member.num_components = v->num_components;
+            slot->members.push_back(member);
+            slot->num_components += v->num_components;
+        }
+        slots.erase(std::remove_if(slots.begin(), slots.end(), [](const PackedSlot& s) { return s.members.size() < 2; }), slots.end());
+        if (!slots.empty()) {
+            // assign new contiguous locations in original location order, a packed slot takes
+            // the place of its lowest-location member
+            struct Unit {
+                uint32_t location;
+                const PackedSlot* slot;
+            };
+            std::vector<Unit> units;
+            for (uint32_t loc: live_locations) {
+                const PackedSlot* owner = nullptr;
+                for (const PackedSlot& s: slots) {
+                    for (const PackedSlot::Member& m: s.members) {
+                        if (m.location == loc) {
+                            owner = &s;
+                        }
+                    }
+                }
+                if (nullptr == owner) {
+                    units.push_back({ loc, nullptr });
+                } else if (owner->min_location() == loc) {
+                    units.push_back({ loc, owner });
+                }
+            }
+            std::sort(units.begin(), units.end(), [](const Unit& a, const Unit& b) { return a.location < b.location; });
+            for (uint32_t new_loc = 0; new_loc < (uint32_t)units.size(); new_loc++) {
+                const Unit& unit = units[new_loc];
+                if (nullptr == unit.slot) {
+                    vs.set_decoration(find_by_location(vs_outputs, unit.location)->var_id, spv::DecorationLocation, new_loc);
+                    fs.set_decoration(find_by_location(fs_inputs, unit.location)->var_id, spv::DecorationLocation, new_loc);
+                } else {
+                    const uint32_t vs_packed = add_packed_variable(vs, spv::StorageClassOutput, new_loc);
+                    const uint32_t fs_packed = add_packed_variable(fs, spv::StorageClassInput, new_loc);
+                    for (const PackedSlot::Member& m: unit.slot->members) {
+                        pack_output(vs, *find_by_location(vs_outputs, m.location), vs_packed, m.component);
+                        pack_input(fs, *find_by_location(fs_inputs, m.location), fs_packed, m.component);
+                    }
+                }
+            }
+            vs_modified = fs_modified = true;
+        }
+    }
+
+    if (vs_modified) {
+        vs_blob.bytecode = vs.to_bytecode();
+        optimize(vs_blob.bytecode);
+    }
+    if (fs_modified) {
+        fs_blob.bytecode = fs.to_bytecode();
+        optimize(fs_blob.bytecode);
+    }
+    return ErrMsg();
+}
+
+ErrMsg Varyings::link(const Input& inp, Spirv& inout_spirv) {
+    for (const auto& item: inp.programs) {
+        const Program& prog = item.second;
+        // snippets which are shared between programs can't be rewritten for one specific partner stage
+        if (!prog.has_vs_fs() || !is_exclusive(inp, prog)) {
+            continue;
+        }
+        SpirvBlob* vs_blob = find_blob(inout_spirv, inp.snippet_map.at(prog.vs_name));
+        SpirvBlob* fs_blob = find_blob(inout_spirv, inp.snippet_map.at(prog.fs_name));
+        if ((nullptr == vs_blob) || (nullptr == fs_blob)) {
+            continue;
+        }
+        ErrMsg err = link_program(inp, prog, *vs_blob, *fs_blob);
+        if (err.valid()) {
+            return err;
+        }
+    }
+    return ErrMsg();
+}
+
+} // namespace shdc
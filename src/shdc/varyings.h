@@ -0,0 +1,16 @@
+#pragma once
+#include "input.h"
+#include "spirv.h"
+#include "types/errmsg.h"
+
+namespace shdc {
+
+// optional program-level link step on the SPIRV of vertex-/fragment-shader pairs:
+// removes vertex shader outputs which are not read by the fragment shader
+// (together with the code computing them), and packs float scalar/vec2/vec3
+// varyings into shared vec4 slots, both stages are rewritten consistently
+struct Varyings {
+    static ErrMsg link(const Input& inp, Spirv& inout_spirv);
+};
+
+} // namespace shdc
@@ -0,0 +1,111 @@
+/*
+    Virtual filesystem implementations.
+*/
+#include "vfs.h"
+#include "fmt/format.h"
+#include <stdio.h>
+#include <filesystem>
+
+namespace shdc {
+
+std::shared_ptr<Vfs> Vfs::disk() {
+    static std::shared_ptr<Vfs> disk_vfs = std::make_shared<DiskVfs>();
+    return disk_vfs;
+}
+
+bool DiskVfs::read(const std::string& path, std::string& out_content) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        out_content.clear();
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    const size_t file_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    out_content.resize(file_size);
+    bool ok = true;
+    if (file_size > 0) {
+        ok = fread((void*)out_content.data(), 1, file_size, f) == file_size;
+    }
+    fclose(f);
+    return ok;
+}
+
+bool DiskVfs::write(const std::string& path, const void* data, size_t num_bytes) {
+    const std::string tmp_path = fmt::format("{}.tmp", path);
+    FILE* f = fopen(tmp_path.c_str(), "wb");
+    if (!f) {
+        return false;
+    }
+    bool ok = fwrite(data, 1, num_bytes, f) == num_bytes;
+    ok = (0 == fclose(f)) && ok;
+    if (ok) {
+        std::error_code ec;
+        std::filesystem::rename(tmp_path, path, ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        ::remove(tmp_path.c_str());
+    }
+    return ok;
+}
+
+bool DiskVfs::remove(const std::string& path) {
+    return 0 == ::remove(path.c_str());
+}
+
+bool MemoryVfs::read(const std::string& path, std::string& out_content) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = content.find(path);
+    if (it == content.end()) {
+        out_content.clear();
+        return false;
+    }
+    out_content = it->second;
+    return true;
+}
+
+bool MemoryVfs::write(const std::string& path, const void* data, size_t num_bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    content[path].assign((const char*)data, num_bytes);
+    return true;
+}
+
+bool MemoryVfs::remove(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return content.erase(path) > 0;
+}
+
+std::map<std::string, std::string> MemoryVfs::files() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return content;
+}
+
+OverlayVfs::OverlayVfs(std::shared_ptr<Vfs> _base): base(_base) { };
+
+void OverlayVfs::set_file(const std::string& path, const std::string& content) {
+    overlay.write(path, content.data(), content.length());
+}
+
+void OverlayVfs::clear_file(const std::string& path) {
+    overlay.remove(path);
+}
+
+bool OverlayVfs::read(const std::string& path, std::string& out_content) {
+    if (overlay.read(path, out_content)) {
+        return true;
+    }
+    return base->read(path, out_content);
+}
+
+bool OverlayVfs::write(const std::string& path, const void* data, size_t num_bytes) {
+    overlay.remove(path);
+    return base->write(path, data, num_bytes);
+}
+
+bool OverlayVfs::remove(const std::string& path) {
+    const bool in_overlay = overlay.remove(path);
+    return base->remove(path) || in_overlay;
+}
+
+} // namespace shdc
@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace shdc {
+
+// virtual filesystem for all file reads and writes of the compiler (inputs,
+// @include files, intermediate files and outputs), so that the compiler can run
+// completely in memory, or with in-memory files overlaid over the disk content
+class Vfs {
+public:
+    virtual ~Vfs() {};
+    // returns false if the file doesn't exist
+    virtual bool read(const std::string& path, std::string& out_content) = 0;
+    // create or replace a file
+    virtual bool write(const std::string& path, const void* data, size_t num_bytes) = 0;
+    virtual bool remove(const std::string& path) = 0;
+    // true if paths are disk paths which can be streamed to or passed to external tools
+    virtual bool is_native() const { return false; };
+    // the shared disk filesystem
+    static std::shared_ptr<Vfs> disk();
+};
+
+// files on disk, writes go to a temp file which is renamed to the actual
+// file, so that readers never see a partially written file
+class DiskVfs: public Vfs {
+public:
+    virtual bool read(const std::string& path, std::string& out_content);
+    virtual bool write(const std::string& path, const void* data, size_t num_bytes);
+    virtual bool remove(const std::string& path);
+    virtual bool is_native() const { return true; };
+};
+
+// files in memory only, thread-safe since code generators run in parallel
+class MemoryVfs: public Vfs {
+public:
+    virtual bool read(const std::string& path, std::string& out_content);
+    virtual bool write(const std::string& path, const void* data, size_t num_bytes);
+    virtual bool remove(const std::string& path);
+    std::map<std::string, std::string> files() const;
+private:
+    mutable std::mutex mutex;
+    std::map<std::string, std::string> content;  // path => file content
+};
+
+// in-memory files (e.g. unsaved editor buffers) which override files of a base
+// filesystem on read, writes go to the base filesystem and drop an overlay file
+class OverlayVfs: public Vfs {
+public:
+    OverlayVfs(std::shared_ptr<Vfs> base);
+    void set_file(const std::string& path, const std::string& content);
+    void clear_file(const std::string& path);
+    virtual bool read(const std::string& path, std::string& out_content);
+    virtual bool write(const std::string& path, const void* data, size_t num_bytes);
+    virtual bool remove(const std::string& path);
+    virtual bool is_native() const { return base->is_native(); };
+private:
+    std::shared_ptr<Vfs> base;
+    MemoryVfs overlay;
+};
+
+} // namespace shdc
@@ -0,0 +1,395 @@
+/*
+    distributed compilation over --worker processes (see worker.h)
+
+    Each message is a little-endian u32 byte count followed by the
+    serialized job or result, a coordinator sends one job at a time
+    and waits for its result.
+*/
+#include "worker.h"
+#include "args.h"
+#include "spirv.h"
+#include "bytecode.h"
+#include "serialize.h"
+#include "socket.h"
+#include "fmt/format.h"
+#include <stdlib.h>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+namespace shdc {
+
+// bump when the job or result layout changes
+static const uint32_t WorkerJobTag = 0x534A4231;        // 'SJB1'
+static const uint32_t WorkerResultTag = 0x53524231;     // 'SRB1'
+static const uint32_t MaxMessageSize = 256 * 1024 * 1024;
+static const int ConnectTimeout = 1000;
+// generous since a worker may be busy with the jobs of other coordinators
+static const int JobTimeout = 60 * 1000;
+// how often a job is tried on different workers before it's compiled locally
+static const int MaxAttempts = 3;
+
+// NOTE: header and payload in one send, a separate small header write
+// would stall on Nagle's algorithm and delayed ACKs for each message
+static bool send_message(Socket& sock, const std::string& payload) {
+    Serializer msg;
+    msg.bytes(payload.data(), payload.length());
+    return sock.send_all(msg.data);
+}
+
+static bool recv_message(Socket& sock, std::string& out_payload) {
+    uint8_t header[4];
+    if (!sock.recv_all(header, sizeof(header))) {
+        return false;
+    }
+    const uint32_t num_bytes = header[0] | (header[1] << 8) | (header[2] << 16) | ((uint32_t)header[3] << 24);
+    if (num_bytes > MaxMessageSize) {
+        return false;
+    }
+    out_payload.resize(num_bytes);
+    return (num_bytes == 0) || sock.recv_all(&out_payload[0], num_bytes);
+}
+
+static std::string encode_job(const WorkerJob& job) {
+    Serializer writer;
+    writer.u32(WorkerJobTag);
+    writer.i32((int)job.type);
+    writer.i32((int)job.slang);
+    writer.i32(job.snippet_type);
+    writer.str(job.source);
+    writer.i32(job.linenr_offset);
+    writer.str(job.entry_point);
+    return writer.data;
+}
+
+static bool decode_job(const std::string& data, WorkerJob& out_job) {
+    Deserializer reader(data);
+    if (reader.u32() != WorkerJobTag) {
+        return false;
+    }
+    out_job.type = (WorkerJob::Type)reader.i32();
+    const int slang = reader.i32();
+    out_job.snippet_type = reader.i32();
+    out_job.source = reader.str();
+    out_job.linenr_offset = reader.i32();
+    out_job.entry_point = reader.str();
+    if ((slang < 0) || (slang >= Slang::Num)) {
+        return false;
+    }
+    out_job.slang = (Slang::Enum)slang;
+    return reader.done();
+}
+
+static std::string encode_result(const WorkerResult& result) {
+    Serializer writer;
+    writer.u32(WorkerResultTag);
+    writer.i32(result.valid ? 1 : 0);
+    writer.bytes(result.data.data(), result.data.length());
+    return writer.data;
+}
+
+static bool decode_result(const std::string& data, WorkerResult& out_result) {
+    Deserializer reader(data);
+    if (reader.u32() != WorkerResultTag) {
+        return false;
+    }
+    out_result.valid = reader.i32() != 0;
+    out_result.data = reader.bytes();
+    return reader.done();
+}
+
+WorkerAddress WorkerAddress::parse(const std::string& str) {
+    WorkerAddress res;
+    const size_t colon = str.rfind(':');
+    if ((colon == std::string::npos) || (colon == 0)) {
+        return res;
+    }
+    res.host = str.substr(0, colon);
+    res.port = atoi(str.substr(colon + 1).c_str());
+    res.valid = (res.port > 0) && (res.port < 65536);
+    return res;
+}
+
+static WorkerResult execute(const Args& args, const WorkerJob& job, int conn_index) {
+    WorkerResult res;
+    Serializer writer;
+    if (job.type == WorkerJob::SPIRV) {
+        SpirvBlob blob(0);
+        if (Spirv::compile_job(job, blob)) {
+            writer.spirv_blob(blob);
+            res.valid = true;
+        }
+    } else if (job.type == WorkerJob::BYTECODE) {
+        BytecodeBlob blob;
+        if (Bytecode::compile_job(args, job, conn_index, blob)) {
+            writer.bytecode_blob(blob);
+            res.valid = true;
+        }
+    }
+    res.data = std::move(writer.data);
+    return res;
+}
+
+int Worker::run(const Args& args) {
+    std::string error;
+    std::unique_ptr<Socket> listener = Socket::listen(args.worker_port, error);
+    if (!listener) {
+        fmt::print(stderr, "sokol-shdc: {}\n", error);
+        return 10;
+    }
+    fmt::print(stderr, "sokol-shdc: worker listening on port {}\n", args.worker_port);
+    // the connection slots in use, a new connection takes the lowest free slot
+    std::mutex conn_mutex;
+    std::vector<bool> conn_slots;
+    while (true) {
+        std::shared_ptr<Socket> conn = listener->accept();
+        if (!conn) {
+            continue;
+        }
+        int conn_index = 0;
+        {
+            std::lock_guard<std::mutex> lock(conn_mutex);
+            while ((conn_index < (int)conn_slots.size()) && conn_slots[conn_index]) {
+                conn_index++;
+            }
+            if (conn_index == (int)conn_slots.size()) {
+                conn_slots.push_back(true);
+            } else {
+                conn_slots[conn_index] = true;
+            }
+        }
+        // each connection gets its own thread, otherwise the coordinators of a parallel
+        // build would wait in the listen backlog until they give up on a healthy worker
+        std::thread([&args, &conn_mutex, &conn_slots, conn, conn_index]() {
+            // don't get stuck on a coordinator which went away without closing the connection
+            conn->set_timeout(JobTimeout);
+            std::string request;
+            while (recv_message(*conn, request)) {
+                WorkerJob job;
+                WorkerResult result;
+                if (decode_job(request, job)) {
+                    result = execute(args, job, conn_index);
+                }
+                if (!send_message(*conn, encode_result(result))) {
+                    break;
+                }
+            }
+            std::lock_guard<std::mutex> lock(conn_mutex);
+            conn_slots[conn_index] = false;
+        }).detach();
+    }
+    return 0;
+}
+
+WorkerPool::WorkerPool(const Args& args) {
+    for (const std::string& addr: args.workers) {
+        Slot slot;
+        slot.address = WorkerAddress::parse(addr);
+        slots.push_back(slot);
+    }
+    timings = JobTimings::load(args.cache_dir);
+    trace = args.trace;
+}
+
+bool WorkerPool::next_job(int slot_index, int& out_job_index) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        Slot& slot = slots[slot_index];
+        if (slot.lost) {
+            return false;
+        }
+        if (!slot.queue.empty()) {
+            out_job_index = slot.queue.front();
+            slot.queue.pop_front();
+            num_in_flight++;
+            return true;
+        }
+        int victim = -1;
+        for (int i = 0; i < (int)slots.size(); i++) {
+            if ((i != slot_index) && !slots[i].queue.empty()) {
+                if ((victim == -1) || (slots[i].queue.size() > slots[victim].queue.size())) {
+                    victim = i;
+                }
+            }
+        }
+        if (victim != -1) {
+            out_job_index = slots[victim].queue.back();
+            slots[victim].queue.pop_back();
+            slot.num_stolen++;
+            num_in_flight++;
+            return true;
+        }
+        // all queues are empty, but a job which is still running may be put back by a lost worker
+        if (num_in_flight == 0) {
+            return false;
+        }
+        cond.wait(lock);
+    }
+}
+
+void WorkerPool::finish_job(int slot_index, int job_index, WorkerResult&& result, std::vector<WorkerResult>& results) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!result.valid) {
+        num_invalid++;
+    }
+    result.worker = slot_index;
+    results[job_index] = std::move(result);
+    slots[slot_index].num_jobs++;
+    num_in_flight--;
+    cond.notify_all();
+}
+
+void WorkerPool::lose_worker(int slot_index, int job_index, bool job_sent, const std::string& reason) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Slot& slot = slots[slot_index];
+    slot.lost = true;
+    fmt::print(stderr, "sokol-shdc: lost worker {}:{} ({}), continuing without it\n", slot.address.host, slot.address.port, reason);
+    // the remaining jobs in the queue of a lost worker are stolen by the others, a job
+    // only counts as attempted if it was sent (it may have crashed the worker)
+    if (!job_sent) {
+        slot.queue.push_front(job_index);
+    } else if (++attempts[job_index] < MaxAttempts) {
+        slot.queue.push_front(job_index);
+        num_retries++;
+    } else {
+        num_abandoned++;
+    }
+    num_in_flight--;
+    cond.notify_all();
+}
+
+void WorkerPool::work(int slot_index, const std::vector<WorkerJob>& jobs, std::vector<WorkerResult>& results) {
+    const WorkerAddress& addr = slots[slot_index].address;
+    std::unique_ptr<Socket> conn;
+    int job_index = 0;
+    while (next_job(slot_index, job_index)) {
+        if (!conn) {
+            std::string error;
+            conn = Socket::connect(addr.host, addr.port, ConnectTimeout, error);
+            if (!conn) {
+                lose_worker(slot_index, job_index, false, error);
+                return;
+            }
+            conn->set_timeout(JobTimeout);
+        }
+        const auto start = std::chrono::steady_clock::now();
+        std::string response;
+        WorkerResult result;
+        if (!send_message(*conn, encode_job(jobs[job_index])) || !recv_message(*conn, response) || !decode_result(response, result)) {
+            lose_worker(slot_index, job_index, true, "connection closed or timed out");
+            return;
+        }
+        result.duration_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        finish_job(slot_index, job_index, std::move(result), results);
+    }
+}
+
+std::vector<WorkerResult> WorkerPool::run(const std::vector<WorkerJob>& jobs) {
+    std::vector<WorkerResult> results(jobs.size());
+    std::vector<int> active;
+    for (int i = 0; i < (int)slots.size(); i++) {
+        if (!slots[i].lost) {
+            active.push_back(i);
+        }
+    }
+    if (jobs.empty() || active.empty()) {
+        return results;
+    }
+    attempts.assign(jobs.size(), 0);
+    int num_known = 0;
+    const std::vector<double> costs = estimate_costs(jobs, num_known);
+    const std::vector<int> order = Schedule::lpt_order(costs);
+    const std::vector<int> assignment = Schedule::assign(costs, order, (int)active.size());
+    for (int job_index: order) {
+        slots[active[assignment[job_index]]].queue.push_back(job_index);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int slot_index: active) {
+        threads.emplace_back([this, slot_index, &jobs, &results]() {
+            work(slot_index, jobs, results);
+        });
+    }
+    for (std::thread& thread: threads) {
+        thread.join();
+    }
+    const double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    // failed jobs stop early, so only successful jobs go into the timing history
+    for (size_t i = 0; i < jobs.size(); i++) {
+        if (results[i].valid && !jobs[i].name.empty()) {
+            timings.update(jobs[i].name, results[i].duration_ms);
+        }
+    }
+    timings.save();
+    if (trace) {
+        print_trace(jobs, results, costs, order, (int)active.size(), num_known, wall_ms);
+    }
+    // jobs left over when all workers are lost are compiled locally
+    for (Slot& slot: slots) {
+        num_abandoned += (int)slot.queue.size();
+        slot.queue.clear();
+    }
+    return results;
+}
+
+// jobs without history get the average of the known jobs, and if there's no history at
+// all, the source size is used as relative cost (which still puts big shaders first)
+std::vector<double> WorkerPool::estimate_costs(const std::vector<WorkerJob>& jobs, int& out_num_known) const {
+    std::vector<double> costs(jobs.size(), 0.0);
+    std::vector<bool> known(jobs.size(), false);
+    double sum = 0.0;
+    out_num_known = 0;
+    for (size_t i = 0; i < jobs.size(); i++) {
+        if (timings.find(jobs[i].name, costs[i])) {
+            known[i] = true;
+            sum += costs[i];
+            out_num_known++;
+        }
+    }
+    for (size_t i = 0; i < jobs.size(); i++) {
+        if (!known[i]) {
+            costs[i] = (out_num_known > 0) ? (sum / out_num_known) : (double)jobs[i].source.length();
+        }
+    }
+    return costs;
+}
+
+// compares the measured makespan with list schedules simulated from the measured job times
+void WorkerPool::print_trace(const std::vector<WorkerJob>& jobs, const std::vector<WorkerResult>& results, const std::vector<double>& costs, const std::vector<int>& order, int num_workers, int num_known, double wall_ms) const {
+    const char* label = (jobs[0].type == WorkerJob::SPIRV) ? "spirv" : "bytecode";
+    fmt::print(stderr, "sokol-shdc: trace: {}: {} jobs on {} workers ({} with timing history):\n", label, jobs.size(), num_workers, num_known);
+    std::vector<double> durations;
+    std::vector<int> in_order;
+    double sum = 0.0;
+    double longest = 0.0;
+    for (int job_index: order) {
+        const WorkerResult& res = results[job_index];
+        const std::string worker = (res.worker >= 0) ? fmt::format("{}:{}", slots[res.worker].address.host, slots[res.worker].address.port) : "-";
+        // without any history, the estimates are source sizes instead of milliseconds
+        const std::string estimate = (num_known > 0) ? fmt::format(" (estimate {:.1f} ms)", costs[job_index]) : "";
+        fmt::print(stderr, "  {}: {:.1f} ms{} on {}{}\n", jobs[job_index].name, res.duration_ms, estimate, worker, res.valid ? "" : " (failed)");
+    }
+    for (size_t i = 0; i < jobs.size(); i++) {
+        durations.push_back(results[i].duration_ms);
+        in_order.push_back((int)i);
+        sum += results[i].duration_ms;
+        longest = std::max(longest, results[i].duration_ms);
+    }
+    const double in_order_ms = Schedule::makespan(durations, in_order, num_workers);
+    const double scheduled_ms = Schedule::makespan(durations, order, num_workers);
+    const double best_ms = Schedule::makespan(durations, Schedule::lpt_order(durations), num_workers);
+    const double bound_ms = std::max(longest, sum / num_workers);
+    fmt::print(stderr, "  makespan: {:.1f} ms, simulated from job times: in order {:.1f} ms, scheduled {:.1f} ms ({:+.1f}%), LPT with exact times {:.1f} ms, lower bound {:.1f} ms\n\n",
+        wall_ms, in_order_ms, scheduled_ms, (in_order_ms > 0.0) ? (100.0 * (scheduled_ms - in_order_ms) / in_order_ms) : 0.0, best_ms, bound_ms);
+}
+
+void WorkerPool::dump_debug() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    fmt::print(stderr, "WorkerPool:\n");
+    for (const Slot& slot: slots) {
+        fmt::print(stderr, "  {}:{}: {} jobs, {} stolen{}\n", slot.address.host, slot.address.port, slot.num_jobs, slot.num_stolen, slot.lost ? " (lost)" : "");
+    }
+    fmt::print(stderr, "  retries: {}, given up: {}, results with messages: {}\n\n", num_retries, num_abandoned, num_invalid);
+}
+
+} // namespace shdc
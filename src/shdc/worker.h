@@ -0,0 +1,95 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include "types/slang.h"
+#include "schedule.h"
+
+namespace shdc {
+
+struct Args;
+
+// a single compilation which can be shipped to a --worker process, either the
+// merged source of one snippet to SPIRV, or one cross-translated source to bytecode
+struct WorkerJob {
+    enum Type {
+        SPIRV = 1,
+        BYTECODE = 2,
+    };
+    Type type = SPIRV;
+    Slang::Enum slang = Slang::GLSL410;
+    int snippet_type = 0;           // Snippet::Type (VS, FS or CS)
+    std::string source;
+    int linenr_offset = 0;          // SPIRV only: number of lines injected in front of the snippet source
+    std::string entry_point;        // bytecode only
+    std::string name;               // for the timing history and --trace, not sent to workers
+};
+
+// the serialized SpirvBlob or BytecodeBlob of a job, results are only valid if the
+// job compiled without any errors or warnings, everything else is compiled again
+// on the coordinator to get messages with proper source locations
+struct WorkerResult {
+    bool valid = false;
+    std::string data;
+    int worker = -1;                // index into the --workers list, -1 if the job didn't run
+    double duration_ms = 0.0;       // including the network round trip
+};
+
+struct WorkerAddress {
+    bool valid = false;
+    std::string host;
+    int port = 0;
+
+    // host:port
+    static WorkerAddress parse(const std::string& str);
+};
+
+// the --worker mode, serves each coordinator connection on its own thread
+struct Worker {
+    static int run(const Args& args);
+};
+
+// runs jobs on the --workers processes of a coordinator with one connection per
+// worker, each worker starts with its own queue of jobs and steals from the back
+// of the longest other queue when running out of work, jobs of a lost worker are
+// retried on the remaining workers, lost workers are not used again
+//
+// the initial queues are filled longest-processing-time-first from the job timings
+// of earlier runs, so that long jobs don't end up running alone at the end, and the
+// short jobs at the back of the queues are the ones which are stolen
+class WorkerPool {
+public:
+    WorkerPool(const Args& args);
+    // returns the results in job order, jobs which couldn't be run have invalid results
+    std::vector<WorkerResult> run(const std::vector<WorkerJob>& jobs);
+    void dump_debug() const;
+private:
+    struct Slot {
+        WorkerAddress address;
+        std::deque<int> queue;      // job indices
+        bool lost = false;
+        int num_jobs = 0;
+        int num_stolen = 0;
+    };
+    bool next_job(int slot_index, int& out_job_index);
+    void finish_job(int slot_index, int job_index, WorkerResult&& result, std::vector<WorkerResult>& results);
+    void lose_worker(int slot_index, int job_index, bool job_sent, const std::string& reason);
+    void work(int slot_index, const std::vector<WorkerJob>& jobs, std::vector<WorkerResult>& results);
+    std::vector<double> estimate_costs(const std::vector<WorkerJob>& jobs, int& out_num_known) const;
+    void print_trace(const std::vector<WorkerJob>& jobs, const std::vector<WorkerResult>& results, const std::vector<double>& costs, const std::vector<int>& order, int num_workers, int num_known, double wall_ms) const;
+
+    mutable std::mutex mutex;
+    std::condition_variable cond;
+    std::vector<Slot> slots;
+    std::vector<int> attempts;      // per job index
+    JobTimings timings;
+    bool trace = false;
+    int num_in_flight = 0;
+    int num_retries = 0;
+    int num_abandoned = 0;
+    int num_invalid = 0;
+};
+
+} // namespace shdc